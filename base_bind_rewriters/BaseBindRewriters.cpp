@@ -8,6 +8,8 @@
 #include <memory>
 #include <string>
 
+#include "BinaryEdits.h"
+#include "PrefixHeaderPch.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ParentMap.h"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
@@ -594,6 +596,16 @@ The default is remove_unneeded_passed.
     llvm::cl::init("remove_unneeded_passed"),
     llvm::cl::cat(rewriter_category));
 
+llvm::cl::opt<bool> binary_edits_option(
+    "binary-edits",
+    llvm::cl::desc("Emit edits in the compact binary format understood by "
+                   "extract_edits.py and apply_edits.py"),
+    llvm::cl::init(false),
+    llvm::cl::cat(rewriter_category));
+
+raw_ptr_plugin::PrefixHeaderPch::Options prefix_header_options(
+    rewriter_category);
+
 }  // namespace.
 
 int main(int argc, const char* argv[]) {
@@ -602,6 +614,11 @@ int main(int argc, const char* argv[]) {
   CommonOptionsParser options(argc, argv, rewriter_category);
   clang::tooling::ClangTool tool(options.getCompilations(),
                                  options.getSourcePathList());
+  std::unique_ptr<raw_ptr_plugin::PrefixHeaderPch> prefix_header_pch =
+      raw_ptr_plugin::PrefixHeaderPch::Create(prefix_header_options);
+  if (prefix_header_pch) {
+    tool.appendArgumentsAdjuster(prefix_header_pch->GetArgumentsAdjuster());
+  }
 
   MatchFinder match_finder;
   std::vector<clang::tooling::Replacement> replacements;
@@ -636,6 +653,16 @@ int main(int argc, const char* argv[]) {
   if (replacements.empty())
     return 0;
 
+  if (binary_edits_option) {
+    raw_ptr_plugin::BinaryEditsWriter binary_edits;
+    for (const auto& r : replacements) {
+      binary_edits.AddReplacement(r.getFilePath(), r.getOffset(), r.getLength(),
+                                  r.getReplacementText());
+    }
+    binary_edits.Emit(llvm::outs());
+    return 0;
+  }
+
   // Serialization format is documented in tools/clang/scripts/run_tool.py
   llvm::outs() << "==== BEGIN EDITS ====\n";
   for (const auto& r : replacements) {
@@ -17,6 +17,7 @@
 #include "clang/ASTMatchers/ASTMatchFinder.h"
 #include "clang/ASTMatchers/ASTMatchers.h"
 #include "clang/ASTMatchers/ASTMatchersMacros.h"
+#include "llvm/Support/TimeProfiler.h"
 
 using namespace clang::ast_matchers;
 
@@ -79,6 +80,8 @@ class UniquePtrGarbageCollectedMatcher : public MatchFinder::MatchCallback {
   }
 
   void run(const MatchFinder::MatchResult& result) override {
+    llvm::TimeTraceScope TimeScope(
+        "BadPatternFinder: UniquePtrGarbageCollectedMatcher");
     auto* bad_use = result.Nodes.getNodeAs<clang::Expr>("bad");
     auto* bad_function = result.Nodes.getNodeAs<clang::FunctionDecl>("badfunc");
     auto* gc_type = result.Nodes.getNodeAs<clang::CXXRecordDecl>("gctype");
@@ -128,6 +131,8 @@ class OptionalOrRawPtrToGCedMatcher : public MatchFinder::MatchCallback {
   }
 
   void run(const MatchFinder::MatchResult& result) override {
+    llvm::TimeTraceScope TimeScope(
+        "BadPatternFinder: OptionalOrRawPtrToGCedMatcher");
     auto* type = result.Nodes.getNodeAs<clang::CXXRecordDecl>("type");
     bool is_optional = (type->getName() == "optional");
     auto* arg_type = result.Nodes.getNodeAs<clang::CXXRecordDecl>("gctype");
@@ -193,6 +198,7 @@ class OptionalMemberMatcher : public MatchFinder::MatchCallback {
   }
 
   void run(const MatchFinder::MatchResult& result) override {
+    llvm::TimeTraceScope TimeScope("BadPatternFinder: OptionalMemberMatcher");
     auto* type = result.Nodes.getNodeAs<clang::CXXRecordDecl>("type");
     auto* member = result.Nodes.getNodeAs<clang::CXXRecordDecl>("member");
     if (auto* bad_decl = result.Nodes.getNodeAs<clang::Decl>("bad_decl")) {
@@ -269,6 +275,8 @@ class CollectionOfGarbageCollectedMatcher : public MatchFinder::MatchCallback {
   }
 
   void run(const MatchFinder::MatchResult& result) override {
+    llvm::TimeTraceScope TimeScope(
+        "BadPatternFinder: CollectionOfGarbageCollectedMatcher");
     auto* collection =
         result.Nodes.getNodeAs<clang::CXXRecordDecl>("collection");
     auto* gc_type = result.Nodes.getNodeAs<clang::CXXRecordDecl>("gctype");
@@ -366,6 +374,8 @@ class VariantGarbageCollectedMatcher : public MatchFinder::MatchCallback {
   }
 
   void run(const MatchFinder::MatchResult& result) override {
+    llvm::TimeTraceScope TimeScope(
+        "BadPatternFinder: VariantGarbageCollectedMatcher");
     auto* bad_use = result.Nodes.getNodeAs<clang::Expr>("bad");
     auto* variant = result.Nodes.getNodeAs<clang::CXXRecordDecl>("variant");
     auto* gc_type = result.Nodes.getNodeAs<clang::CXXRecordDecl>("gctype");
@@ -388,6 +398,7 @@ class MemberOnStackMatcher : public MatchFinder::MatchCallback {
   }
 
   void run(const MatchFinder::MatchResult& result) override {
+    llvm::TimeTraceScope TimeScope("BadPatternFinder: MemberOnStackMatcher");
     auto* member = result.Nodes.getNodeAs<clang::VarDecl>("var");
     if (Config::IsIgnoreAnnotated(member)) {
       return;
@@ -423,6 +434,7 @@ class WeakPtrToGCedMatcher : public MatchFinder::MatchCallback {
   }
 
   void run(const MatchFinder::MatchResult& result) override {
+    llvm::TimeTraceScope TimeScope("BadPatternFinder: WeakPtrToGCedMatcher");
     auto* decl = result.Nodes.getNodeAs<clang::Decl>("bad_decl");
     if (Config::IsIgnoreAnnotated(decl)) {
       return;
@@ -509,6 +521,7 @@ class PaddingInGCedMatcher : public MatchFinder::MatchCallback {
   }
 
   void run(const MatchFinder::MatchResult& result) override {
+    llvm::TimeTraceScope TimeScope("BadPatternFinder: PaddingInGCedMatcher");
     auto* class_decl = result.Nodes.getNodeAs<clang::RecordDecl>("record");
     if (class_decl->isDependentType() || class_decl->isUnion()) {
       return;
@@ -599,6 +612,7 @@ class GCedVarOrField : public MatchFinder::MatchCallback {
   }
 
   void run(const MatchFinder::MatchResult& result) override {
+    llvm::TimeTraceScope TimeScope("BadPatternFinder: GCedVarOrField");
     const auto* gctype = result.Nodes.getNodeAs<clang::CXXRecordDecl>("gctype");
     assert(gctype);
     if (Config::IsGCCollection(gctype->getName())) {
@@ -626,46 +640,59 @@ class GCedVarOrField : public MatchFinder::MatchCallback {
 
 }  // namespace
 
-void FindBadPatterns(clang::ASTContext& ast_context,
-                     DiagnosticsReporter& diagnostics,
-                     RecordCache& record_cache,
-                     const BlinkGCPluginOptions& options) {
-  MatchFinder match_finder;
-
-  UniquePtrGarbageCollectedMatcher unique_ptr_gc(diagnostics);
-  unique_ptr_gc.Register(match_finder);
-
-  OptionalOrRawPtrToGCedMatcher optional_or_rawptr_gc(diagnostics,
-                                                      record_cache);
-  optional_or_rawptr_gc.Register(match_finder);
+struct BadPatternFinder::Matchers {
+  Matchers(clang::ASTContext& ast_context,
+           DiagnosticsReporter& diagnostics,
+           RecordCache& record_cache,
+           const BlinkGCPluginOptions& options)
+      : options(options),
+        unique_ptr_gc(diagnostics),
+        optional_or_rawptr_gc(diagnostics, record_cache),
+        collection_of_gc(diagnostics, record_cache),
+        variant_gc(diagnostics),
+        member_on_stack(diagnostics),
+        padding_in_gced(ast_context, diagnostics),
+        weak_ptr_to_gced(diagnostics),
+        gced_var_or_field(diagnostics),
+        optional_member(diagnostics, record_cache) {}
+
+  const BlinkGCPluginOptions& options;
+  UniquePtrGarbageCollectedMatcher unique_ptr_gc;
+  OptionalOrRawPtrToGCedMatcher optional_or_rawptr_gc;
+  CollectionOfGarbageCollectedMatcher collection_of_gc;
+  VariantGarbageCollectedMatcher variant_gc;
+  MemberOnStackMatcher member_on_stack;
+  PaddingInGCedMatcher padding_in_gced;
+  WeakPtrToGCedMatcher weak_ptr_to_gced;
+  GCedVarOrField gced_var_or_field;
+  OptionalMemberMatcher optional_member;
+};
 
-  CollectionOfGarbageCollectedMatcher collection_of_gc(diagnostics,
-                                                       record_cache);
-  if (options.enable_off_heap_collections_of_gced_check) {
-    collection_of_gc.Register(match_finder);
+BadPatternFinder::BadPatternFinder(clang::ASTContext& ast_context,
+                                   DiagnosticsReporter& diagnostics,
+                                   RecordCache& record_cache,
+                                   const BlinkGCPluginOptions& options)
+    : matchers_(std::make_unique<Matchers>(ast_context,
+                                           diagnostics,
+                                           record_cache,
+                                           options)) {}
+
+BadPatternFinder::~BadPatternFinder() = default;
+
+void BadPatternFinder::Register(MatchFinder& match_finder) {
+  matchers_->unique_ptr_gc.Register(match_finder);
+  matchers_->optional_or_rawptr_gc.Register(match_finder);
+  if (matchers_->options.enable_off_heap_collections_of_gced_check) {
+    matchers_->collection_of_gc.Register(match_finder);
   }
-
-  VariantGarbageCollectedMatcher variant_gc(diagnostics);
-  variant_gc.Register(match_finder);
-
-  MemberOnStackMatcher member_on_stack(diagnostics);
-  if (options.enable_members_on_stack_check) {
-    member_on_stack.Register(match_finder);
+  matchers_->variant_gc.Register(match_finder);
+  if (matchers_->options.enable_members_on_stack_check) {
+    matchers_->member_on_stack.Register(match_finder);
   }
-
-  PaddingInGCedMatcher padding_in_gced(ast_context, diagnostics);
-  if (options.enable_extra_padding_check) {
-    padding_in_gced.Register(match_finder);
+  if (matchers_->options.enable_extra_padding_check) {
+    matchers_->padding_in_gced.Register(match_finder);
   }
-
-  WeakPtrToGCedMatcher weak_ptr_to_gced(diagnostics);
-  weak_ptr_to_gced.Register(match_finder);
-
-  GCedVarOrField gced_var_or_field(diagnostics);
-  gced_var_or_field.Register(match_finder);
-
-  OptionalMemberMatcher optional_member(diagnostics, record_cache);
-  optional_member.Register(match_finder);
-
-  match_finder.matchAST(ast_context);
+  matchers_->weak_ptr_to_gced.Register(match_finder);
+  matchers_->gced_var_or_field.Register(match_finder);
+  matchers_->optional_member.Register(match_finder);
 }
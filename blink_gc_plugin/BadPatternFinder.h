@@ -2,17 +2,43 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#ifndef TOOLS_BLINK_GC_PLUGIN_BAD_PATTERN_FINDER_H_
+#define TOOLS_BLINK_GC_PLUGIN_BAD_PATTERN_FINDER_H_
+
+#include <memory>
+
 struct BlinkGCPluginOptions;
 class DiagnosticsReporter;
 class RecordCache;
 
 namespace clang {
 class ASTContext;
+namespace ast_matchers {
+class MatchFinder;
+}  // namespace ast_matchers
 }  // namespace clang
 
 // Detects and reports use of banned patterns, such as applying
 // std::make_unique to a garbage-collected type.
-void FindBadPatterns(clang::ASTContext& ast_context,
-                     DiagnosticsReporter&,
-                     RecordCache& record_cache,
-                     const BlinkGCPluginOptions&);
+//
+// Register() adds the matchers to a MatchFinder, which may be shared with
+// other plugins; the BadPatternFinder must outlive its matchAST() call.
+class BadPatternFinder {
+ public:
+  BadPatternFinder(clang::ASTContext& ast_context,
+                   DiagnosticsReporter& diagnostics,
+                   RecordCache& record_cache,
+                   const BlinkGCPluginOptions& options);
+  ~BadPatternFinder();
+
+  BadPatternFinder(const BadPatternFinder&) = delete;
+  BadPatternFinder& operator=(const BadPatternFinder&) = delete;
+
+  void Register(clang::ast_matchers::MatchFinder& match_finder);
+
+ private:
+  struct Matchers;
+  std::unique_ptr<Matchers> matchers_;
+};
+
+#endif  // TOOLS_BLINK_GC_PLUGIN_BAD_PATTERN_FINDER_H_
@@ -37,6 +37,9 @@ class BlinkGCPluginAction : public PluginASTAction {
     for (const auto& arg : args) {
       if (arg == "dump-graph") {
         options_.dump_graph = true;
+      } else if (arg == "dump-graph-binary") {
+        options_.dump_graph = true;
+        options_.dump_graph_binary = true;
       } else if (arg == "enable-persistent-in-unique-ptr-check") {
         options_.enable_persistent_in_unique_ptr_check = true;
       } else if (arg == "enable-members-on-stack-check") {
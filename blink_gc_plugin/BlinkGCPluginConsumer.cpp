@@ -102,19 +102,42 @@ BlinkGCPluginConsumer::BlinkGCPluginConsumer(
   options_.ignored_directories.push_back("v8/src/heap/cppgc-js/");
 }
 
+void BlinkGCPluginConsumer::Initialize(ASTContext& context) {
+  shared_match_finder_ = chrome_plugin_host::SharedMatchFinder::Join(context);
+}
+
 void BlinkGCPluginConsumer::HandleTranslationUnit(ASTContext& context) {
   llvm::TimeTraceScope TimeScope(
       "BlinkGCPluginConsumer::HandleTranslationUnit");
-  // Don't run the plugin if the compilation unit is already invalid.
-  if (reporter_.hasErrorOccurred())
+  // Don't run the plugin if the compilation unit is already invalid. The
+  // shared matchers of other plugins still need to run.
+  if (reporter_.hasErrorOccurred()) {
+    shared_match_finder_->Run();
     return;
+  }
 
   ParseFunctionTemplates(context.getTranslationUnitDecl());
 
   CollectVisitor visitor;
   visitor.TraverseDecl(context.getTranslationUnitDecl());
 
-  if (options_.dump_graph) {
+  if (options_.dump_graph_binary) {
+    SmallString<128> OutputFile(instance_.getFrontendOpts().OutputFile);
+    llvm::sys::path::replace_extension(OutputFile, "graph.bin");
+    graph_file_ = instance_.createOutputFile(
+        OutputFile,                              // OutputPath
+        true,                                    // Binary
+        true,                                    // RemoveFileOnSignal
+        false,                                   // UseTemporary
+        false);                                  // CreateMissingDirectories
+    if (graph_file_) {
+      graph_writer_ = std::make_unique<graph_file::Writer>();
+    } else {
+      llvm::errs()
+          << "[blink-gc] "
+          << "Failed to create an output file for the object graph.\n";
+    }
+  } else if (options_.dump_graph) {
     std::error_code err;
     SmallString<128> OutputFile(instance_.getFrontendOpts().OutputFile);
     llvm::sys::path::replace_extension(OutputFile, "graph.json");
@@ -134,19 +157,35 @@ void BlinkGCPluginConsumer::HandleTranslationUnit(ASTContext& context) {
     }
   }
 
-  for (const auto& record : visitor.record_decls())
-    CheckRecord(cache_.Lookup(record));
+  {
+    llvm::TimeTraceScope TimeScope(
+        "CheckRecord in BlinkGCPluginConsumer::HandleTranslationUnit");
+    for (const auto& record : visitor.record_decls())
+      CheckRecord(cache_.Lookup(record));
+  }
 
-  for (const auto& method : visitor.trace_decls())
-    CheckTracingMethod(method);
+  {
+    llvm::TimeTraceScope TimeScope(
+        "CheckTracingMethod in BlinkGCPluginConsumer::HandleTranslationUnit");
+    for (const auto& method : visitor.trace_decls())
+      CheckTracingMethod(method);
+  }
 
   if (json_) {
     json_->CloseList();
     delete json_;
     json_ = 0;
   }
+  if (graph_writer_) {
+    graph_writer_->Finish(*graph_file_);
+    graph_writer_.reset();
+    graph_file_.reset();
+  }
 
-  FindBadPatterns(context, reporter_, cache_, options_);
+  bad_pattern_finder_ = std::make_unique<BadPatternFinder>(
+      context, reporter_, cache_, options_);
+  bad_pattern_finder_->Register(shared_match_finder_->finder());
+  shared_match_finder_->Run();
 }
 
 void BlinkGCPluginConsumer::ParseFunctionTemplates(TranslationUnitDecl* decl) {
@@ -535,38 +574,33 @@ void BlinkGCPluginConsumer::CheckTraceMethod(
 }
 
 void BlinkGCPluginConsumer::DumpClass(RecordInfo* info) {
-  if (!json_)
+  if (!json_ && !graph_writer_)
     return;
 
-  json_->OpenObject();
-  json_->Write("name", info->record()->getQualifiedNameAsString());
-  json_->Write("loc", GetLocString(info->record()->getBeginLoc()));
-  json_->CloseObject();
+  if (graph_writer_)
+    graph_writer_->BeginClass();
+  DumpNode(info->record()->getQualifiedNameAsString(),
+           GetLocString(info->record()->getBeginLoc()));
 
   class DumpEdgeVisitor : public RecursiveEdgeVisitor {
    public:
-    DumpEdgeVisitor(JsonWriter* json) : json_(json) {}
+    DumpEdgeVisitor(BlinkGCPluginConsumer* consumer) : consumer_(consumer) {}
     void DumpEdge(RecordInfo* src,
                   RecordInfo* dst,
                   const std::string& lbl,
                   const Edge::LivenessKind& kind,
                   const std::string& loc) {
-      json_->OpenObject();
-      json_->Write("src", src->record()->getQualifiedNameAsString());
-      json_->Write("dst", dst->record()->getQualifiedNameAsString());
-      json_->Write("lbl", lbl);
-      json_->Write("kind", kind);
-      json_->Write("loc", loc);
-      json_->Write("ptr",
-                   !Parent() ? "val" :
-                   Parent()->IsRawPtr() ?
-                       (static_cast<RawPtr*>(Parent())->HasReferenceType() ?
-                        "reference" : "raw") :
-                   Parent()->IsRefPtr() ? "ref" :
-                   Parent()->IsUniquePtr() ? "unique" :
-                   (Parent()->IsMember() || Parent()->IsWeakMember()) ? "mem" :
-                   "val");
-      json_->CloseObject();
+      consumer_->DumpEdge(
+          src->record()->getQualifiedNameAsString(),
+          dst->record()->getQualifiedNameAsString(), lbl, kind, loc,
+          !Parent() ? "val" :
+          Parent()->IsRawPtr() ?
+              (static_cast<RawPtr*>(Parent())->HasReferenceType() ?
+               "reference" : "raw") :
+          Parent()->IsRefPtr() ? "ref" :
+          Parent()->IsUniquePtr() ? "unique" :
+          (Parent()->IsMember() || Parent()->IsWeakMember()) ? "mem" :
+          "val");
     }
 
     void DumpField(RecordInfo* src, FieldPoint* point, const std::string& loc) {
@@ -593,13 +627,13 @@ void BlinkGCPluginConsumer::DumpClass(RecordInfo* info) {
     }
 
    private:
-    JsonWriter* json_;
+    BlinkGCPluginConsumer* consumer_;
     RecordInfo* src_;
     FieldPoint* point_;
     std::string loc_;
   };
 
-  DumpEdgeVisitor visitor(json_);
+  DumpEdgeVisitor visitor(this);
 
   for (auto& base : info->GetBases())
     visitor.DumpEdge(info, base.second.info(), "<super>", Edge::kStrong,
@@ -608,6 +642,41 @@ void BlinkGCPluginConsumer::DumpClass(RecordInfo* info) {
   for (auto& field : info->GetFields())
     visitor.DumpField(info, &field.second,
                       GetLocString(field.second.field()->getBeginLoc()));
+
+  if (graph_writer_)
+    graph_writer_->EndClass();
+}
+
+void BlinkGCPluginConsumer::DumpNode(const std::string& name,
+                                     const std::string& loc) {
+  if (graph_writer_) {
+    graph_writer_->WriteNode(name, loc);
+    return;
+  }
+  json_->OpenObject();
+  json_->Write("name", name);
+  json_->Write("loc", loc);
+  json_->CloseObject();
+}
+
+void BlinkGCPluginConsumer::DumpEdge(const std::string& src,
+                                     const std::string& dst,
+                                     const std::string& lbl,
+                                     size_t kind,
+                                     const std::string& loc,
+                                     const std::string& ptr) {
+  if (graph_writer_) {
+    graph_writer_->WriteEdge(src, dst, lbl, kind, loc, ptr);
+    return;
+  }
+  json_->OpenObject();
+  json_->Write("src", src);
+  json_->Write("dst", dst);
+  json_->Write("lbl", lbl);
+  json_->Write("kind", kind);
+  json_->Write("loc", loc);
+  json_->Write("ptr", ptr);
+  json_->CloseObject();
 }
 
 std::string BlinkGCPluginConsumer::GetLocString(SourceLocation loc) {
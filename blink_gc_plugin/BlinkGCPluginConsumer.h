@@ -5,11 +5,15 @@
 #ifndef TOOLS_BLINK_GC_PLUGIN_BLINK_GC_PLUGIN_CONSUMER_H_
 #define TOOLS_BLINK_GC_PLUGIN_BLINK_GC_PLUGIN_CONSUMER_H_
 
+#include <memory>
 #include <string>
 
+#include "BadPatternFinder.h"
 #include "BlinkGCPluginOptions.h"
 #include "Config.h"
 #include "DiagnosticsReporter.h"
+#include "GraphFile.h"
+#include "SharedMatchFinder.h"
 #include "clang/AST/AST.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/Basic/Diagnostic.h"
@@ -25,6 +29,7 @@ class BlinkGCPluginConsumer : public clang::ASTConsumer {
   BlinkGCPluginConsumer(clang::CompilerInstance& instance,
                         const BlinkGCPluginOptions& options);
 
+  void Initialize(clang::ASTContext& context) override;
   void HandleTranslationUnit(clang::ASTContext& context) override;
 
  private:
@@ -64,6 +69,15 @@ class BlinkGCPluginConsumer : public clang::ASTConsumer {
 
   void DumpClass(RecordInfo* info);
 
+  // Write a node or an edge of the points-to graph to the open output.
+  void DumpNode(const std::string& name, const std::string& loc);
+  void DumpEdge(const std::string& src,
+                const std::string& dst,
+                const std::string& lbl,
+                size_t kind,
+                const std::string& loc,
+                const std::string& ptr);
+
   // Adds either a warning or error, based on the current handling of -Werror.
   clang::DiagnosticsEngine::Level getErrorLevel();
 
@@ -84,6 +98,14 @@ class BlinkGCPluginConsumer : public clang::ASTConsumer {
   BlinkGCPluginOptions options_;
   RecordCache cache_;
   JsonWriter* json_;
+  // Used instead of `json_` with dump-graph-binary.
+  std::unique_ptr<llvm::raw_pwrite_stream> graph_file_;
+  std::unique_ptr<graph_file::Writer> graph_writer_;
+
+  std::shared_ptr<chrome_plugin_host::SharedMatchFinder> shared_match_finder_;
+  // Owns the matchers added to `shared_match_finder_`, which may run after
+  // HandleTranslationUnit() returns.
+  std::unique_ptr<BadPatternFinder> bad_pattern_finder_;
 };
 
 #endif  // TOOLS_BLINK_GC_PLUGIN_BLINK_GC_PLUGIN_CONSUMER_H_
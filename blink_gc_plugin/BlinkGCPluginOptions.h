@@ -11,6 +11,8 @@
 
 struct BlinkGCPluginOptions {
   bool dump_graph = false;
+  // Dumps the graph in the binary form of GraphFile.h rather than as JSON.
+  bool dump_graph_binary = false;
 
   // Persistent<T> fields are not allowed in garbage collected classes to avoid
   // memory leaks. Enabling this flag allows the plugin to check also for
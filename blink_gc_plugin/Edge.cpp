@@ -27,7 +27,7 @@ TracingStatus Collection::NeedsTracing(NeedsTracingOption) {
   // This will be handled by matchers.
   if (IsSTDCollection()) {
     if ((GetCollectionName() == "array") && !members_.empty()) {
-      Edge* type = members_.at(0);
+      Edge* type = members_.front();
       if (type->IsMember() || type->IsWeakMember() ||
           type->IsTraceWrapperV8Reference()) {
         return TracingStatus::Needed();
@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "TracingStatus.h"
+#include "llvm/ADT/ArrayRef.h"
 
 class RecordInfo;
 
@@ -92,6 +93,9 @@ class RecursiveEdgeVisitor : public EdgeVisitor {
 };
 
 // Base class for all edges.
+//
+// Edges are allocated by the RecordCache, which never runs their destructors,
+// so they must not own any other memory.
 class Edge {
  public:
   enum NeedsTracingOption { kRecursive, kNonRecursive };
@@ -150,7 +154,6 @@ class ArrayEdge : public Edge {
 // Shared base for smart-pointer edges.
 class PtrEdge : public Edge {
  public:
-  ~PtrEdge() { delete ptr_; }
   Edge* ptr() { return ptr_; }
  protected:
   PtrEdge(Edge* ptr) : ptr_(ptr) {
@@ -272,19 +275,15 @@ class TraceWrapperV8Reference : public PtrEdge {
 
 class Collection : public Edge {
  public:
-  typedef std::vector<Edge*> Members;
-  Collection(RecordInfo* info, bool on_heap) : info_(info), on_heap_(on_heap) {}
-  ~Collection() {
-    for (Members::iterator it = members_.begin(); it != members_.end(); ++it) {
-      assert(*it && "Collection-edge members must be non-null");
-      delete *it;
-    }
-  }
+  typedef llvm::ArrayRef<Edge*> Members;
+  // |members| must live as long as the edge.
+  Collection(RecordInfo* info, bool on_heap, Members members)
+      : info_(info), members_(members), on_heap_(on_heap) {}
   bool IsCollection() override { return true; }
   bool IsSTDCollection();
   LivenessKind Kind() override { return kStrong; }
   bool on_heap() { return on_heap_; }
-  Members& members() { return members_; }
+  Members members() { return members_; }
   void Accept(EdgeVisitor* visitor) override { visitor->VisitCollection(this); }
   void AcceptMembers(EdgeVisitor* visitor) {
     for (Members::iterator it = members_.begin(); it != members_.end(); ++it)
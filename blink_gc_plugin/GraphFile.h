@@ -0,0 +1,281 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_BLINK_GC_PLUGIN_GRAPH_FILE_H_
+#define TOOLS_BLINK_GC_PLUGIN_GRAPH_FILE_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+
+// The binary form of the points-to graph written by the dump-graph-binary
+// option, as an alternative to the *.graph.json files. It has the same nodes
+// and edges as the JSON form, but each string is stored once, and the records
+// are grouped by the class that dumped them, with a hash of each group, so
+// that blink_gc_process_graph can skip a class it already read from another
+// translation unit.
+//
+// A *.graph.bin file is, with all integers little endian:
+//   char[8] "BGCGRAPH", u32 version
+//   u32 number of strings, then each string as a u32 size and its bytes
+//   u32 number of classes, then for each class:
+//     u64 hash of the contents of the class's records
+//     u32 number of records, then each record as a u8 type and:
+//       kNodeRecord: u32 name, u32 loc
+//       kEdgeRecord: u32 src, u32 dst, u32 lbl, u32 ptr, u32 loc, u32 kind
+// where the names, locations, labels and pointer kinds are string indices.
+namespace graph_file {
+
+constexpr char kMagic[8] = {'B', 'G', 'C', 'G', 'R', 'A', 'P', 'H'};
+constexpr uint32_t kVersion = 1;
+
+enum RecordType : uint8_t {
+  kNodeRecord = 0,
+  kEdgeRecord = 1,
+};
+
+// A node or edge record. Only the fields of its type are set.
+struct Record {
+  RecordType type;
+  llvm::StringRef name;
+  llvm::StringRef src;
+  llvm::StringRef dst;
+  llvm::StringRef lbl;
+  llvm::StringRef ptr;
+  llvm::StringRef loc;
+  uint32_t kind = 0;
+};
+
+// Collects the records of a translation unit and writes them out at the end,
+// once the string table is complete.
+class Writer {
+ public:
+  // Starts the records of a class.
+  void BeginClass() {
+    records_.clear();
+    num_records_ = 0;
+    hash_input_.clear();
+  }
+
+  void WriteNode(llvm::StringRef name, llvm::StringRef loc) {
+    AddType(kNodeRecord);
+    AddString(name);
+    AddString(loc);
+    ++num_records_;
+  }
+
+  void WriteEdge(llvm::StringRef src,
+                 llvm::StringRef dst,
+                 llvm::StringRef lbl,
+                 uint32_t kind,
+                 llvm::StringRef loc,
+                 llvm::StringRef ptr) {
+    AddType(kEdgeRecord);
+    AddString(src);
+    AddString(dst);
+    AddString(lbl);
+    AddString(ptr);
+    AddString(loc);
+    AddU32(records_, kind);
+    AddU32(hash_input_, kind);
+    ++num_records_;
+  }
+
+  // Ends the records of a class.
+  void EndClass() {
+    Class& c = classes_.emplace_back();
+    c.hash = llvm::xxHash64(hash_input_);
+    c.num_records = num_records_;
+    c.records = records_;
+  }
+
+  void Finish(llvm::raw_ostream& os) const {
+    std::string out(kMagic, sizeof(kMagic));
+    AddU32(out, kVersion);
+    AddU32(out, strings_.size());
+    for (llvm::StringRef string : strings_) {
+      AddU32(out, string.size());
+      out += string;
+    }
+    AddU32(out, classes_.size());
+    for (const Class& c : classes_) {
+      char hash[8];
+      llvm::support::endian::write64le(hash, c.hash);
+      out.append(hash, sizeof(hash));
+      AddU32(out, c.num_records);
+      out += c.records;
+    }
+    os << out;
+  }
+
+ private:
+  struct Class {
+    uint64_t hash;
+    uint32_t num_records;
+    std::string records;
+  };
+
+  static void AddU32(std::string& out, uint32_t value) {
+    char bytes[4];
+    llvm::support::endian::write32le(bytes, value);
+    out.append(bytes, sizeof(bytes));
+  }
+
+  void AddType(RecordType type) {
+    records_ += static_cast<char>(type);
+    hash_input_ += static_cast<char>(type);
+  }
+
+  void AddString(llvm::StringRef string) {
+    auto [it, inserted] = string_ids_.try_emplace(string, strings_.size());
+    if (inserted) {
+      strings_.push_back(it->getKey());
+    }
+    AddU32(records_, it->second);
+    // The hash covers the strings rather than their indices, which differ
+    // between translation units. The terminator keeps strings apart.
+    hash_input_ += string;
+    hash_input_ += '\0';
+  }
+
+  llvm::StringMap<uint32_t> string_ids_;
+  std::vector<llvm::StringRef> strings_;
+  std::vector<Class> classes_;
+
+  // The class being written.
+  std::string records_;
+  uint32_t num_records_ = 0;
+  std::string hash_input_;
+};
+
+// Reads a *.graph.bin file. The records refer to `data`, which must outlive
+// them.
+class Reader {
+ public:
+  explicit Reader(llvm::StringRef data) : data_(data) {}
+
+  static bool IsGraphFile(llvm::StringRef data) {
+    return data.starts_with(llvm::StringRef(kMagic, sizeof(kMagic)));
+  }
+
+  // Calls `on_class(hash, records, error)` for each class, in order, where
+  // `records` is an llvm::ArrayRef<Record>. Returns false and sets `error` if
+  // the file is malformed or if `on_class` returns false.
+  template <typename Callback>
+  bool Read(Callback on_class, std::string& error) {
+    uint32_t version;
+    if (!IsGraphFile(data_)) {
+      return Fail("not a graph file", error);
+    }
+    pos_ = sizeof(kMagic);
+    if (!ReadU32(version) || version != kVersion) {
+      return Fail("unsupported graph file version", error);
+    }
+    uint32_t num_strings;
+    if (!ReadU32(num_strings)) {
+      return Fail("truncated string table", error);
+    }
+    strings_.clear();
+    strings_.reserve(num_strings);
+    for (uint32_t i = 0; i < num_strings; ++i) {
+      uint32_t size;
+      if (!ReadU32(size) || size > data_.size() - pos_) {
+        return Fail("truncated string table", error);
+      }
+      strings_.push_back(data_.substr(pos_, size));
+      pos_ += size;
+    }
+    uint32_t num_classes;
+    if (!ReadU32(num_classes)) {
+      return Fail("truncated class list", error);
+    }
+    std::vector<Record> records;
+    for (uint32_t i = 0; i < num_classes; ++i) {
+      uint64_t hash;
+      uint32_t num_records;
+      if (!ReadU64(hash) || !ReadU32(num_records)) {
+        return Fail("truncated class", error);
+      }
+      records.clear();
+      for (uint32_t j = 0; j < num_records; ++j) {
+        if (!ReadRecord(records.emplace_back())) {
+          return Fail("malformed record", error);
+        }
+      }
+      if (!on_class(hash, llvm::ArrayRef<Record>(records), error)) {
+        return false;
+      }
+    }
+    if (pos_ != data_.size()) {
+      return Fail("trailing data", error);
+    }
+    return true;
+  }
+
+ private:
+  bool ReadRecord(Record& record) {
+    if (pos_ >= data_.size()) {
+      return false;
+    }
+    record.type = static_cast<RecordType>(data_[pos_++]);
+    switch (record.type) {
+      case kNodeRecord:
+        return ReadString(record.name) && ReadString(record.loc);
+      case kEdgeRecord:
+        return ReadString(record.src) && ReadString(record.dst) &&
+               ReadString(record.lbl) && ReadString(record.ptr) &&
+               ReadString(record.loc) && ReadU32(record.kind);
+    }
+    return false;
+  }
+
+  bool ReadString(llvm::StringRef& string) {
+    uint32_t id;
+    if (!ReadU32(id) || id >= strings_.size()) {
+      return false;
+    }
+    string = strings_[id];
+    return true;
+  }
+
+  bool ReadU32(uint32_t& value) {
+    if (data_.size() - pos_ < 4) {
+      return false;
+    }
+    value = llvm::support::endian::read32le(data_.data() + pos_);
+    pos_ += 4;
+    return true;
+  }
+
+  bool ReadU64(uint64_t& value) {
+    if (data_.size() - pos_ < 8) {
+      return false;
+    }
+    value = llvm::support::endian::read64le(data_.data() + pos_);
+    pos_ += 8;
+    return true;
+  }
+
+  bool Fail(llvm::StringRef message, std::string& error) {
+    error = (message + " at offset " + llvm::Twine(pos_)).str();
+    return false;
+  }
+
+  llvm::StringRef data_;
+  size_t pos_ = 0;
+  std::vector<llvm::StringRef> strings_;
+};
+
+}  // namespace graph_file
+
+#endif  // TOOLS_BLINK_GC_PLUGIN_GRAPH_FILE_H_
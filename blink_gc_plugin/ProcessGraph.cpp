@@ -0,0 +1,1252 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Native implementation of the cycle detection of process-graph.py.
+//
+// Reads the *.graph.json files written by the plugin's dump-graph option, or
+// the *.graph.bin files of dump-graph-binary, and reports the cycles
+// containing GC roots. The output, including the handling
+// of --ignore-cycles and --ignore-classes, is the same as
+// `process-graph.py -c`, byte for byte; see that script for a description of
+// the algorithm.
+//
+// Unlike the script, it doesn't build one object per node and edge: the files
+// are streamed, names are interned once, and the traversal works on a
+// compressed sparse row copy of the graph. Instead of resetting every node
+// before each root, the search stamps nodes with the index of the current
+// search, and the searches for different roots run on separate threads.
+//
+// With --write-database, the graph read from the input files is written to a
+// single database file instead, which later runs can load in place of the
+// files. A class that many translation units include is dumped by each of them;
+// in *.graph.bin files, the records of a class are hashed, and a class whose
+// hash was already read is skipped. The database holds each node and edge
+// once.
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "GraphFile.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/ConvertUTF.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace {
+
+constexpr uint32_t kNone = UINT32_MAX;
+
+// Liveness kinds of an edge, as written by the plugin.
+constexpr int64_t kWeak = 0;
+constexpr int64_t kStrong = 1;
+constexpr int64_t kRoot = 2;
+
+bool g_verbose = false;
+
+void Log(const llvm::Twine& message) {
+  if (g_verbose) {
+    llvm::outs() << message << "\n";
+  }
+}
+
+// Assigns a dense id to each distinct string.
+class StringTable {
+ public:
+  uint32_t Intern(llvm::StringRef string) {
+    auto [it, inserted] = ids_.try_emplace(string, strings_.size());
+    if (inserted) {
+      strings_.push_back(it->getKey());
+    }
+    return it->second;
+  }
+
+  // Returns the id of `string`, or kNone if it was never interned.
+  uint32_t Find(llvm::StringRef string) const {
+    auto it = ids_.find(string);
+    return it == ids_.end() ? kNone : it->second;
+  }
+
+  llvm::StringRef Get(uint32_t id) const { return strings_[id]; }
+  uint32_t size() const { return strings_.size(); }
+
+ private:
+  llvm::StringMap<uint32_t> ids_;
+  std::vector<llvm::StringRef> strings_;
+};
+
+// A value in a graph file. The plugin only writes strings and integers.
+struct JsonValue {
+  std::string string;
+  int64_t integer = 0;
+  bool is_integer = false;
+};
+
+// An object of a graph file. The plugin only writes flat objects.
+struct JsonObject {
+  const JsonValue* Get(llvm::StringRef key) const {
+    for (const auto& [k, v] : members) {
+      if (k == key) {
+        return &v;
+      }
+    }
+    return nullptr;
+  }
+
+  llvm::SmallVector<std::pair<std::string, JsonValue>, 6> members;
+};
+
+// Reads the list of objects in a graph file one object at a time, without
+// building a tree of the whole file.
+class JsonGraphReader {
+ public:
+  explicit JsonGraphReader(llvm::StringRef text) : text_(text) {}
+
+  // Calls `on_object` for each object of the list. Returns false and sets
+  // `error` if the file is malformed.
+  template <typename Callback>
+  bool Read(Callback on_object, std::string& error) {
+    JsonObject object;
+    SkipWhitespace();
+    if (!Consume('[')) {
+      return Fail("expected '['", error);
+    }
+    SkipWhitespace();
+    if (Consume(']')) {
+      return true;
+    }
+    while (true) {
+      SkipWhitespace();
+      if (!ReadObject(object, error)) {
+        return false;
+      }
+      if (!on_object(object, error)) {
+        return false;
+      }
+      SkipWhitespace();
+      if (Consume(']')) {
+        return true;
+      }
+      if (!Consume(',')) {
+        return Fail("expected ',' or ']'", error);
+      }
+    }
+  }
+
+ private:
+  bool ReadObject(JsonObject& object, std::string& error) {
+    object.members.clear();
+    if (!Consume('{')) {
+      return Fail("expected '{'", error);
+    }
+    SkipWhitespace();
+    if (Consume('}')) {
+      return true;
+    }
+    while (true) {
+      SkipWhitespace();
+      auto& [key, value] = object.members.emplace_back();
+      if (!ReadString(key, error)) {
+        return false;
+      }
+      SkipWhitespace();
+      if (!Consume(':')) {
+        return Fail("expected ':'", error);
+      }
+      SkipWhitespace();
+      if (Peek() == '"') {
+        if (!ReadString(value.string, error)) {
+          return false;
+        }
+      } else if (!ReadInteger(value.integer, error)) {
+        return false;
+      } else {
+        value.is_integer = true;
+      }
+      SkipWhitespace();
+      if (Consume('}')) {
+        return true;
+      }
+      if (!Consume(',')) {
+        return Fail("expected ',' or '}'", error);
+      }
+    }
+  }
+
+  bool ReadString(std::string& out, std::string& error) {
+    out.clear();
+    if (!Consume('"')) {
+      return Fail("expected a string", error);
+    }
+    while (pos_ < text_.size()) {
+      // Copy the run of characters up to the next quote or escape at once.
+      size_t end = text_.find_first_of("\"\\", pos_);
+      if (end == llvm::StringRef::npos) {
+        break;
+      }
+      out.append(text_.data() + pos_, end - pos_);
+      pos_ = end + 1;
+      if (text_[end] == '"') {
+        return true;
+      }
+      if (pos_ >= text_.size()) {
+        break;
+      }
+      char escape = text_[pos_++];
+      switch (escape) {
+        case '"':
+        case '\\':
+        case '/':
+          out += escape;
+          break;
+        case 'b':
+          out += '\b';
+          break;
+        case 'f':
+          out += '\f';
+          break;
+        case 'n':
+          out += '\n';
+          break;
+        case 'r':
+          out += '\r';
+          break;
+        case 't':
+          out += '\t';
+          break;
+        case 'u': {
+          uint32_t code_point;
+          if (!ReadHex4(code_point)) {
+            return Fail("invalid \\u escape", error);
+          }
+          // Combine surrogate pairs.
+          if (code_point >= 0xD800 && code_point < 0xDC00 &&
+              text_.substr(pos_).starts_with("\\u")) {
+            size_t saved = pos_;
+            pos_ += 2;
+            uint32_t low;
+            if (ReadHex4(low) && low >= 0xDC00 && low < 0xE000) {
+              code_point = 0x10000 + ((code_point - 0xD800) << 10) +
+                           (low - 0xDC00);
+            } else {
+              pos_ = saved;
+            }
+          }
+          char utf8[UNI_MAX_UTF8_BYTES_PER_CODE_POINT];
+          char* utf8_end = utf8;
+          if (!llvm::ConvertCodePointToUTF8(code_point, utf8_end)) {
+            return Fail("invalid \\u escape", error);
+          }
+          out.append(utf8, utf8_end);
+          break;
+        }
+        default:
+          return Fail("invalid escape", error);
+      }
+    }
+    return Fail("unterminated string", error);
+  }
+
+  bool ReadHex4(uint32_t& value) {
+    if (pos_ + 4 > text_.size() ||
+        text_.substr(pos_, 4).getAsInteger(16, value)) {
+      return false;
+    }
+    pos_ += 4;
+    return true;
+  }
+
+  bool ReadInteger(int64_t& value, std::string& error) {
+    size_t end = pos_;
+    if (end < text_.size() && text_[end] == '-') {
+      ++end;
+    }
+    while (end < text_.size() && llvm::isDigit(text_[end])) {
+      ++end;
+    }
+    if (text_.substr(pos_, end - pos_).getAsInteger(10, value)) {
+      return Fail("expected a string or an integer", error);
+    }
+    pos_ = end;
+    return true;
+  }
+
+  void SkipWhitespace() {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\n' || text_[pos_] == '\r' ||
+            text_[pos_] == '\t')) {
+      ++pos_;
+    }
+  }
+
+  char Peek() const { return pos_ < text_.size() ? text_[pos_] : '\0'; }
+
+  bool Consume(char c) {
+    if (Peek() != c) {
+      return false;
+    }
+    ++pos_;
+    return true;
+  }
+
+  bool Fail(llvm::StringRef message, std::string& error) {
+    error = (message + " at offset " + llvm::Twine(pos_)).str();
+    return false;
+  }
+
+  llvm::StringRef text_;
+  size_t pos_ = 0;
+};
+
+// A database written by --write-database is, with all integers little endian:
+//   char[8] "BGCGRPDB", u32 version
+//   u32 number of strings, u32 number of nodes, u32 number of edges,
+//   u32 number of class hashes
+//   u64 end offset of each string in the string data, then the string data
+//   u32 name of each node, in creation order
+//   u32 end index of the edges of each node, in the edge array
+//   for each edge: u32 dst, u32 lbl, u32 ptr, u32 loc, i64 kind
+//   u64 hash of each class read from *.graph.bin files
+// where the names, labels and so on are string indices. It is the graph before
+// Complete(), so that databases can be merged with each other and with graph
+// files.
+constexpr char kDatabaseMagic[8] = {'B', 'G', 'C', 'G', 'R', 'P', 'D', 'B'};
+constexpr uint32_t kDatabaseVersion = 1;
+
+// Appends little-endian integers to a database.
+void AppendU32(std::string& out, uint32_t value) {
+  char bytes[4];
+  llvm::support::endian::write32le(bytes, value);
+  out.append(bytes, sizeof(bytes));
+}
+void AppendU64(std::string& out, uint64_t value) {
+  char bytes[8];
+  llvm::support::endian::write64le(bytes, value);
+  out.append(bytes, sizeof(bytes));
+}
+
+struct Edge {
+  // Node the edge leaves from.
+  uint32_t src;
+  // Name of the type the edge points to, which may not be a node.
+  uint32_t dst;
+  uint32_t lbl;
+  uint32_t ptr;
+  uint32_t loc;
+  int64_t kind;
+};
+
+class Graph {
+ public:
+  // Adds the nodes and edges of a graph file or database. Returns false and
+  // sets `error` if the file cannot be read.
+  bool AddFile(llvm::StringRef filename, std::string& error) {
+    // Large files are mapped rather than read.
+    auto buffer = llvm::MemoryBuffer::getFile(filename, /*IsText=*/false,
+                                              /*RequiresNullTerminator=*/false);
+    if (!buffer) {
+      error = filename.str() + ": " + buffer.getError().message();
+      return false;
+    }
+    llvm::StringRef data = (*buffer)->getBuffer();
+    bool ok;
+    if (data.starts_with(
+            llvm::StringRef(kDatabaseMagic, sizeof(kDatabaseMagic)))) {
+      ok = AddDatabase(data, error);
+    } else if (graph_file::Reader::IsGraphFile(data)) {
+      ok = AddGraphFile(data, error);
+    } else {
+      ok = AddJsonFile(data, error);
+    }
+    if (!ok) {
+      error = filename.str() + ": " + error;
+    }
+    return ok;
+  }
+
+  // Writes the nodes and edges added so far, and the hashes of the classes
+  // read, as a database. Must be called before Complete().
+  bool WriteDatabase(llvm::StringRef filename, std::string& error) const {
+    // Only the strings the nodes and edges use are written.
+    std::vector<uint32_t> string_ids(strings_.size(), kNone);
+    std::vector<uint32_t> strings;
+    auto id = [&](uint32_t string) {
+      if (string_ids[string] == kNone) {
+        string_ids[string] = strings.size();
+        strings.push_back(string);
+      }
+      return string_ids[string];
+    };
+
+    std::string nodes;
+    std::string edge_ends;
+    std::string edges;
+    uint32_t num_edges = 0;
+    for (uint32_t node = 0; node < num_nodes(); ++node) {
+      AppendU32(nodes, id(node_names_[node]));
+      for (uint32_t edge : node_edges_[node]) {
+        const Edge& e = edges_[edge];
+        AppendU32(edges, id(e.dst));
+        AppendU32(edges, id(e.lbl));
+        AppendU32(edges, id(e.ptr));
+        AppendU32(edges, id(e.loc));
+        AppendU64(edges, e.kind);
+        ++num_edges;
+      }
+      AppendU32(edge_ends, num_edges);
+    }
+
+    std::string out(kDatabaseMagic, sizeof(kDatabaseMagic));
+    AppendU32(out, kDatabaseVersion);
+    AppendU32(out, strings.size());
+    AppendU32(out, num_nodes());
+    AppendU32(out, num_edges);
+    AppendU32(out, class_hashes_.size());
+    uint64_t string_end = 0;
+    for (uint32_t string : strings) {
+      string_end += str(string).size();
+      AppendU64(out, string_end);
+    }
+    for (uint32_t string : strings) {
+      out += str(string);
+    }
+    out += nodes;
+    out += edge_ends;
+    out += edges;
+    for (uint64_t hash : class_hashes_) {
+      AppendU64(out, hash);
+    }
+
+    std::error_code ec;
+    llvm::raw_fd_ostream os(filename, ec);
+    if (!ec) {
+      os << out;
+      os.close();
+      ec = os.error();
+    }
+    if (ec) {
+      error = filename.str() + ": " + ec.message();
+      return false;
+    }
+    return true;
+  }
+
+  // Copies the edges of super classes down to their subclasses and collects
+  // the roots, like complete_graph().
+  void Complete() {
+    for (uint32_t node = 0; node < num_nodes(); ++node) {
+      llvm::SmallVector<uint32_t, 4> super_edges;
+      for (uint32_t edge : node_edges_[node]) {
+        if (IsSuper(edges_[edge])) {
+          super_edges.push_back(edge);
+        }
+      }
+      for (uint32_t edge : super_edges) {
+        CopySuperEdges(edge);
+      }
+      for (uint32_t edge : node_edges_[node]) {
+        if (edges_[edge].kind == kRoot) {
+          roots_.push_back(edge);
+        }
+      }
+    }
+    Log("Copied edges down <super> edges for " + llvm::Twine(num_copies_) +
+        " graph nodes");
+
+    // Only the edges that keep their destination alive are followed, and only
+    // if the destination is a node.
+    adjacency_offsets_.assign(num_nodes() + 1, 0);
+    for (uint32_t node = 0; node < num_nodes(); ++node) {
+      for (uint32_t edge : node_edges_[node]) {
+        uint32_t dst = FindNode(edges_[edge].dst);
+        if (edges_[edge].kind > kWeak && dst != kNone) {
+          adjacency_targets_.push_back(dst);
+          adjacency_edges_.push_back(edge);
+        }
+      }
+      adjacency_offsets_[node + 1] = adjacency_targets_.size();
+    }
+  }
+
+  uint32_t num_nodes() const { return node_names_.size(); }
+  const std::vector<uint32_t>& roots() const { return roots_; }
+  const Edge& edge(uint32_t id) const { return edges_[id]; }
+  llvm::StringRef str(uint32_t id) const { return strings_.Get(id); }
+  llvm::StringRef node_name(uint32_t node) const {
+    return str(node_names_[node]);
+  }
+
+  // Returns the node named `name`, or kNone.
+  uint32_t FindNode(llvm::StringRef name) const {
+    uint32_t id = strings_.Find(name);
+    return id == kNone ? kNone : FindNode(id);
+  }
+  uint32_t FindNode(uint32_t name) const {
+    return name < node_of_name_.size() ? node_of_name_[name] : kNone;
+  }
+
+  // The edges followed from `node`: the targets are nodes, and the edges are
+  // the ids of the corresponding edges, in the order of the node's edges.
+  llvm::ArrayRef<uint32_t> targets(uint32_t node) const {
+    return llvm::ArrayRef<uint32_t>(adjacency_targets_)
+        .slice(adjacency_offsets_[node],
+               adjacency_offsets_[node + 1] - adjacency_offsets_[node]);
+  }
+  llvm::ArrayRef<uint32_t> target_edges(uint32_t node) const {
+    return llvm::ArrayRef<uint32_t>(adjacency_edges_)
+        .slice(adjacency_offsets_[node],
+               adjacency_offsets_[node + 1] - adjacency_offsets_[node]);
+  }
+
+  // Formats `edge` like Edge.__repr__().
+  std::string ToString(uint32_t id) const {
+    const Edge& e = edges_[id];
+    return (node_name(e.src) + " (" + str(e.lbl) + ") => " + str(e.dst)).str();
+  }
+
+ private:
+  bool AddJsonFile(llvm::StringRef data, std::string& error) {
+    JsonGraphReader reader(data);
+    return reader.Read(
+        [&](const JsonObject& decl, std::string& error) {
+          return AddDecl(decl, error);
+        },
+        error);
+  }
+
+  bool AddDecl(const JsonObject& decl, std::string& error) {
+    if (const JsonValue* name = decl.Get("name")) {
+      GetNode(strings_.Intern(name->string));
+      return true;
+    }
+    const JsonValue* fields[6];
+    static constexpr const char* kFields[] = {"src", "dst", "lbl",
+                                              "ptr", "loc", "kind"};
+    for (size_t i = 0; i < std::size(kFields); ++i) {
+      fields[i] = decl.Get(kFields[i]);
+      if (!fields[i]) {
+        error = std::string("edge without '") + kFields[i] + "'";
+        return false;
+      }
+    }
+    Edge edge;
+    edge.src = GetNode(strings_.Intern(fields[0]->string));
+    edge.dst = strings_.Intern(fields[1]->string);
+    edge.lbl = strings_.Intern(fields[2]->string);
+    edge.ptr = strings_.Intern(fields[3]->string);
+    edge.loc = strings_.Intern(fields[4]->string);
+    edge.kind = fields[5]->integer;
+    AddEdge(edge);
+    return true;
+  }
+
+  bool AddGraphFile(llvm::StringRef data, std::string& error) {
+    graph_file::Reader reader(data);
+    return reader.Read(
+        [&](uint64_t hash, llvm::ArrayRef<graph_file::Record> records,
+            std::string& /*error*/) {
+          // The records of a class that was already read add nothing: the
+          // nodes exist, and so do the edges, with at least the same kind.
+          if (!class_hash_set_.insert(hash).second) {
+            return true;
+          }
+          class_hashes_.push_back(hash);
+          for (const graph_file::Record& record : records) {
+            if (record.type == graph_file::kNodeRecord) {
+              GetNode(strings_.Intern(record.name));
+              continue;
+            }
+            Edge edge;
+            edge.src = GetNode(strings_.Intern(record.src));
+            edge.dst = strings_.Intern(record.dst);
+            edge.lbl = strings_.Intern(record.lbl);
+            edge.ptr = strings_.Intern(record.ptr);
+            edge.loc = strings_.Intern(record.loc);
+            edge.kind = record.kind;
+            AddEdge(edge);
+          }
+          return true;
+        },
+        error);
+  }
+
+  bool AddDatabase(llvm::StringRef data, std::string& error) {
+    size_t pos = sizeof(kDatabaseMagic);
+    // Returns the next `size` bytes, or an empty string if there are fewer.
+    auto take = [&](uint64_t size) {
+      if (pos > data.size() || data.size() - pos < size) {
+        pos = data.size() + 1;
+        return llvm::StringRef();
+      }
+      llvm::StringRef bytes = data.substr(pos, size);
+      pos += size;
+      return bytes;
+    };
+    auto read_u32 = [&] {
+      llvm::StringRef bytes = take(4);
+      return bytes.empty() ? 0 : llvm::support::endian::read32le(bytes.data());
+    };
+    auto read_u64 = [&] {
+      llvm::StringRef bytes = take(8);
+      return bytes.empty() ? 0 : llvm::support::endian::read64le(bytes.data());
+    };
+    auto truncated = [&] {
+      if (pos <= data.size()) {
+        return false;
+      }
+      error = "truncated database";
+      return true;
+    };
+
+    if (read_u32() != kDatabaseVersion) {
+      error = "unsupported database version";
+      return false;
+    }
+    const uint32_t num_strings = read_u32();
+    const uint32_t num_db_nodes = read_u32();
+    const uint32_t num_db_edges = read_u32();
+    const uint32_t num_hashes = read_u32();
+    llvm::StringRef string_ends = take(uint64_t{8} * num_strings);
+    if (truncated()) {
+      return false;
+    }
+    const uint64_t string_data_size =
+        num_strings == 0
+            ? 0
+            : llvm::support::endian::read64le(string_ends.end() - 8);
+    llvm::StringRef string_data = take(string_data_size);
+    if (truncated()) {
+      return false;
+    }
+    std::vector<uint32_t> ids(num_strings);
+    uint64_t string_begin = 0;
+    for (uint32_t i = 0; i < num_strings; ++i) {
+      uint64_t string_end =
+          llvm::support::endian::read64le(string_ends.data() + 8 * i);
+      if (string_end < string_begin || string_end > string_data_size) {
+        error = "malformed string table";
+        return false;
+      }
+      ids[i] = strings_.Intern(
+          string_data.substr(string_begin, string_end - string_begin));
+      string_begin = string_end;
+    }
+    bool bad_string = false;
+    auto string = [&](uint32_t index) {
+      if (index < num_strings) {
+        return ids[index];
+      }
+      bad_string = true;
+      return strings_.Intern("");
+    };
+
+    std::vector<uint32_t> nodes(num_db_nodes);
+    for (uint32_t& node : nodes) {
+      node = GetNode(string(read_u32()));
+    }
+    if (truncated()) {
+      return false;
+    }
+    llvm::StringRef edge_ends = take(uint64_t{4} * num_db_nodes);
+    llvm::StringRef edges = take(uint64_t{24} * num_db_edges);
+    if (truncated()) {
+      return false;
+    }
+    // The edges are read from `edges` directly, without moving `pos`.
+    const char* e = edges.data();
+    uint32_t edge_begin = 0;
+    for (uint32_t i = 0; i < num_db_nodes; ++i) {
+      uint32_t edge_end =
+          llvm::support::endian::read32le(edge_ends.data() + 4 * i);
+      if (edge_end < edge_begin || edge_end > num_db_edges) {
+        error = "malformed edge table";
+        return false;
+      }
+      for (; edge_begin < edge_end; ++edge_begin, e += 24) {
+        Edge edge;
+        edge.src = nodes[i];
+        edge.dst = string(llvm::support::endian::read32le(e));
+        edge.lbl = string(llvm::support::endian::read32le(e + 4));
+        edge.ptr = string(llvm::support::endian::read32le(e + 8));
+        edge.loc = string(llvm::support::endian::read32le(e + 12));
+        edge.kind = llvm::support::endian::read64le(e + 16);
+        AddEdge(edge);
+      }
+    }
+    if (bad_string) {
+      error = "invalid string index";
+      return false;
+    }
+    for (uint32_t i = 0; i < num_hashes; ++i) {
+      uint64_t hash = read_u64();
+      if (class_hash_set_.insert(hash).second) {
+        class_hashes_.push_back(hash);
+      }
+    }
+    if (truncated()) {
+      return false;
+    }
+    if (pos != data.size()) {
+      error = "trailing data";
+      return false;
+    }
+    return true;
+  }
+
+  // Adds `edge` to its source node. If the edge exists, its kind is the
+  // strongest of the two.
+  void AddEdge(const Edge& edge) {
+    auto [it, inserted] = edge_slots_.try_emplace(
+        std::make_pair(edge.src, Key(edge)), node_edges_[edge.src].size());
+    if (inserted) {
+      node_edges_[edge.src].push_back(edges_.size());
+      edges_.push_back(edge);
+    } else {
+      Edge& existing = edges_[node_edges_[edge.src][it->second]];
+      existing.kind = std::max(existing.kind, edge.kind);
+    }
+  }
+
+  uint32_t GetNode(uint32_t name) {
+    if (name >= node_of_name_.size()) {
+      node_of_name_.resize(name + 1, kNone);
+    }
+    if (node_of_name_[name] == kNone) {
+      node_of_name_[name] = num_nodes();
+      node_names_.push_back(name);
+      node_edges_.emplace_back();
+    }
+    return node_of_name_[name];
+  }
+
+  // The key of an edge in its source node, like Edge.key.
+  uint32_t Key(const Edge& edge) {
+    llvm::SmallString<128> key(str(edge.lbl));
+    key += '#';
+    key += str(edge.dst);
+    return strings_.Intern(key);
+  }
+
+  // Adds `edge` to its source node, replacing the edge with the same key.
+  void SetEdge(const Edge& edge) {
+    auto [it, inserted] = edge_slots_.try_emplace(
+        std::make_pair(edge.src, Key(edge)), node_edges_[edge.src].size());
+    if (inserted) {
+      node_edges_[edge.src].push_back(edges_.size());
+    } else {
+      node_edges_[edge.src][it->second] = edges_.size();
+    }
+    edges_.push_back(edge);
+  }
+
+  bool IsSuper(const Edge& edge) const {
+    return str(edge.lbl).starts_with("<super>");
+  }
+  bool IsSubclass(const Edge& edge) const {
+    return str(edge.lbl).starts_with("<subclass>");
+  }
+
+  // Like copy_super_edges(): copies the strong edges of the super class of
+  // `id` to the subclass, after doing the same for the super class's own
+  // super classes. Each super edge is made weak once processed, so each is
+  // processed once.
+  void CopySuperEdges(uint32_t id) {
+    if (edges_[id].kind == kWeak || !IsSuper(edges_[id])) {
+      return;
+    }
+    ++num_copies_;
+    edges_[id].kind = kWeak;
+    const Edge super_edge = edges_[id];
+    uint32_t super_node = FindNode(super_edge.dst);
+    if (super_node == kNone) {
+      return;
+    }
+    llvm::SmallVector<uint32_t, 4> super_edges;
+    for (uint32_t edge : node_edges_[super_node]) {
+      if (IsSuper(edges_[edge])) {
+        super_edges.push_back(edge);
+      }
+    }
+    for (uint32_t edge : super_edges) {
+      CopySuperEdges(edge);
+    }
+
+    uint32_t sub_node = super_edge.src;
+    const size_t num_super_node_edges = node_edges_[super_node].size();
+    for (size_t i = 0; i < num_super_node_edges; ++i) {
+      const Edge e = edges_[node_edges_[super_node][i]];
+      if (e.kind > kWeak && !IsSubclass(e)) {
+        Edge copy = e;
+        copy.src = sub_node;
+        copy.lbl = strings_.Intern(
+            (node_name(super_node) + " <: " + str(e.lbl)).str());
+        SetEdge(copy);
+      }
+    }
+    Edge sub_edge = super_edge;
+    sub_edge.src = super_node;
+    sub_edge.dst = node_names_[sub_node];
+    sub_edge.lbl = strings_.Intern("<subclass>");
+    sub_edge.kind = kStrong;
+    SetEdge(sub_edge);
+  }
+
+  StringTable strings_;
+
+  // Names of the nodes, in creation order, and the reverse mapping.
+  std::vector<uint32_t> node_names_;
+  std::vector<uint32_t> node_of_name_;
+
+  // The edges of each node, in the order of the script's dicts: by first
+  // insertion of their key.
+  std::vector<std::vector<uint32_t>> node_edges_;
+  // Index in `node_edges_` of the edge with a given key from a given node.
+  llvm::DenseMap<std::pair<uint32_t, uint32_t>, uint32_t> edge_slots_;
+  std::vector<Edge> edges_;
+
+  // Hashes of the classes read from graph files, in order, and as a set.
+  std::vector<uint64_t> class_hashes_;
+  std::unordered_set<uint64_t> class_hash_set_;
+
+  std::vector<uint32_t> roots_;
+  uint32_t num_copies_ = 0;
+
+  // Compressed sparse row form of the followed edges.
+  std::vector<uint32_t> adjacency_offsets_;
+  std::vector<uint32_t> adjacency_targets_;
+  std::vector<uint32_t> adjacency_edges_;
+};
+
+// Per-thread state of the search for the cycles through each root.
+class CycleFinder {
+ public:
+  CycleFinder(const Graph& graph,
+              const std::vector<uint32_t>& ignored_nodes,
+              const llvm::StringSet<>& ignored_cycles)
+      : graph_(graph),
+        ignored_nodes_(ignored_nodes),
+        ignored_cycles_(ignored_cycles),
+        visited_(graph.num_nodes(), 0),
+        reached_(graph.num_nodes(), 0),
+        cost_(graph.num_nodes()),
+        path_(graph.num_nodes()) {}
+
+  // Returns what detect_cycles() prints for `root`, and sets `error` if it
+  // reports an error.
+  std::string Check(uint32_t root, bool& error) {
+    ++epoch_;
+    for (uint32_t node : ignored_nodes_) {
+      visited_[node] = epoch_;
+    }
+    const Edge& root_edge = graph_.edge(root);
+    uint32_t src = root_edge.src;
+    if (visited_[src] == epoch_ || graph_.str(root_edge.dst) == "WTF::String") {
+      return std::string();
+    }
+    uint32_t dst = graph_.FindNode(root_edge.dst);
+    if (dst == kNone) {
+      error = true;
+      return "\nPersistent root to incomplete destination object:\n" +
+             graph_.ToString(root) + "\n";
+    }
+    // Find the shortest path from the root target (dst) to its host (src).
+    ShortestPath(dst, src);
+    if (reached_[src] != epoch_) {
+      return std::string();
+    }
+    return ReportCycle(root, error);
+  }
+
+ private:
+  // Like shortest_path(). The script sorts its work list by decreasing cost
+  // with a stable sort and pops the last node: among the nodes of the lowest
+  // cost, the one added last. A node is added each time it is found, even if
+  // it was already added, and is expanded each time it is popped. All added
+  // nodes have the lowest cost or the one after, so the work list is the same
+  // as a stack for each of these two costs.
+  void ShortestPath(uint32_t start, uint32_t end) {
+    Reach(start, 0, kNone);
+    level_.assign(1, start);
+    next_level_.clear();
+    while (true) {
+      if (level_.empty()) {
+        if (next_level_.empty()) {
+          return;
+        }
+        std::swap(level_, next_level_);
+      }
+      uint32_t current = level_.back();
+      level_.pop_back();
+      visited_[current] = epoch_;
+      if (current == end ||
+          (reached_[end] == epoch_ && cost_[current] >= cost_[end] + 1)) {
+        return;
+      }
+      llvm::ArrayRef<uint32_t> targets = graph_.targets(current);
+      llvm::ArrayRef<uint32_t> edges = graph_.target_edges(current);
+      for (size_t i = 0; i < targets.size(); ++i) {
+        uint32_t dst = targets[i];
+        if (visited_[dst] == epoch_) {
+          continue;
+        }
+        if (reached_[dst] != epoch_ || cost_[current] < cost_[dst]) {
+          Reach(dst, cost_[current] + 1, edges[i]);
+        }
+        (cost_[dst] == cost_[current] ? level_ : next_level_).push_back(dst);
+      }
+    }
+  }
+
+  void Reach(uint32_t node, uint32_t cost, uint32_t path) {
+    reached_[node] = epoch_;
+    cost_[node] = cost;
+    path_[node] = path;
+  }
+
+  // The edge a node was reached through, or kNone.
+  uint32_t PathOf(uint32_t node) const {
+    return reached_[node] == epoch_ ? path_[node] : kNone;
+  }
+
+  // Like report_cycle().
+  std::string ReportCycle(uint32_t root, bool& error) {
+    llvm::SmallVector<uint32_t, 16> path;
+    for (uint32_t edge = root; edge != kNone;
+         edge = PathOf(graph_.edge(edge).src)) {
+      path.push_back(edge);
+    }
+    path.push_back(root);
+    std::reverse(path.begin(), path.end());
+
+    size_t max_loc = 0;
+    for (uint32_t edge : path) {
+      max_loc = std::max(max_loc, graph_.str(graph_.edge(edge).loc).size());
+    }
+    std::string cycle;
+    llvm::raw_string_ostream out(cycle);
+    for (uint32_t edge : llvm::ArrayRef<uint32_t>(path).drop_back()) {
+      llvm::StringRef loc = graph_.str(graph_.edge(edge).loc);
+      out << loc << ':';
+      out.indent(max_loc - loc.size());
+      out << ' ' << graph_.ToString(edge) << '\n';
+    }
+    out.flush();
+    if (ignored_cycles_.contains(cycle)) {
+      return std::string();
+    }
+    error = true;
+    return "\nFound a potentially leaking cycle starting from a GC root:\n" +
+           cycle + "\n";
+  }
+
+  const Graph& graph_;
+  const std::vector<uint32_t>& ignored_nodes_;
+  const llvm::StringSet<>& ignored_cycles_;
+
+  // A node is visited, or has a cost and path, in the current search if its
+  // entry is the current epoch.
+  uint32_t epoch_ = 0;
+  std::vector<uint32_t> visited_;
+  std::vector<uint32_t> reached_;
+  std::vector<uint32_t> cost_;
+  std::vector<uint32_t> path_;
+
+  std::vector<uint32_t> level_;
+  std::vector<uint32_t> next_level_;
+};
+
+// Like read_ignored_cycles(): the blocks of lines between empty lines and
+// "Found ..." lines, each as the concatenation of its lines.
+bool ReadIgnoredCycles(llvm::StringRef filename,
+                       llvm::StringSet<>& ignored_cycles) {
+  Log("Reading ignored cycles from file: " + filename);
+  auto buffer = llvm::MemoryBuffer::getFile(filename, /*IsText=*/true);
+  if (!buffer) {
+    llvm::errs() << filename << ": " << buffer.getError().message() << "\n";
+    return false;
+  }
+  // Python reads the file with universal newlines.
+  std::string text = (*buffer)->getBuffer().str();
+  std::string normalized;
+  normalized.reserve(text.size());
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (text[i] == '\r') {
+      normalized += '\n';
+      if (i + 1 < text.size() && text[i + 1] == '\n') {
+        ++i;
+      }
+    } else {
+      normalized += text[i];
+    }
+  }
+
+  std::string block;
+  llvm::StringRef rest = normalized;
+  while (!rest.empty()) {
+    size_t end = rest.find('\n');
+    end = end == llvm::StringRef::npos ? rest.size() : end + 1;
+    llvm::StringRef line = rest.take_front(end);
+    rest = rest.drop_front(end);
+    llvm::StringRef stripped = line.trim();
+    if (stripped.empty() || stripped.starts_with("Found")) {
+      if (!block.empty()) {
+        ignored_cycles.insert(block);
+      }
+      block.clear();
+    } else {
+      block += line;
+    }
+  }
+  if (!block.empty()) {
+    ignored_cycles.insert(block);
+  }
+  return true;
+}
+
+bool AddGraphsInDir(Graph& graph, llvm::StringRef dirname, std::string& error) {
+  std::vector<std::string> files;
+  std::error_code ec;
+  for (llvm::sys::fs::recursive_directory_iterator it(dirname, ec), end;
+       it != end && !ec; it.increment(ec)) {
+    llvm::StringRef path = it->path();
+    if (path.ends_with(".graph.json") || path.ends_with(".graph.bin")) {
+      files.push_back(it->path());
+    }
+  }
+  if (ec) {
+    error = dirname.str() + ": " + ec.message();
+    return false;
+  }
+  Log("Found " + llvm::Twine(files.size()) + " files");
+  for (const std::string& file : files) {
+    if (!graph.AddFile(file, error)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PrintUsage() {
+  llvm::errs()
+      << "usage: blink_gc_process_graph [-] [-c] [-v] [-j N]\n"
+         "                              [--write-database FILE]\n"
+         "                              [--ignore-cycles FILE]\n"
+         "                              [--ignore-classes [CLASS ...]]\n"
+         "                              [FILE_OR_DIR ...]\n"
+         "\n"
+         "Detects cycles containing GC roots in the Blink points-to graph\n"
+         "generated by the Blink GC plugin, like `process-graph.py -c`.\n"
+         "\n"
+         "  -                     Read the names of graph files from stdin\n"
+         "  -c, --detect-cycles   Detect cycles containing GC roots\n"
+         "  -v, --verbose         Verbose output\n"
+         "  -j N, --jobs N        Number of threads (default: all cores)\n"
+         "  --write-database FILE Write the graph read from the inputs, with\n"
+         "                        each node and edge once, to FILE\n"
+         "  --ignore-cycles FILE  File with cycles to ignore\n"
+         "  --ignore-classes CLASS ...\n"
+         "                        Classes to ignore when detecting cycles\n"
+         "\n"
+         "The inputs are *.graph.json and *.graph.bin files, databases, and\n"
+         "directories, which are searched for graph files.\n"
+         "--print-stats and --pickle-graph are only supported by\n"
+         "process-graph.py.\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool use_stdin = false;
+  bool detect_cycles = false;
+  unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+  std::string ignore_cycles;
+  std::string database;
+  std::vector<std::string> ignore_classes;
+  std::vector<std::string> files;
+
+  // Accepts the same arguments as process-graph.py's argparse parser.
+  for (int i = 1; i < argc; ++i) {
+    llvm::StringRef arg = argv[i];
+    // Matches `name VALUE`, `name=VALUE` and, for short options, `nameVALUE`.
+    auto value = [&](llvm::StringRef name, std::string& out) {
+      llvm::StringRef rest = arg;
+      if (!rest.consume_front(name)) {
+        return false;
+      }
+      if (rest.empty()) {
+        if (i + 1 >= argc) {
+          return false;
+        }
+        out = argv[++i];
+        return true;
+      }
+      if (rest.consume_front("=") || !name.starts_with("--")) {
+        out = rest.str();
+        return true;
+      }
+      return false;
+    };
+    std::string jobs_value;
+    if (arg == "-") {
+      use_stdin = true;
+    } else if (arg == "-c" || arg == "--detect-cycles") {
+      detect_cycles = true;
+    } else if (arg == "-v" || arg == "--verbose") {
+      g_verbose = true;
+    } else if (arg == "-cv" || arg == "-vc") {
+      detect_cycles = g_verbose = true;
+    } else if (value("--ignore-cycles", ignore_cycles)) {
+    } else if (value("--write-database", database)) {
+    } else if (arg == "--ignore-classes") {
+      while (i + 1 < argc && !llvm::StringRef(argv[i + 1]).starts_with("-")) {
+        ignore_classes.push_back(argv[++i]);
+      }
+    } else if (value("--jobs", jobs_value) || value("-j", jobs_value)) {
+      if (llvm::StringRef(jobs_value).getAsInteger(10, jobs) || jobs == 0) {
+        llvm::errs() << "Invalid number of jobs: " << jobs_value << "\n";
+        return 2;
+      }
+    } else if (arg == "-h" || arg == "--help") {
+      PrintUsage();
+      return 0;
+    } else if (arg.starts_with("-")) {
+      llvm::errs() << "Unsupported argument: " << arg << "\n";
+      PrintUsage();
+      return 2;
+    } else {
+      files.push_back(arg.str());
+    }
+  }
+
+  if (!detect_cycles && database.empty()) {
+    llvm::outs() << "Please select an operation to perform (eg, -c to detect "
+                    "cycles)\n";
+    PrintUsage();
+    return 1;
+  }
+
+  Graph graph;
+  std::string error;
+  if (use_stdin) {
+    Log("Reading files from stdin");
+    auto input = llvm::MemoryBuffer::getSTDIN();
+    if (!input) {
+      llvm::errs() << "Cannot read stdin: " << input.getError().message()
+                   << "\n";
+      return 1;
+    }
+    llvm::SmallVector<llvm::StringRef, 0> lines;
+    (*input)->getBuffer().split(lines, '\n');
+    // Like `for f in sys.stdin`, a trailing newline doesn't add a line.
+    if (!lines.empty() && lines.back().empty()) {
+      lines.pop_back();
+    }
+    for (llvm::StringRef line : lines) {
+      if (!graph.AddFile(line.trim(), error)) {
+        llvm::errs() << error << "\n";
+        return 1;
+      }
+    }
+  } else {
+    Log("Reading files and directories from command line");
+    if (files.empty()) {
+      llvm::outs() << "Please provide files or directores for building the "
+                      "graph\n";
+      PrintUsage();
+      return 1;
+    }
+    for (const std::string& file : files) {
+      bool ok;
+      if (llvm::sys::fs::is_directory(file)) {
+        Log("Building graph from files in directory: " + file);
+        ok = AddGraphsInDir(graph, file, error);
+      } else {
+        Log("Building graph from file: " + file);
+        ok = graph.AddFile(file, error);
+      }
+      if (!ok) {
+        llvm::errs() << error << "\n";
+        return 1;
+      }
+    }
+  }
+  if (!database.empty()) {
+    Log("Writing database: " + database);
+    if (!graph.WriteDatabase(database, error)) {
+      llvm::errs() << error << "\n";
+      return 1;
+    }
+    if (!detect_cycles) {
+      return 0;
+    }
+  }
+
+  Log("Completing graph construction (" + llvm::Twine(graph.num_nodes()) +
+      " graph nodes)");
+  graph.Complete();
+
+  llvm::StringSet<> ignored_cycles;
+  if (!ignore_cycles.empty() &&
+      !ReadIgnoredCycles(ignore_cycles, ignored_cycles)) {
+    return 1;
+  }
+  Log("Detecting cycles containg GC roots");
+
+  // Mark ignored classes as already visited.
+  std::vector<uint32_t> ignored_nodes;
+  for (llvm::StringRef ignore : ignore_classes) {
+    size_t colons = ignore.find("::");
+    std::string name = colons != llvm::StringRef::npos && colons > 0
+                           ? ignore.str()
+                           : ("blink::" + ignore).str();
+    uint32_t node = graph.FindNode(name);
+    if (node != kNone) {
+      ignored_nodes.push_back(node);
+    }
+  }
+
+  // Each root is checked independently. The reports are printed in the order
+  // of the roots once all are done.
+  const std::vector<uint32_t>& roots = graph.roots();
+  std::vector<std::string> reports(roots.size());
+  std::vector<char> errors(roots.size(), false);
+  std::atomic<size_t> next_root{0};
+  auto worker = [&] {
+    CycleFinder finder(graph, ignored_nodes, ignored_cycles);
+    for (size_t i = next_root++; i < roots.size(); i = next_root++) {
+      bool error = false;
+      reports[i] = finder.Check(roots[i], error);
+      errors[i] = error;
+    }
+  };
+  std::vector<std::thread> threads;
+  jobs = std::min<size_t>(jobs, std::max<size_t>(1, roots.size()));
+  for (unsigned i = 1; i < jobs; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (const std::string& report : reports) {
+    llvm::outs() << report;
+  }
+  return llvm::is_contained(errors, true) ? 1 : 0;
+}
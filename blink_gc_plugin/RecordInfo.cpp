@@ -4,6 +4,7 @@
 
 #include "RecordInfo.h"
 
+#include <algorithm>
 #include <string>
 
 #include "Config.h"
@@ -18,9 +19,26 @@ RecordInfo::RecordInfo(CXXRecordDecl* record, RecordCache* cache)
       name_(record->getName()),
       fields_need_tracing_(TracingStatus::Unknown()) {}
 
-RecordInfo::~RecordInfo() {
-  delete fields_;
-  delete bases_;
+RecordInfo::Fields::iterator RecordInfo::Fields::lower_bound(
+    FieldDecl* field) {
+  return std::lower_bound(fields_.begin(), fields_.end(), field->getBeginLoc(),
+                          [](const value_type& entry, SourceLocation loc) {
+                            return entry.first->getBeginLoc() < loc;
+                          });
+}
+
+RecordInfo::Fields::iterator RecordInfo::Fields::find(FieldDecl* field) {
+  iterator it = lower_bound(field);
+  if (it != end() && it->first->getBeginLoc() == field->getBeginLoc())
+    return it;
+  return end();
+}
+
+void RecordInfo::Fields::insert(FieldDecl* field, Edge* edge) {
+  iterator it = lower_bound(field);
+  if (it != end() && it->first->getBeginLoc() == field->getBeginLoc())
+    return;
+  fields_.insert(it, std::make_pair(field, FieldPoint(field, edge)));
 }
 
 bool RecordInfo::GetTemplateArgsInternal(
@@ -247,11 +265,10 @@ RecordInfo* RecordCache::Lookup(CXXRecordDecl* record) {
   if (record->hasDefinition()) {
     record = record->getDefinition();
   }
-  Cache::iterator it = cache_.find(record);
-  if (it != cache_.end())
-    return &it->second;
-  return &cache_.insert(std::make_pair(record, RecordInfo(record, this)))
-              .first->second;
+  RecordInfo*& info = cache_[record];
+  if (!info)
+    info = new (record_allocator_.Allocate()) RecordInfo(record, this);
+  return info;
 }
 
 bool RecordInfo::HasTypeAlias(std::string marker_name) const {
@@ -419,9 +436,9 @@ bool RecordInfo::IsConsideredAbstract() {
   return true;
 }
 
-RecordInfo::Bases* RecordInfo::CollectBases() {
+RecordInfo::Bases RecordInfo::CollectBases() {
   // Compute the collection locally to avoid inconsistent states.
-  Bases* bases = new Bases;
+  Bases bases;
   if (!record_->hasDefinition())
     return bases;
   for (CXXRecordDecl::base_class_iterator it = record_->bases_begin();
@@ -435,7 +452,7 @@ RecordInfo::Bases* RecordInfo::CollectBases() {
     TracingStatus status = info->InheritsTrace()
                                ? TracingStatus::Needed()
                                : TracingStatus::Unneeded();
-    bases->push_back(std::make_pair(base, BasePoint(spec, info, status)));
+    bases.push_back(std::make_pair(base, BasePoint(spec, info, status)));
   }
   return bases;
 }
@@ -446,9 +463,9 @@ RecordInfo::Fields& RecordInfo::GetFields() {
   return *fields_;
 }
 
-RecordInfo::Fields* RecordInfo::CollectFields() {
+RecordInfo::Fields RecordInfo::CollectFields() {
   // Compute the collection locally to avoid inconsistent states.
-  Fields* fields = new Fields;
+  Fields fields;
   if (!record_->hasDefinition())
     return fields;
   TracingStatus fields_status = TracingStatus::Unneeded();
@@ -467,7 +484,7 @@ RecordInfo::Fields* RecordInfo::CollectFields() {
       edge = CreateEdge(field->getType().getTypePtrOrNull());
     if (edge) {
       fields_status = fields_status.LUB(edge->NeedsTracing(Edge::kRecursive));
-      fields->insert(std::make_pair(field, FieldPoint(field, edge)));
+      fields.insert(field, edge);
     }
   }
   fields_need_tracing_ = fields_status;
@@ -640,7 +657,7 @@ Edge* RecordInfo::CreateEdgeFromOriginalType(const Type* type) {
   if (info) {
     on_heap = Config::IsGCCollection(info->name());
   }
-  return new Iterator(info, on_heap);
+  return cache_->AllocateEdge<Iterator>(info, on_heap);
 }
 
 Edge* RecordInfo::CreateEdge(const Type* type) {
@@ -650,13 +667,13 @@ Edge* RecordInfo::CreateEdge(const Type* type) {
 
   if (type->isPointerType() || type->isReferenceType()) {
     if (Edge* ptr = CreateEdge(type->getPointeeType().getTypePtrOrNull()))
-      return new RawPtr(ptr, type->isReferenceType());
+      return cache_->AllocateEdge<RawPtr>(ptr, type->isReferenceType());
     return 0;
   }
 
   if (type->isArrayType()) {
     if (Edge* ptr = CreateEdge(type->getPointeeOrArrayElementType())) {
-      return new ArrayEdge(ptr);
+      return cache_->AllocateEdge<ArrayEdge>(ptr);
     }
     return 0;
   }
@@ -672,7 +689,7 @@ Edge* RecordInfo::CreateEdge(const Type* type) {
 
   if (Config::IsRefOrWeakPtr(info->name()) && info->GetTemplateArgs(1, &args)) {
     if (Edge* ptr = CreateEdge(args[0]))
-      return new RefPtr(
+      return cache_->AllocateEdge<RefPtr>(
           ptr, Config::IsRefPtr(info->name()) ? Edge::kStrong : Edge::kWeak);
     return 0;
   }
@@ -685,7 +702,7 @@ Edge* RecordInfo::CreateEdge(const Type* type) {
     if (!isInStdNamespace(sema, ns))
       return 0;
     if (Edge* ptr = CreateEdge(args[0]))
-      return new UniquePtr(ptr);
+      return cache_->AllocateEdge<UniquePtr>(ptr);
     return 0;
   }
 
@@ -701,14 +718,14 @@ Edge* RecordInfo::CreateEdge(const Type* type) {
 
   if (Config::IsMember(info->name(), ns_name, info, &args)) {
     if (Edge* ptr = CreateEdge(args[0])) {
-      return new Member(ptr);
+      return cache_->AllocateEdge<Member>(ptr);
     }
     return 0;
   }
 
   if (Config::IsWeakMember(info->name(), ns_name, info, &args)) {
     if (Edge* ptr = CreateEdge(args[0]))
-      return new WeakMember(ptr);
+      return cache_->AllocateEdge<WeakMember>(ptr);
     return 0;
   }
 
@@ -717,9 +734,9 @@ Edge* RecordInfo::CreateEdge(const Type* type) {
       Config::IsCrossThreadPersistent(info->name(), ns_name, info, &args)) {
     if (Edge* ptr = CreateEdge(args[0])) {
       if (is_persistent)
-        return new Persistent(ptr);
+        return cache_->AllocateEdge<Persistent>(ptr);
       else
-        return new CrossThreadPersistent(ptr);
+        return cache_->AllocateEdge<CrossThreadPersistent>(ptr);
     }
     return 0;
   }
@@ -731,22 +748,23 @@ Edge* RecordInfo::CreateEdge(const Type* type) {
     size_t count = Config::CollectionDimension(info->name());
     if (!info->GetTemplateArgs(count, &args))
       return 0;
-    Collection* edge = new Collection(info, on_heap);
+    llvm::SmallVector<Edge*, 4> members;
     for (TemplateArgs::iterator it = args.begin(); it != args.end(); ++it) {
       if (Edge* member = CreateEdge(*it)) {
-        edge->members().push_back(member);
+        members.push_back(member);
       }
       // TODO: Handle the case where we fail to create an edge (eg, if the
       // argument is a primitive type or just not fully known yet).
     }
-    return edge;
+    return cache_->AllocateEdge<Collection>(info, on_heap,
+                                            cache_->AllocateEdges(members));
   }
 
   if (Config::IsTraceWrapperV8Reference(info->name(), ns_name, info, &args)) {
     if (Edge* ptr = CreateEdge(args[0]))
-      return new TraceWrapperV8Reference(ptr);
+      return cache_->AllocateEdge<TraceWrapperV8Reference>(ptr);
     return 0;
   }
 
-  return new Value(info);
+  return cache_->AllocateEdge<Value>(info);
 }
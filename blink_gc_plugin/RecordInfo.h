@@ -9,7 +9,8 @@
 #ifndef TOOLS_BLINK_GC_PLUGIN_RECORD_INFO_H_
 #define TOOLS_BLINK_GC_PLUGIN_RECORD_INFO_H_
 
-#include <map>
+#include <optional>
+#include <utility>
 #include <vector>
 
 #include "Edge.h"
@@ -17,6 +18,9 @@
 #include "clang/AST/AST.h"
 #include "clang/AST/CXXInheritance.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
 
 class RecordCache;
 
@@ -62,10 +66,8 @@ class FieldPoint : public GraphPoint {
 
  private:
   clang::FieldDecl* field_;
+  // Owned by the RecordCache.
   Edge* edge_;
-
-  friend class RecordCache;
-  void deleteEdge() { delete edge_; }
 };
 
 // Wrapper class to lazily collect information about a C++ record.
@@ -73,17 +75,33 @@ class RecordInfo {
  public:
   typedef std::vector<std::pair<clang::CXXRecordDecl*, BasePoint>> Bases;
 
-  struct FieldDeclCmp {
-    bool operator()(clang::FieldDecl* a, clang::FieldDecl *b) const {
-      return a->getBeginLoc() < b->getBeginLoc();
-    }
+  // The fields of a record, sorted by location. Records rarely have many
+  // fields, so a sorted vector is both smaller and faster than a tree.
+  class Fields {
+   public:
+    typedef std::pair<clang::FieldDecl*, FieldPoint> value_type;
+    typedef llvm::SmallVector<value_type, 4> Storage;
+    typedef Storage::iterator iterator;
+
+    iterator begin() { return fields_.begin(); }
+    iterator end() { return fields_.end(); }
+    bool empty() const { return fields_.empty(); }
+    size_t size() const { return fields_.size(); }
+
+    // Returns the field at the location of |field|, or end().
+    iterator find(clang::FieldDecl* field);
+
+    // Adds |field|, unless a field at the same location was already added.
+    void insert(clang::FieldDecl* field, Edge* edge);
+
+   private:
+    iterator lower_bound(clang::FieldDecl* field);
+
+    Storage fields_;
   };
-  typedef std::map<clang::FieldDecl*, FieldPoint, FieldDeclCmp> Fields;
 
   typedef std::vector<const clang::Type*> TemplateArgs;
 
-  ~RecordInfo();
-
   clang::CXXRecordDecl* record() const { return record_; }
   const std::string& name() const { return name_; }
   Fields& GetFields();
@@ -122,8 +140,8 @@ class RecordInfo {
 
   void walkBases();
 
-  Fields* CollectFields();
-  Bases* CollectBases();
+  Fields CollectFields();
+  Bases CollectBases();
   void DetermineTracingMethods();
   bool InheritsTrace();
 
@@ -142,8 +160,8 @@ class RecordInfo {
   clang::CXXRecordDecl* record_;
   const std::string name_;
   TracingStatus fields_need_tracing_;
-  Bases* bases_ = nullptr;
-  Fields* fields_ = nullptr;
+  std::optional<Bases> bases_;
+  std::optional<Fields> fields_;
 
   enum CachedBool { kFalse = 0, kTrue = 1, kNotComputed = 2 };
   CachedBool is_stack_allocated_ = kNotComputed;
@@ -192,25 +210,32 @@ class RecordCache {
     return Lookup(type.getTypePtr());
   }
 
-  ~RecordCache() {
-    for (Cache::iterator it = cache_.begin(); it != cache_.end(); ++it) {
-      if (!it->second.fields_)
-        continue;
-      for (RecordInfo::Fields::iterator fit = it->second.fields_->begin();
-        fit != it->second.fields_->end();
-        ++fit) {
-        fit->second.deleteEdge();
-      }
-    }
+  clang::CompilerInstance& instance() const { return instance_; }
+
+  // Allocates an edge that lives as long as the cache. Edges are never
+  // destroyed, so they must not own anything outside of the cache.
+  template <typename T, typename... Args>
+  T* AllocateEdge(Args&&... args) {
+    return new (edge_allocator_.Allocate<T>()) T(std::forward<Args>(args)...);
   }
 
-  clang::CompilerInstance& instance() const { return instance_; }
+  // Copies |edges| into memory that lives as long as the cache.
+  llvm::ArrayRef<Edge*> AllocateEdges(llvm::ArrayRef<Edge*> edges) {
+    return edges.copy(edge_allocator_);
+  }
 
  private:
   clang::CompilerInstance& instance_;
 
-  typedef std::map<clang::CXXRecordDecl*, RecordInfo> Cache;
-  Cache cache_;
+  // Blink translation units can see tens of thousands of records, so the
+  // RecordInfos and their edges are bump-allocated rather than individually
+  // allocated and freed.
+  llvm::SpecificBumpPtrAllocator<RecordInfo> record_allocator_;
+  llvm::BumpPtrAllocator edge_allocator_;
+
+  // Keyed by the definition of each record, or by the record itself if it has
+  // no definition yet.
+  llvm::DenseMap<const clang::CXXRecordDecl*, RecordInfo*> cache_;
 };
 
 #endif  // TOOLS_BLINK_GC_PLUGIN_RECORD_INFO_H_
@@ -3,6 +3,13 @@
 # Use of this source code is governed by a BSD-style license that can be
 # found in the LICENSE file.
 
+# blink_gc_process_graph (ProcessGraph.cpp) is a native implementation of the
+# cycle detection (-c) of this script, for whole-Blink graphs. Its output must
+# stay identical, so changes to the graph construction or the cycle detection
+# here need to be mirrored there. It also reads the *.graph.bin files of the
+# plugin's dump-graph-binary option, and can merge its inputs into a single
+# deduplicated database (--write-database), which this script cannot read.
+
 from __future__ import print_function
 import argparse, os, sys, json, subprocess, pickle
 
@@ -47,19 +47,72 @@ class BlinkGcPluginTest(plugin_testing.ClangPluginTest):
     return super(BlinkGcPluginTest, self).ProcessOneResult(test_name, actual)
 
 
+class BlinkGcBinaryGraphTest(BlinkGcPluginTest):
+  """Runs the tests that dump the object graph again, with the graph dumped by
+  dump-graph-binary and processed by the native blink_gc_process_graph tool
+  instead of process-graph.py. The expected results are the same."""
+
+  def __init__(self, process_graph_path, *args, **kwargs):
+    super(BlinkGcBinaryGraphTest, self).__init__(*args,
+                                                 filename_regex=r'^cycle_',
+                                                 **kwargs)
+    self._process_graph_path = process_graph_path
+
+  def RunOneTest(self, test_name, cmd):
+    cmd = ['dump-graph-binary' if arg == 'dump-graph' else arg for arg in cmd]
+    return super(BlinkGcBinaryGraphTest, self).RunOneTest(test_name, cmd)
+
+  def ProcessOneResult(self, test_name, actual):
+    if os.path.exists('%s.graph.bin' % test_name):
+      try:
+        actual = subprocess.check_output(
+            [self._process_graph_path, '-c',
+             '%s.graph.bin' % test_name],
+            stderr=subprocess.STDOUT,
+            universal_newlines=True)
+      except subprocess.CalledProcessError as e:
+        # Like process-graph.py, the tool fails if the graph has a cycle.
+        actual = e.output
+      finally:
+        os.remove('%s.graph.bin' % test_name)
+    return super(BlinkGcBinaryGraphTest,
+                 self).ProcessOneResult(test_name, actual)
+
+
 def main():
   parser = argparse.ArgumentParser()
   parser.add_argument(
       '--reset-results',
       action='store_true',
       help='If specified, overwrites the expected results in place.')
+  parser.add_argument(
+      '--process-graph-path',
+      help='The path to the blink_gc_process_graph binary. Defaults to the '
+      'one next to the clang binary; the tests of the binary graph dump are '
+      'skipped if there is none.')
   parser.add_argument('clang_path', help='The path to the clang binary.')
   args = parser.parse_args()
 
   dir_name = os.path.dirname(os.path.realpath(__file__))
+  clang_path = os.path.abspath(args.clang_path)
+  process_graph_path = args.process_graph_path
+  if not process_graph_path:
+    process_graph_path = os.path.join(os.path.dirname(clang_path),
+                                      'blink_gc_process_graph')
+    if sys.platform == 'win32':
+      process_graph_path += '.exe'
+    if not os.path.exists(process_graph_path):
+      process_graph_path = None
 
-  return BlinkGcPluginTest(dir_name, args.clang_path, ['blink-gc-plugin'],
-                           args.reset_results).Run()
+  failures = BlinkGcPluginTest(dir_name, clang_path, ['blink-gc-plugin'],
+                               args.reset_results).Run()
+  if process_graph_path:
+    failures += BlinkGcBinaryGraphTest(os.path.abspath(process_graph_path),
+                                       dir_name, clang_path,
+                                       ['blink-gc-plugin'], False).Run()
+  else:
+    print('blink_gc_process_graph not found; skipping the binary graph tests')
+  return failures
 
 
 if __name__ == '__main__':
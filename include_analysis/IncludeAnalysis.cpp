@@ -0,0 +1,384 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Computes the #include graph metrics behind include-analysis.html for
+// scripts/analyze_includes.py, which parses the build log and writes the graph
+// to stdin as whitespace-separated integers:
+//     <number of files> <number of roots>
+//     for each file: <size> <number of includes> <included file>...
+//     for each root: <file>
+// Files are numbered in the order they are given. The result is written to
+// stdout as a JSON object:
+//     {"tsizes": [...], "prevalence": [...], "asizes": [...],
+//      "esizes": [[...], ...]}
+// with one entry per file, and for "esizes" one entry per include, in input
+// order. See analyze_includes.py for their definitions.
+//
+// The added sizes come from the dominator tree of the graph reachable from
+// each root, in which every include edge is split by a node of its own, so
+// that an edge's added size is the size of the files it dominates. Roots, and
+// the files for transitive sizes, are processed in parallel.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace {
+
+// The include graph, with the includes of file |i| in
+// |targets[offsets[i]..offsets[i + 1])|. Include |e| is also node
+// |num_files() + e| of the graph the dominators are computed on, whose only
+// predecessor is |sources[e]| and whose only successor is |targets[e]|.
+struct Graph {
+  std::vector<uint64_t> sizes;
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> targets;
+  std::vector<uint32_t> sources;
+  // The includes of each file, i.e. the predecessors of the file's node.
+  std::vector<uint32_t> included_by_offsets;
+  std::vector<uint32_t> included_by;
+  std::vector<uint32_t> roots;
+
+  uint32_t num_files() const { return sizes.size(); }
+  uint32_t num_nodes() const { return sizes.size() + targets.size(); }
+};
+
+// Reads the next unsigned integer from |text|, or returns false.
+bool ReadNumber(llvm::StringRef& text, uint64_t& value) {
+  text = text.ltrim();
+  size_t length = text.find_first_not_of("0123456789");
+  if (length == 0)
+    return false;
+  if (text.substr(0, length).getAsInteger(10, value))
+    return false;
+  text = text.drop_front(std::min(length, text.size()));
+  return true;
+}
+
+bool ParseGraph(llvm::StringRef text, Graph& graph) {
+  uint64_t num_files, num_roots;
+  if (!ReadNumber(text, num_files) || !ReadNumber(text, num_roots))
+    return false;
+  graph.sizes.resize(num_files);
+  graph.offsets.push_back(0);
+  for (uint64_t i = 0; i < num_files; ++i) {
+    uint64_t num_includes;
+    if (!ReadNumber(text, graph.sizes[i]) || !ReadNumber(text, num_includes))
+      return false;
+    for (uint64_t j = 0; j < num_includes; ++j) {
+      uint64_t target;
+      if (!ReadNumber(text, target) || target >= num_files)
+        return false;
+      graph.targets.push_back(target);
+      graph.sources.push_back(i);
+    }
+    graph.offsets.push_back(graph.targets.size());
+  }
+  for (uint64_t i = 0; i < num_roots; ++i) {
+    uint64_t root;
+    if (!ReadNumber(text, root) || root >= num_files)
+      return false;
+    graph.roots.push_back(root);
+  }
+
+  graph.included_by_offsets.assign(num_files + 1, 0);
+  for (uint32_t target : graph.targets)
+    ++graph.included_by_offsets[target + 1];
+  for (uint64_t i = 0; i < num_files; ++i)
+    graph.included_by_offsets[i + 1] += graph.included_by_offsets[i];
+  graph.included_by.resize(graph.targets.size());
+  std::vector<uint32_t> next = graph.included_by_offsets;
+  for (uint32_t e = 0; e < graph.targets.size(); ++e)
+    graph.included_by[next[graph.targets[e]]++] = e;
+  return true;
+}
+
+// Runs |work| for each index in [0, count) on |jobs| threads.
+template <typename Work>
+void ParallelFor(size_t count, unsigned jobs, const Work& work) {
+  std::atomic<size_t> next_index{0};
+  auto worker = [&] {
+    auto state = work.NewState();
+    for (size_t i = next_index++; i < count; i = next_index++)
+      work.Run(i, state);
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < std::min<size_t>(jobs, count); ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+// Sums the sizes of the files reachable from each file.
+class TransitiveSizes {
+ public:
+  struct State {
+    // The files visited by the walk with the same stamp.
+    std::vector<uint32_t> visited;
+    uint32_t stamp = 0;
+    std::vector<uint32_t> stack;
+  };
+
+  TransitiveSizes(const Graph& graph, std::vector<uint64_t>& result)
+      : graph_(graph), result_(result) {}
+
+  State NewState() const {
+    State state;
+    state.visited.assign(graph_.num_files(), 0);
+    return state;
+  }
+
+  void Run(uint32_t file, State& state) const {
+    ++state.stamp;
+    uint64_t size = 0;
+    state.stack.assign(1, file);
+    state.visited[file] = state.stamp;
+    while (!state.stack.empty()) {
+      uint32_t v = state.stack.back();
+      state.stack.pop_back();
+      size += graph_.sizes[v];
+      for (uint32_t e = graph_.offsets[v]; e < graph_.offsets[v + 1]; ++e) {
+        uint32_t w = graph_.targets[e];
+        if (state.visited[w] != state.stamp) {
+          state.visited[w] = state.stamp;
+          state.stack.push_back(w);
+        }
+      }
+    }
+    // Each thread writes distinct elements.
+    result_[file] = size;
+  }
+
+ private:
+  const Graph& graph_;
+  std::vector<uint64_t>& result_;
+};
+
+// Adds up, for each root, how many roots reach each file, and the size of the
+// files dominated by each node. The dominators are computed with the
+// algorithm of Cooper, Harvey and Kennedy, "A Simple, Fast Dominance
+// Algorithm", which converges in two passes on the mostly acyclic include
+// graph.
+class AddedSizes {
+ public:
+  static constexpr uint32_t kUnvisited = UINT32_MAX;
+
+  struct State {
+    // The post-order number of each node, or kUnvisited.
+    std::vector<uint32_t> number;
+    std::vector<uint32_t> idom;
+    // The nodes in post-order.
+    std::vector<uint32_t> order;
+    std::vector<uint64_t> subtree_size;
+    // Pairs of a node and the index of its next successor.
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+  };
+
+  AddedSizes(const Graph& graph,
+             std::atomic<uint32_t>* prevalence,
+             std::atomic<uint64_t>* added_sizes)
+      : graph_(graph), prevalence_(prevalence), added_sizes_(added_sizes) {}
+
+  State NewState() const {
+    State state;
+    state.number.assign(graph_.num_nodes(), kUnvisited);
+    state.idom.assign(graph_.num_nodes(), kUnvisited);
+    state.subtree_size.assign(graph_.num_nodes(), 0);
+    return state;
+  }
+
+  void Run(size_t root_index, State& state) const {
+    uint32_t root = graph_.roots[root_index];
+    NumberNodes(root, state);
+
+    // The nodes in reverse post-order, skipping the root, which comes last in
+    // post-order.
+    const std::vector<uint32_t>& order = state.order;
+    state.idom[root] = root;
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (size_t i = order.size() - 1; i-- > 0;) {
+        uint32_t v = order[i];
+        uint32_t new_idom = kUnvisited;
+        ForEachPredecessor(v, [&](uint32_t p) {
+          if (state.number[p] == kUnvisited || state.idom[p] == kUnvisited)
+            return;
+          new_idom = new_idom == kUnvisited ? p : Intersect(p, new_idom, state);
+        });
+        if (state.idom[v] != new_idom) {
+          state.idom[v] = new_idom;
+          changed = true;
+        }
+      }
+    }
+
+    // A node's immediate dominator comes after it in post-order, so the sizes
+    // of its subtree in the dominator tree are complete when it is reached.
+    for (uint32_t v : order) {
+      if (v < graph_.num_files()) {
+        state.subtree_size[v] += graph_.sizes[v];
+        ++prevalence_[v];
+      }
+      if (v != root)
+        state.subtree_size[state.idom[v]] += state.subtree_size[v];
+      added_sizes_[v] += state.subtree_size[v];
+    }
+
+    for (uint32_t v : order) {
+      state.number[v] = kUnvisited;
+      state.idom[v] = kUnvisited;
+      state.subtree_size[v] = 0;
+    }
+  }
+
+ private:
+  uint32_t NumSuccessors(uint32_t v) const {
+    if (v < graph_.num_files())
+      return graph_.offsets[v + 1] - graph_.offsets[v];
+    return 1;
+  }
+
+  uint32_t Successor(uint32_t v, uint32_t i) const {
+    if (v < graph_.num_files())
+      return graph_.num_files() + graph_.offsets[v] + i;
+    return graph_.targets[v - graph_.num_files()];
+  }
+
+  template <typename Function>
+  void ForEachPredecessor(uint32_t v, const Function& function) const {
+    if (v < graph_.num_files()) {
+      for (uint32_t i = graph_.included_by_offsets[v];
+           i < graph_.included_by_offsets[v + 1]; ++i) {
+        function(graph_.num_files() + graph_.included_by[i]);
+      }
+    } else {
+      function(graph_.sources[v - graph_.num_files()]);
+    }
+  }
+
+  // Numbers the nodes reachable from |root| in post-order, without recursing
+  // as deep as the include stack.
+  void NumberNodes(uint32_t root, State& state) const {
+    state.order.clear();
+    state.stack.assign(1, {root, 0});
+    // Marks the node as being visited until it gets its number.
+    state.number[root] = kUnvisited - 1;
+    while (!state.stack.empty()) {
+      auto& [v, next_successor] = state.stack.back();
+      uint32_t num_successors = NumSuccessors(v);
+      while (next_successor < num_successors &&
+             state.number[Successor(v, next_successor)] != kUnvisited) {
+        ++next_successor;
+      }
+      if (next_successor == num_successors) {
+        state.number[v] = state.order.size();
+        state.order.push_back(v);
+        state.stack.pop_back();
+        continue;
+      }
+      uint32_t successor = Successor(v, next_successor++);
+      state.number[successor] = kUnvisited - 1;
+      state.stack.push_back({successor, 0});
+    }
+  }
+
+  uint32_t Intersect(uint32_t a, uint32_t b, const State& state) const {
+    while (a != b) {
+      while (state.number[a] < state.number[b])
+        a = state.idom[a];
+      while (state.number[b] < state.number[a])
+        b = state.idom[b];
+    }
+    return a;
+  }
+
+  const Graph& graph_;
+  std::atomic<uint32_t>* prevalence_;
+  std::atomic<uint64_t>* added_sizes_;
+};
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  llvm::InitLLVM init_llvm(argc, argv);
+  llvm::cl::opt<unsigned> jobs(
+      "jobs", llvm::cl::init(std::thread::hardware_concurrency()),
+      llvm::cl::desc("Number of threads"));
+  llvm::cl::opt<bool> sizes_only(
+      "sizes-only", llvm::cl::init(false),
+      llvm::cl::desc("Only compute the transitive sizes"));
+  llvm::cl::ParseCommandLineOptions(
+      argc, argv, "Computes #include graph metrics for analyze_includes.py\n");
+  unsigned num_jobs = std::max(1u, jobs.getValue());
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> input =
+      llvm::MemoryBuffer::getSTDIN();
+  if (!input) {
+    llvm::errs() << "Cannot read stdin: " << input.getError().message()
+                 << "\n";
+    return 1;
+  }
+  Graph graph;
+  if (!ParseGraph((*input)->getBuffer(), graph)) {
+    llvm::errs() << "Malformed include graph\n";
+    return 1;
+  }
+  input->reset();
+
+  std::vector<uint64_t> trans_sizes(graph.num_files());
+  TransitiveSizes transitive_sizes(graph, trans_sizes);
+  ParallelFor(graph.num_files(), num_jobs, transitive_sizes);
+
+  // Value-initialized, so zero.
+  std::unique_ptr<std::atomic<uint32_t>[]> prevalence(
+      new std::atomic<uint32_t>[graph.num_files()]());
+  std::unique_ptr<std::atomic<uint64_t>[]> added_sizes(
+      new std::atomic<uint64_t>[graph.num_nodes()]());
+  if (!sizes_only) {
+    AddedSizes added(graph, prevalence.get(), added_sizes.get());
+    ParallelFor(graph.roots.size(), num_jobs, added);
+  }
+
+  llvm::raw_ostream& out = llvm::outs();
+  llvm::json::OStream json(out);
+  json.object([&] {
+    json.attributeArray("tsizes", [&] {
+      for (uint64_t size : trans_sizes)
+        json.value(size);
+    });
+    if (sizes_only)
+      return;
+    json.attributeArray("prevalence", [&] {
+      for (uint32_t i = 0; i < graph.num_files(); ++i)
+        json.value(static_cast<uint64_t>(prevalence[i]));
+    });
+    json.attributeArray("asizes", [&] {
+      for (uint32_t i = 0; i < graph.num_files(); ++i)
+        json.value(static_cast<uint64_t>(added_sizes[i]));
+    });
+    json.attributeArray("esizes", [&] {
+      for (uint32_t i = 0; i < graph.num_files(); ++i) {
+        json.array([&] {
+          for (uint32_t e = graph.offsets[i]; e < graph.offsets[i + 1]; ++e)
+            json.value(static_cast<uint64_t>(
+                added_sizes[graph.num_files() + e]));
+        });
+      }
+    });
+  });
+  out << "\n";
+  return 0;
+}
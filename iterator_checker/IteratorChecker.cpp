@@ -2,12 +2,21 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 #include <cstdint>
+#include <cstring>
 #include <memory>
-
+#include <optional>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "CacheKey.h"
+#include "SharedMatchFinder.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Decl.h"
 #include "clang/AST/Expr.h"
 #include "clang/AST/OperationKinds.h"
+#include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/ASTMatchers/ASTMatchers.h"
 #include "clang/Analysis/FlowSensitive/AdornedCFG.h"
 #include "clang/Analysis/FlowSensitive/DataflowAnalysis.h"
@@ -16,10 +25,16 @@
 #include "clang/Analysis/FlowSensitive/NoopLattice.h"
 #include "clang/Analysis/FlowSensitive/Value.h"
 #include "clang/Analysis/FlowSensitive/WatchedLiteralsSolver.h"
+#include "clang/Basic/Version.h"
 #include "clang/Frontend/FrontendPluginRegistry.h"
+#include "clang/Lex/Lexer.h"
 #include "clang/Tooling/Transformer/Stencil.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/TimeProfiler.h"
 
 // This clang plugin check for iterators used after they have been
@@ -38,6 +53,33 @@ const char kInvalidIteratorComparison[] =
 const char kIteratorMismatch[] =
     "[iterator-checker] Potentially iterator mismatch.";
 
+// Names of the plugin arguments taking a value.
+const char kCacheDirArgPrefix[] = "cache-dir=";
+const char kMaxBlockVisitsArgPrefix[] = "max-block-visits=";
+const char kSolverWorkLimitArgPrefix[] = "solver-work-limit=";
+
+// Must be changed whenever the analysis changes, to invalidate the cached
+// results of the previous version.
+const char kCacheVersion[] = "1";
+
+struct IteratorCheckerOptions {
+  // Directory where the functions found clean are recorded, so that later
+  // compiles can skip them. Disabled if empty. See FunctionResultCache.
+  std::string cache_dir;
+
+  // The budget of the analysis of each function: the number of visits of CFG
+  // blocks, and the work limit of the solver (0 for none). A function that
+  // exceeds its budget is counted in the stats.
+  int32_t max_block_visits = clang::dataflow::kDefaultMaxBlockVisits;
+  int64_t solver_work_limit = 0;
+
+  // Print the number of functions analyzed, skipped and over budget.
+  bool print_stats = false;
+
+  // The arguments that affect the result of the analysis.
+  std::string args;
+};
+
 // To understand C++ code, we need a way to encode what is an iterator and what
 // are the functions that might invalidate them.
 enum AnnotationType : uint8_t {
@@ -714,9 +756,12 @@ class InvalidIteratorAnalysis
     : public clang::dataflow::DataflowAnalysis<InvalidIteratorAnalysis,
                                                clang::dataflow::NoopLattice> {
  public:
-  InvalidIteratorAnalysis(const clang::FunctionDecl* func,
-                          clang::DiagnosticsEngine& diagnostic)
-      : DataflowAnalysis(func->getASTContext()), diagnostic_(diagnostic) {}
+  // The errors found, in the order they were found.
+  using Reports =
+      std::vector<std::pair<clang::SourceLocation, llvm::StringRef>>;
+
+  explicit InvalidIteratorAnalysis(const clang::FunctionDecl* func)
+      : DataflowAnalysis(func->getASTContext()) {}
 
   // Used by DataflowAnalysis template.
   clang::dataflow::NoopLattice initialElement() const {
@@ -744,6 +789,8 @@ class InvalidIteratorAnalysis
     };
   }
 
+  const Reports& reports() const { return reports_; }
+
  private:
   // Stmt: https://clang.llvm.org/doxygen/classclang_1_1Stmt.html
   void Transfer(const clang::Stmt& stmt, clang::dataflow::Environment& env) {
@@ -1921,17 +1968,15 @@ class InvalidIteratorAnalysis
       return;
     }
     reported_source_locations_.insert({location, error_message});
-
-    diagnostic_.Report(
-        location, diagnostic_.getCustomDiagID(
-                      clang::DiagnosticsEngine::Level::Error, error_message));
+    reports_.emplace_back(location, error_message);
   }
 
   // The check model that will handle Chromium's `CHECK` macros.
   clang::dataflow::ChromiumCheckModel check_model_;
 
-  // The diagnostic engine that will issue potential errors.
-  clang::DiagnosticsEngine& diagnostic_;
+  // The errors to report. They are only emitted once the analysis is done, as
+  // it can give up before.
+  Reports reports_;
 
   // The iterator types found along the way.
   // This part is kind of tricky for now, because we'd like to hard code these.
@@ -1952,9 +1997,213 @@ class InvalidIteratorAnalysis
       reported_source_locations_;
 };
 
+// Returns a description of the hardcoded annotations, which the results of the
+// analysis depend on.
+std::string DescribeAnnotationTables() {
+  std::string description;
+  llvm::raw_string_ostream out(description);
+  auto describe = [&](const Annotations& annotations) {
+    out << '[';
+    for (const Annotation& annotation : annotations) {
+      out << static_cast<unsigned>(annotation.type) << ':'
+          << annotation.identifier << ',';
+    }
+    out << ']';
+  };
+  auto describe_function = [&](const GroupedFunctionAnnotation& function) {
+    describe(function.function_annotations);
+    describe(function.return_annotations);
+    for (const Annotations& arg : function.args_annotations) {
+      describe(arg);
+    }
+    out << ';';
+  };
+  // The maps are described in the order of their keys, which unlike the order
+  // of iteration doesn't depend on the hash function.
+  auto sorted_keys = [](const auto& map) {
+    std::vector<llvm::StringRef> keys;
+    for (const auto& entry : map) {
+      keys.push_back(entry.first);
+    }
+    llvm::sort(keys);
+    return keys;
+  };
+
+  for (llvm::StringRef name : sorted_keys(g_annotations)) {
+    out << name << '=' << static_cast<unsigned>(g_annotations[name]) << '\n';
+  }
+  for (llvm::StringRef type : sorted_keys(g_types_annotations)) {
+    out << type << '=';
+    describe(g_types_annotations[type]);
+    out << '\n';
+  }
+  for (llvm::StringRef function : sorted_keys(g_functions_annotations)) {
+    out << function << '=';
+    describe_function(g_functions_annotations[function]);
+    out << '\n';
+  }
+  for (llvm::StringRef type : sorted_keys(g_member_function_annotations)) {
+    auto& functions = g_member_function_annotations[type];
+    for (llvm::StringRef function : sorted_keys(functions)) {
+      out << type << "::" << function << '=';
+      describe_function(functions[function]);
+      out << '\n';
+    }
+  }
+  return description;
+}
+
+// Remembers, across compiles, the functions whose analysis found no error, so
+// that compiles of files containing them later can skip analyzing them again.
+//
+// Each entry is a file in the cache directory, named by a hash of:
+// - the clang version, the analysis version and its arguments,
+// - the hardcoded annotations,
+// - the tokens of the function,
+// - the tokens of the declarations the function's body refers to, which
+//   carry the annotations of the functions it calls.
+// Entries are written to a temporary file and renamed into place, so
+// concurrent compiles can share a directory.
+//
+// This doesn't account for everything the analysis depends on, such as the
+// definition of the macros used by the function, which is why the cache is
+// opt-in.
+class FunctionResultCache {
+ public:
+  FunctionResultCache(std::string directory, llvm::StringRef args)
+      : directory_(std::move(directory)),
+        configuration_(clang::getClangFullVersion() + "\n" + kCacheVersion +
+                       "\n" + args.str() + DescribeAnnotationTables()) {}
+
+  // Returns the path of the entry of `func`, or an empty string if `func`
+  // can't be cached.
+  std::string GetEntryPath(const clang::FunctionDecl& func) {
+    const clang::ASTContext& context = func.getASTContext();
+    chrome_plugin_host::CacheKey key;
+    key.Add(configuration_);
+    key.Add(func.getQualifiedNameAsString());
+    key.Add(func.getType().getAsString());
+    if (!AddTokens(key, func.getSourceRange(), context)) {
+      return std::string();
+    }
+
+    ReferencedDecls referenced;
+    referenced.TraverseStmt(func.getBody());
+    for (const clang::NamedDecl* decl : referenced.decls) {
+      key.Add(decl->getQualifiedNameAsString());
+      clang::SourceRange range = decl->getSourceRange();
+      // The body of a function is irrelevant to its callers.
+      if (const auto* callee = clang::dyn_cast<clang::FunctionDecl>(decl)) {
+        if (callee->doesThisDeclarationHaveABody()) {
+          range.setEnd(callee->getBody()->getBeginLoc());
+        }
+      }
+      // Implicit and builtin declarations have no tokens, only a name.
+      AddTokens(key, range, context);
+    }
+
+    llvm::SmallString<256> path(directory_);
+    llvm::sys::path::append(path, key.Finish());
+    return std::string(path);
+  }
+
+  static bool IsClean(llvm::StringRef entry_path) {
+    return llvm::sys::fs::exists(entry_path);
+  }
+
+  void AddClean(llvm::StringRef entry_path) {
+    if (!created_directory_) {
+      if (llvm::sys::fs::create_directories(directory_)) {
+        return;
+      }
+      created_directory_ = true;
+    }
+    int fd;
+    llvm::SmallString<256> temp_path;
+    if (llvm::sys::fs::createUniqueFile(entry_path + "-%%%%%%%%.tmp", fd,
+                                        temp_path)) {
+      return;
+    }
+    {
+      llvm::raw_fd_ostream out(fd, /*shouldClose=*/true);
+      out << "clean\n";
+    }
+    if (llvm::sys::fs::rename(temp_path, entry_path)) {
+      llvm::sys::fs::remove(temp_path);
+    }
+  }
+
+ private:
+  // Collects the declarations referred to by a function body, in order.
+  struct ReferencedDecls : clang::RecursiveASTVisitor<ReferencedDecls> {
+    bool VisitDeclRefExpr(clang::DeclRefExpr* expr) {
+      Add(expr->getDecl());
+      return true;
+    }
+    bool VisitMemberExpr(clang::MemberExpr* expr) {
+      Add(expr->getMemberDecl());
+      return true;
+    }
+    bool VisitCXXConstructExpr(clang::CXXConstructExpr* expr) {
+      Add(expr->getConstructor());
+      return true;
+    }
+
+    void Add(const clang::NamedDecl* decl) {
+      // Local declarations are part of the function's own tokens.
+      if (decl && !decl->getParentFunctionOrMethod() &&
+          seen.insert(decl).second) {
+        decls.push_back(decl);
+      }
+    }
+
+    llvm::DenseSet<const clang::NamedDecl*> seen;
+    std::vector<const clang::NamedDecl*> decls;
+  };
+
+  // Adds the tokens in `range`, ignoring whitespace and comments. Returns
+  // false if the range is not in a file.
+  static bool AddTokens(chrome_plugin_host::CacheKey& key,
+                        clang::SourceRange range,
+                        const clang::ASTContext& context) {
+    const clang::SourceManager& sm = context.getSourceManager();
+    const clang::LangOptions& lang_opts = context.getLangOpts();
+    clang::CharSourceRange chars = clang::Lexer::getAsCharRange(
+        sm.getExpansionRange(range), sm, lang_opts);
+    bool invalid = false;
+    // The lexer needs a null-terminated buffer.
+    const std::string text =
+        clang::Lexer::getSourceText(chars, sm, lang_opts, &invalid).str();
+    if (invalid || chars.getBegin().isInvalid()) {
+      return false;
+    }
+    clang::Lexer lexer(chars.getBegin(), lang_opts, text.data(), text.data(),
+                       text.data() + text.size());
+    const unsigned begin = sm.getFileOffset(chars.getBegin());
+    clang::Token token;
+    for (lexer.LexFromRawLexer(token); token.isNot(clang::tok::eof);
+         lexer.LexFromRawLexer(token)) {
+      key.Add(llvm::StringRef(text).substr(
+          sm.getFileOffset(token.getLocation()) - begin, token.getLength()));
+    }
+    return true;
+  }
+
+  const std::string directory_;
+  const std::string configuration_;
+  bool created_directory_ = false;
+};
+
 class IteratorInvalidationCheck
     : public clang::ast_matchers::MatchFinder::MatchCallback {
  public:
+  explicit IteratorInvalidationCheck(const IteratorCheckerOptions& options)
+      : options_(options) {
+    if (!options_.cache_dir.empty()) {
+      cache_.emplace(options_.cache_dir, options_.args);
+    }
+  }
+
   // The checks will performed on every function implemented in the main file.
   void Register(clang::ast_matchers::MatchFinder& finder) {
     using namespace clang::ast_matchers;
@@ -1976,7 +2225,17 @@ class IteratorInvalidationCheck
       return;
     }
 
+    std::string cache_entry;
+    if (cache_) {
+      cache_entry = cache_->GetEntryPath(*func);
+      if (!cache_entry.empty() && cache_->IsClean(cache_entry)) {
+        ++num_skipped_;
+        return;
+      }
+    }
+
     InfoStream() << "[FUNCTION] " << func->getQualifiedNameAsString() << '\n';
+    ++num_analyzed_;
     auto control_flow_context = clang::dataflow::AdornedCFG::build(
         *func, *func->getBody(), *result.Context);
     if (!control_flow_context) {
@@ -1984,24 +2243,79 @@ class IteratorInvalidationCheck
       return;
     }
 
-    auto solver = std::make_unique<clang::dataflow::WatchedLiteralsSolver>();
+    auto solver =
+        options_.solver_work_limit > 0
+            ? std::make_unique<clang::dataflow::WatchedLiteralsSolver>(
+                  options_.solver_work_limit)
+            : std::make_unique<clang::dataflow::WatchedLiteralsSolver>();
+    const clang::dataflow::WatchedLiteralsSolver& solver_state = *solver;
     clang::dataflow::DataflowAnalysisContext analysis_context(
         std::move(solver));
     clang::dataflow::Environment environment(analysis_context, *func);
 
-    InvalidIteratorAnalysis analysis(func,
-                                     result.SourceManager->getDiagnostics());
+    InvalidIteratorAnalysis analysis(func);
 
     analysis_context.setSyntheticFieldCallback(
         std::bind(&InvalidIteratorAnalysis::GetSyntheticFields, &analysis,
                   std::placeholders::_1));
 
+    bool over_budget = false;
     auto analysis_result =
-        runDataflowAnalysis(*control_flow_context, analysis, environment);
+        runDataflowAnalysis(*control_flow_context, analysis, environment,
+                            /*PostAnalysisCallbacks=*/{},
+                            options_.max_block_visits);
     if (!analysis_result) {
       // just ignore that for now!
       handleAllErrors(analysis_result.takeError(),
-                      [](const llvm::StringError& E) {});
+                      [&](const llvm::StringError& E) {
+                        // The analysis gives up after `max_block_visits`.
+                        over_budget |= E.convertToErrorCode() ==
+                                       std::errc::timed_out;
+                      });
+    }
+
+    clang::DiagnosticsEngine& diagnostic =
+        result.SourceManager->getDiagnostics();
+    bool reports_dropped = false;
+    if (solver_state.reachedLimit()) {
+      over_budget = true;
+      // Once the solver runs out of the work it was given, it can't prove
+      // that iterators are valid, so the errors found may be false positives.
+      reports_dropped =
+          options_.solver_work_limit > 0 && !analysis.reports().empty();
+    }
+    if (reports_dropped) {
+      diagnostic.Report(
+          func->getLocation(),
+          diagnostic.getCustomDiagID(
+              clang::DiagnosticsEngine::Level::Note,
+              "[iterator-checker] Errors in %0 not reported: the solver "
+              "reached its work limit (solver-work-limit)."))
+          << func;
+    } else {
+      for (const auto& [location, error_message] : analysis.reports()) {
+        diagnostic.Report(location,
+                          diagnostic.getCustomDiagID(
+                              clang::DiagnosticsEngine::Level::Error, "%0"))
+            << error_message;
+      }
+    }
+
+    if (over_budget) {
+      InfoStream() << "[OVER BUDGET] " << func->getQualifiedNameAsString()
+                   << '\n';
+      ++num_over_budget_;
+    } else if (!cache_entry.empty() && analysis.reports().empty()) {
+      cache_->AddClean(cache_entry);
+    }
+  }
+
+  void onEndOfTranslationUnit() final {
+    if (options_.print_stats) {
+      llvm::errs() << "[iterator-checker] " << num_analyzed_
+                   << " functions analyzed, " << num_skipped_
+                   << " skipped as clean in the cache, " << num_over_budget_
+                   << " over budget\n";
     }
   }
 
@@ -2059,21 +2373,39 @@ class IteratorInvalidationCheck
 
     return true;
   }
+
+ private:
+  const IteratorCheckerOptions options_;
+  std::optional<FunctionResultCache> cache_;
+
+  unsigned num_analyzed_ = 0;
+  unsigned num_skipped_ = 0;
+  unsigned num_over_budget_ = 0;
 };
 
 class IteratorInvalidationConsumer : public clang::ASTConsumer {
  public:
-  IteratorInvalidationConsumer(clang::CompilerInstance& instance) {}
+  IteratorInvalidationConsumer(clang::CompilerInstance& instance,
+                               const IteratorCheckerOptions& options)
+      : checker_(options) {}
+
+  void Initialize(clang::ASTContext& context) final {
+    shared_match_finder_ = chrome_plugin_host::SharedMatchFinder::Join(context);
+  }
 
   void HandleTranslationUnit(clang::ASTContext& context) final {
     llvm::TimeTraceScope TimeScope(
         "IteratorInvalidationConsumer::HandleTranslationUnit");
 
-    IteratorInvalidationCheck checker;
-    clang::ast_matchers::MatchFinder match_finder;
-    checker.Register(match_finder);
-    match_finder.matchAST(context);
+    checker_.Register(shared_match_finder_->finder());
+    shared_match_finder_->Run();
   }
+
+ private:
+  std::shared_ptr<chrome_plugin_host::SharedMatchFinder> shared_match_finder_;
+  // Registered with `shared_match_finder_`, which may run it after
+  // HandleTranslationUnit() returns.
+  IteratorInvalidationCheck checker_;
 };
 
 class IteratorInvalidationPluginAction : public clang::PluginASTAction {
@@ -2086,7 +2418,7 @@ class IteratorInvalidationPluginAction : public clang::PluginASTAction {
       clang::CompilerInstance& instance,
       llvm::StringRef ref) final {
     llvm::EnablePrettyStackTrace();
-    return std::make_unique<IteratorInvalidationConsumer>(instance);
+    return std::make_unique<IteratorInvalidationConsumer>(instance, options_);
   }
 
   PluginASTAction::ActionType getActionType() final {
@@ -2095,8 +2427,39 @@ class IteratorInvalidationPluginAction : public clang::PluginASTAction {
 
   bool ParseArgs(const clang::CompilerInstance&,
                  const std::vector<std::string>& args) final {
+    for (llvm::StringRef arg : args) {
+      if (arg.starts_with(kCacheDirArgPrefix)) {
+        options_.cache_dir = arg.substr(strlen(kCacheDirArgPrefix)).str();
+        continue;
+      }
+      options_.args += arg;
+      options_.args += '\n';
+
+      if (arg.starts_with(kMaxBlockVisitsArgPrefix)) {
+        if (arg.substr(strlen(kMaxBlockVisitsArgPrefix))
+                .getAsInteger(10, options_.max_block_visits) ||
+            options_.max_block_visits <= 0) {
+          llvm::errs() << "Invalid iterator-checker argument: " << arg << "\n";
+          return false;
+        }
+      } else if (arg.starts_with(kSolverWorkLimitArgPrefix)) {
+        if (arg.substr(strlen(kSolverWorkLimitArgPrefix))
+                .getAsInteger(10, options_.solver_work_limit) ||
+            options_.solver_work_limit < 0) {
+          llvm::errs() << "Invalid iterator-checker argument: " << arg << "\n";
+          return false;
+        }
+      } else if (arg == "print-stats") {
+        options_.print_stats = true;
+      } else {
+        llvm::errs() << "Unknown iterator-checker argument: " << arg << "\n";
+        return false;
+      }
+    }
     return true;
   }
+
+  IteratorCheckerOptions options_;
 };
 
 static clang::FrontendPluginRegistry::Add<IteratorInvalidationPluginAction> X(
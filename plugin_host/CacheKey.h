@@ -0,0 +1,46 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_CLANG_PLUGIN_HOST_CACHEKEY_H_
+#define TOOLS_CLANG_PLUGIN_HOST_CACHEKEY_H_
+
+#include <cstdint>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MD5.h"
+
+namespace chrome_plugin_host {
+
+// Builds the key of an on-disk cache entry from a sequence of strings, as the
+// MD5 of the strings with each one prefixed by its length. Without the lengths,
+// {"ab", "c"} and {"a", "bc"} would hash the same bytes, and a separator byte
+// would not help for strings that can contain it, such as file contents.
+//
+// Used by the plugins' caches and by the rewriters' precompiled prefix header.
+class CacheKey {
+ public:
+  void Add(llvm::StringRef part) {
+    uint8_t size[sizeof(uint64_t)];
+    llvm::support::endian::write64le(size, part.size());
+    hash_.update(llvm::ArrayRef<uint8_t>(size));
+    hash_.update(part);
+  }
+
+  // Returns the key as 32 hex digits. Call once, after adding every part.
+  llvm::SmallString<32> Finish() {
+    llvm::MD5::MD5Result result;
+    hash_.final(result);
+    return result.digest();
+  }
+
+ private:
+  llvm::MD5 hash_;
+};
+
+}  // namespace chrome_plugin_host
+
+#endif  // TOOLS_CLANG_PLUGIN_HOST_CACHEKEY_H_
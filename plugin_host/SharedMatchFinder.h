@@ -0,0 +1,103 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_CLANG_PLUGIN_HOST_SHAREDMATCHFINDER_H_
+#define TOOLS_CLANG_PLUGIN_HOST_SHAREDMATCHFINDER_H_
+
+#include <cassert>
+#include <memory>
+
+#include "clang/AST/ASTContext.h"
+#include "clang/ASTMatchers/ASTMatchFinder.h"
+#include "clang/Basic/Diagnostic.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/TimeProfiler.h"
+
+// Lets the Chromium plugins loaded into a compilation share one
+// MatchFinder::matchAST() walk of the translation unit, instead of each plugin
+// running a MatchFinder of its own.
+//
+// A plugin's ASTConsumer calls Join() from Initialize(). From
+// HandleTranslationUnit() it adds its matchers to finder(), if it has any to
+// run, and then calls Run(). The matchers of all the plugins run when the last
+// plugin that joined calls Run(), so match callbacks must stay alive until
+// then, e.g. by being owned by the ASTConsumer.
+//
+// The plugins that use it add this directory to clang's include path. They are
+// all compiled into clang, so they must share this one definition of these
+// inline functions.
+//
+// Only the MatchFinders are merged. The RecursiveASTVisitor walks of
+// find-bad-constructs and of blink-gc's CollectVisitor still traverse the
+// translation unit on their own.
+// TODO: Run those visitors from a shared traversal as well.
+namespace chrome_plugin_host {
+
+class SharedMatchFinder {
+ public:
+  explicit SharedMatchFinder(clang::ASTContext& context)
+      : context_(context), diagnostics_(context.getDiagnostics()) {}
+
+  SharedMatchFinder(const SharedMatchFinder&) = delete;
+  SharedMatchFinder& operator=(const SharedMatchFinder&) = delete;
+
+  // A plugin that joined and never called Run() keeps the matchers of every
+  // plugin from running, so report it rather than silently skip the checks.
+  // The AST is gone by now, but the DiagnosticsEngine outlives it. Consumers
+  // are leaked under -disable-free, in which case this doesn't run.
+  ~SharedMatchFinder() {
+    if (pending_runs_ > 0) {
+      diagnostics_.Report(diagnostics_.getCustomDiagID(
+          clang::DiagnosticsEngine::Error,
+          "[chromium-plugins] %0 plugin(s) joined the shared AST matchers "
+          "but never ran them; the matchers of all plugins were skipped"))
+          << pending_runs_;
+    }
+  }
+
+  // Returns the finder for |context|, which is created by the first plugin to
+  // join.
+  static std::shared_ptr<SharedMatchFinder> Join(clang::ASTContext& context) {
+    std::weak_ptr<SharedMatchFinder>& slot = Finders()[&context];
+    std::shared_ptr<SharedMatchFinder> finder = slot.lock();
+    if (!finder) {
+      finder = std::make_shared<SharedMatchFinder>(context);
+      slot = finder;
+    }
+    ++finder->pending_runs_;
+    return finder;
+  }
+
+  clang::ast_matchers::MatchFinder& finder() { return finder_; }
+
+  // Must be called once by each plugin that joined. The last call runs the
+  // matchers.
+  void Run() {
+    assert(pending_runs_ > 0);
+    if (--pending_runs_ > 0) {
+      return;
+    }
+    Finders().erase(&context_);
+    llvm::TimeTraceScope TimeScope("SharedMatchFinder::Run");
+    finder_.matchAST(context_);
+  }
+
+ private:
+  using FinderMap = llvm::DenseMap<const clang::ASTContext*,
+                                   std::weak_ptr<SharedMatchFinder>>;
+
+  static FinderMap& Finders() {
+    static FinderMap finders;
+    return finders;
+  }
+
+  clang::ASTContext& context_;
+  clang::DiagnosticsEngine& diagnostics_;
+  clang::ast_matchers::MatchFinder finder_;
+  unsigned pending_runs_ = 0;
+};
+
+}  // namespace chrome_plugin_host
+
+#endif  // TOOLS_CLANG_PLUGIN_HOST_SHAREDMATCHFINDER_H_
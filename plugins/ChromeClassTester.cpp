@@ -11,6 +11,10 @@
 #include "clang/AST/AST.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
+#include "clang/Basic/Version.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
 
 #ifdef LLVM_ON_UNIX
 #include <sys/param.h>
@@ -37,8 +41,24 @@ ChromeClassTester::ChromeClassTester(CompilerInstance& instance,
                                      const Options& options)
     : options_(options),
       instance_(instance),
-      diagnostic_(instance.getDiagnostics()) {
+      diagnostic_(instance.getDiagnostics()),
+      location_classifier_(instance.getHeaderSearchOpts()) {
   BuildBannedLists();
+
+  // The predefined macros stand in for the command line, which can change what
+  // a header declares. Whether warnings are ignored or are errors changes which
+  // diagnostics are counted, so it is part of the configuration too.
+  if (!options.verified_header_cache_dir.empty() &&
+      instance.hasPreprocessor()) {
+    std::string configuration = getClangFullVersion();
+    configuration += '\n';
+    configuration += options.verified_header_cache_args;
+    configuration += diagnostic_.getIgnoreAllWarnings() ? "-w\n" : "";
+    configuration += diagnostic_.getWarningsAsErrors() ? "-Werror\n" : "";
+    configuration += instance.getPreprocessor().getPredefines();
+    verified_headers_ = std::make_unique<chrome_checker::VerifiedHeaderCache>(
+        options.verified_header_cache_dir, std::move(configuration));
+  }
 }
 
 ChromeClassTester::~ChromeClassTester() {}
@@ -60,14 +80,31 @@ void ChromeClassTester::CheckTag(TagDecl* tag) {
     if (IsIgnoredType(base_name))
       return;
 
+    // Skip records in headers that an earlier compile already checked.
+    std::string entry_path = GetVerifiedHeaderEntry(location, record);
+    if (entry_path.empty()) {
+      CheckChromeClass(location_type, location, record);
+      return;
+    }
+    if (verified_headers_->IsVerified(entry_path))
+      return;
+    unsigned num_diagnostics = NumDiagnostics();
     CheckChromeClass(location_type, location, record);
+    verified_headers_->AddResult(entry_path,
+                                 NumDiagnostics() == num_diagnostics);
   }
 }
 
+void ChromeClassTester::CommitVerifiedHeaders() {
+  // After a compile error, records may have been skipped or be incomplete.
+  if (verified_headers_ && !diagnostic().hasUncompilableErrorOccurred())
+    verified_headers_->Commit();
+}
+
 ChromeClassTester::LocationType ChromeClassTester::ClassifyLocation(
     SourceLocation loc) {
-  auto classification = chrome_checker::ClassifySourceLocation(
-      instance().getHeaderSearchOpts(), instance().getSourceManager(), loc);
+  auto classification =
+      location_classifier_.Classify(instance().getSourceManager(), loc);
 
   // Convert to a less granular legacy classificatoin.
   switch (classification) {
@@ -163,6 +200,53 @@ bool ChromeClassTester::IsIgnoredType(std::string_view base_name) {
   return ignored_record_names_.count(base_name) != 0u;
 }
 
+std::string ChromeClassTester::GetVerifiedHeaderEntry(
+    SourceLocation record_location,
+    const CXXRecordDecl* record) {
+  if (!verified_headers_)
+    return std::string();
+  const SourceManager& source_manager = instance().getSourceManager();
+  FileID fid =
+      source_manager.getFileID(source_manager.getExpansionLoc(record_location));
+  if (fid == source_manager.getMainFileID() ||
+      InImplementationFile(record_location)) {
+    return std::string();
+  }
+
+  // The checks look at the bases of |record|, e.g. for the methods it
+  // overrides, and at the types of its fields, e.g. to weigh its constructors.
+  // Those depend on their own bases and fields in turn.
+  std::vector<FileID> dependencies;
+  llvm::SmallPtrSet<const CXXRecordDecl*, 16> visited;
+  llvm::SmallVector<const CXXRecordDecl*, 16> worklist;
+  auto add_record = [&](QualType type) {
+    const CXXRecordDecl* decl =
+        type->getBaseElementTypeUnsafe()->getAsCXXRecordDecl();
+    if (decl)
+      decl = decl->getDefinition();
+    if (decl && visited.insert(decl).second)
+      worklist.push_back(decl);
+  };
+  visited.insert(record);
+  worklist.push_back(record);
+  while (!worklist.empty()) {
+    const CXXRecordDecl* decl = worklist.pop_back_val();
+    dependencies.push_back(source_manager.getFileID(
+        source_manager.getExpansionLoc(decl->getLocation())));
+    for (const CXXBaseSpecifier& base : decl->bases())
+      add_record(base.getType());
+    for (const FieldDecl* field : decl->fields())
+      add_record(field->getType());
+  }
+  return verified_headers_->GetEntryPath(source_manager, record_location,
+                                         dependencies);
+}
+
+unsigned ChromeClassTester::NumDiagnostics() {
+  const DiagnosticConsumer* client = diagnostic().getClient();
+  return client->getNumErrors() + client->getNumWarnings();
+}
+
 DiagnosticsEngine::Level ChromeClassTester::getErrorLevel() {
   return diagnostic().getWarningsAsErrors() ? DiagnosticsEngine::Error
                                             : DiagnosticsEngine::Warning;
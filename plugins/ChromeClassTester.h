@@ -5,10 +5,14 @@
 #ifndef TOOLS_CLANG_PLUGINS_CHROMECLASSTESTER_H_
 #define TOOLS_CLANG_PLUGINS_CHROMECLASSTESTER_H_
 
+#include <memory>
 #include <set>
+#include <string>
 #include <vector>
 
 #include "Options.h"
+#include "Util.h"
+#include "VerifiedHeaderCache.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/TypeLoc.h"
 #include "clang/Frontend/CompilerInstance.h"
@@ -26,6 +30,11 @@ class ChromeClassTester {
 
   clang::DiagnosticsEngine::Level getErrorLevel();
 
+  // Records the header records that passed CheckChromeClass() in the verified
+  // header cache, if it is enabled. Call once the translation unit has been
+  // checked.
+  void CommitVerifiedHeaders();
+
  protected:
   clang::CompilerInstance& instance() { return instance_; }
   clang::DiagnosticsEngine& diagnostic() { return diagnostic_; }
@@ -76,9 +85,23 @@ class ChromeClassTester {
   // deliberately ignore) in HandleTagDeclDefinition().
   bool IsIgnoredType(std::string_view base_name);
 
+  // Returns the path of the entry of |record| in the verified header cache, or
+  // an empty string if it cannot be cached.
+  std::string GetVerifiedHeaderEntry(clang::SourceLocation record_location,
+                                     const clang::CXXRecordDecl* record);
+
+  // Returns the number of errors and warnings emitted so far.
+  unsigned NumDiagnostics();
+
   clang::CompilerInstance& instance_;
   clang::DiagnosticsEngine& diagnostic_;
 
+  // Caches the classification of each file for ClassifyLocation().
+  chrome_checker::LocationClassifier location_classifier_;
+
+  // Null unless the verified-header-cache argument was given.
+  std::unique_ptr<chrome_checker::VerifiedHeaderCache> verified_headers_;
+
   // List of types that we don't check.
   std::set<std::string_view> ignored_record_names_;
 
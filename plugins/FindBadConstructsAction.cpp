@@ -22,6 +22,10 @@ namespace {
 // - FilterFile
 const char kExcludeFieldsArgPrefix[] = "exclude-fields=";
 
+// Name of a cmdline parameter that enables the cache of headers whose records
+// passed the class checks, shared between compiles. See VerifiedHeaderCache.
+const char kVerifiedHeaderCacheArgPrefix[] = "verified-header-cache=";
+
 }  // namespace
 
 namespace chrome_checker {
@@ -57,6 +61,14 @@ std::unique_ptr<ASTConsumer> FindBadConstructsAction::CreateASTConsumer(
 bool FindBadConstructsAction::ParseArgs(const CompilerInstance& instance,
                                         const std::vector<std::string>& args) {
   for (llvm::StringRef arg : args) {
+    if (arg.starts_with(kVerifiedHeaderCacheArgPrefix)) {
+      options_.verified_header_cache_dir =
+          arg.substr(strlen(kVerifiedHeaderCacheArgPrefix)).str();
+      continue;
+    }
+    options_.verified_header_cache_args += arg;
+    options_.verified_header_cache_args += '\n';
+
     if (arg.starts_with(kExcludeFieldsArgPrefix)) {
       options_.exclude_fields_file =
           arg.substr(strlen(kExcludeFieldsArgPrefix)).str();
@@ -286,6 +286,8 @@ void FindBadConstructsConsumer::Traverse(ASTContext& context) {
   if (ipc_visitor_) {
     ipc_visitor_->set_context(nullptr);
   }
+
+  CommitVerifiedHeaders();
 }
 
 bool FindBadConstructsConsumer::TraverseDecl(Decl* decl) {
@@ -23,6 +23,12 @@ struct Options {
   bool enable_match_profiling = false;
   bool span_ctor_from_string_literal = false;
   std::string exclude_fields_file;
+  // Directory of the cache of header records that passed the class checks.
+  // Empty if the cache is disabled.
+  std::string verified_header_cache_dir;
+  // The other plugin arguments, which the class checks depend on. Part of the
+  // key of each entry in the verified header cache.
+  std::string verified_header_cache_args;
 };
 
 }  // namespace chrome_checker
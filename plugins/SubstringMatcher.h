@@ -0,0 +1,76 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_CLANG_PLUGINS_SUBSTRINGMATCHER_H_
+#define TOOLS_CLANG_PLUGINS_SUBSTRINGMATCHER_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallBitVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace chrome_checker {
+
+// Matches strings against a fixed set of patterns, such as the path fragments
+// of a filter file.
+//
+// The patterns are compiled into an Aho-Corasick automaton, so a lookup walks
+// the string once no matter how many patterns there are, instead of trying
+// each pattern (or each branch of a regex alternation) in turn. The matcher
+// keeps its own copy of the patterns.
+//
+// Empty patterns are ignored.
+class SubstringMatcher {
+ public:
+  SubstringMatcher();
+  explicit SubstringMatcher(llvm::ArrayRef<llvm::StringRef> patterns);
+
+  // Returns true if no (non-empty) patterns were given.
+  bool empty() const { return states_.size() == 1; }
+
+  // Returns true if any pattern is a substring of |text|.
+  bool MatchesSubstringOf(llvm::StringRef text) const;
+
+  // Returns true if any pattern is a prefix of |text|.
+  bool MatchesPrefixOf(llvm::StringRef text) const;
+
+  // Resets |matches| to one bit per pattern, in the order the patterns were
+  // given, and sets the bits of the patterns that are substrings of |text|.
+  void FindSubstringsOf(llvm::StringRef text,
+                        llvm::SmallBitVector& matches) const;
+
+ private:
+  static constexpr uint32_t kNone = UINT32_MAX;
+
+  struct State {
+    // Trie edges, sorted by character.
+    llvm::SmallVector<std::pair<unsigned char, uint32_t>, 2> edges;
+    // State for the longest proper suffix of this state's string that is also
+    // in the trie.
+    uint32_t failure = 0;
+    // Nearest state, following failure links from this one (inclusive), at
+    // which a pattern ends. kNone if there is none.
+    uint32_t output = kNone;
+    // Indices of the patterns that end at this state.
+    llvm::SmallVector<uint32_t, 1> patterns;
+  };
+
+  // Returns the trie child of |state| for |c|, or kNone.
+  uint32_t Child(uint32_t state, unsigned char c) const;
+  // Returns the automaton transition from |state| on |c|.
+  uint32_t Next(uint32_t state, unsigned char c) const;
+
+  // The root is states_[0].
+  std::vector<State> states_;
+  // Number of patterns given, including empty ones.
+  uint32_t num_patterns_ = 0;
+};
+
+}  // namespace chrome_checker
+
+#endif  // TOOLS_CLANG_PLUGINS_SUBSTRINGMATCHER_H_
@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include "SubstringMatcher.h"
 #include "Util.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/Basic/DiagnosticSema.h"
@@ -21,47 +22,12 @@ namespace chrome_checker {
 llvm::StringMap<bool> g_checked_files_cache;
 
 struct CheckFilePrefixes {
-  // Owns the memory holding the strings.
-  std::unique_ptr<llvm::MemoryBuffer> buffer;
-  // Pointers into the `buffer`, in sorted order.
-  std::vector<llvm::StringRef> opt_out;
-  // Pointers into the `buffer`, in sorted order.
-  std::vector<llvm::StringRef> opt_in;
+  // Matches the prefixes of files to not check.
+  SubstringMatcher opt_out;
+  // Matches the prefixes of files to check.
+  SubstringMatcher opt_in;
 };
 
-// Sort the prefixes and remove duplicates.
-void NormalizePrefixList(std::vector<llvm::StringRef>& prefixes) {
-  if (prefixes.empty()) {
-    return;
-  }
-
-  // TODO(danakj): Use std::ranges::sort when Clang is build with C++20.
-  std::sort(prefixes.begin(), prefixes.end());
-
-  // Remove ~duplicate in a general sense, where a prefix is a prefix of another
-  // prefix. This is useful when two unrelated patches are merged/reverted
-  // around the same time and the prefixes overlap. This avoids one to hide the
-  // other when searching them via std::upper_bound.
-  //
-  // Note that we could use std::unique here, but its behavior is not
-  // guaranteed by the standard when the predicate is not an equivalence
-  // relation.
-  {
-    auto it = prefixes.begin();
-    for (auto next = std::next(it); next != prefixes.end(); ++next) {
-      if (next->starts_with(*it)) {
-        continue;  // Skip the prefix.
-      }
-      ++it;
-      // Fill in the gap in between the two iterators.
-      if (it != next) {
-        *it = std::move(*next);
-      }
-    }
-    prefixes.erase(std::next(it), prefixes.end());
-  }
-}
-
 class UnsafeBuffersDiagnosticConsumer : public clang::DiagnosticConsumer {
  public:
   UnsafeBuffersDiagnosticConsumer(clang::DiagnosticsEngine* engine,
@@ -74,7 +40,8 @@ class UnsafeBuffersDiagnosticConsumer : public clang::DiagnosticConsumer {
         check_file_prefixes_(std::move(check_file_prefixes)),
         diag_note_link_(engine_->getCustomDiagID(
             clang::DiagnosticsEngine::Level::Note,
-            "See //docs/unsafe_buffers.md for help.")) {}
+            "See //docs/unsafe_buffers.md for help.")),
+        location_classifier_(instance->getHeaderSearchOpts()) {}
   ~UnsafeBuffersDiagnosticConsumer() override = default;
 
   void clear() override {
@@ -216,10 +183,17 @@ class UnsafeBuffersDiagnosticConsumer : public clang::DiagnosticConsumer {
       loc = sm.getExpansionLoc(loc);
     }
 
+    return checked_files_.Get(sm, sm.getFileID(loc), [&] {
+      return ComputeFileHasSafeBuffersWarnings(sm, loc);
+    });
+  }
+
+  // Implements FileHasSafeBuffersWarnings() for a file location `loc`.
+  bool ComputeFileHasSafeBuffersWarnings(const clang::SourceManager& sm,
+                                         clang::SourceLocation loc) {
     // TODO(crbug.com/40284755): Expand this diagnostic to more code. It should
     // include everything except kSystem eventually.
-    LocationClassification loc_class =
-        ClassifySourceLocation(instance_->getHeaderSearchOpts(), sm, loc);
+    LocationClassification loc_class = location_classifier_.Classify(sm, loc);
     switch (loc_class) {
       case LocationClassification::kSystem:
         return false;
@@ -240,12 +214,11 @@ class UnsafeBuffersDiagnosticConsumer : public clang::DiagnosticConsumer {
     // We default to everything opting into checks (except categories that early
     // out above) unless it is removed by the paths control file or by pragma.
 
-    // TODO(danakj): It would be an optimization to find a way to avoid creating
-    // a std::string here.
     std::string filename = GetFilename(sm, loc, FilenameLocationType::kExactLoc,
                                        FilenamesFollowPresumed::kNo);
 
-    // Avoid searching `check_file_prefixes_` more than once for a file.
+    // Avoid searching `check_file_prefixes_` more than once for a file, across
+    // the FileIDs it may have.
     auto cache_it = g_checked_files_cache.find(filename);
     if (cache_it != g_checked_files_cache.end()) {
       return cache_it->second;
@@ -277,29 +250,13 @@ class UnsafeBuffersDiagnosticConsumer : public clang::DiagnosticConsumer {
     // the file. If none are found, we look for opt-outs, which have lower
     // precedence and remove checks from the file. If there's neither, the file
     // is checked.
-    if (!check_file_prefixes_.opt_in.empty()) {
-      const auto begin = check_file_prefixes_.opt_in.begin();
-      const auto end = check_file_prefixes_.opt_in.end();
-      auto it = std::upper_bound(begin, end, cmp_filename);
-      if (it != begin) {
-        --it;  // Now `it` will be either the exact or prefix match.
-        if (*it == cmp_filename.take_front(it->size())) {
-          g_checked_files_cache.insert({filename, true});
-          return true;
-        }
-      }
+    if (check_file_prefixes_.opt_in.MatchesPrefixOf(cmp_filename)) {
+      g_checked_files_cache.insert({filename, true});
+      return true;
     }
-    if (!check_file_prefixes_.opt_out.empty()) {
-      const auto begin = check_file_prefixes_.opt_out.begin();
-      const auto end = check_file_prefixes_.opt_out.end();
-      auto it = std::upper_bound(begin, end, cmp_filename);
-      if (it != begin) {
-        --it;  // Now `it` will be either the exact or prefix match.
-        if (*it == cmp_filename.take_front(it->size())) {
-          g_checked_files_cache.insert({filename, false});
-          return false;
-        }
-      }
+    if (check_file_prefixes_.opt_out.MatchesPrefixOf(cmp_filename)) {
+      g_checked_files_cache.insert({filename, false});
+      return false;
     }
     g_checked_files_cache.insert({filename, true});
     return true;
@@ -313,6 +270,9 @@ class UnsafeBuffersDiagnosticConsumer : public clang::DiagnosticConsumer {
   clang::CompilerInstance* instance_;
   CheckFilePrefixes check_file_prefixes_;
   unsigned diag_note_link_;
+  LocationClassifier location_classifier_;
+  // Result of FileHasSafeBuffersWarnings() for each file.
+  FileIDCache<bool> checked_files_;
 };
 
 class UnsafeBuffersASTConsumer : public clang::ASTConsumer {
@@ -400,15 +360,14 @@ class UnsafeBuffersASTAction : public clang::PluginASTAction {
   }
 
   bool LoadCheckFilePrefixes(std::string_view path) {
-    if (auto buffer = llvm::MemoryBuffer::getFileAsStream(path)) {
-      check_file_prefixes_.buffer = std::move(buffer.get());
-    } else {
+    auto buffer = llvm::MemoryBuffer::getFileAsStream(path);
+    if (!buffer) {
       llvm::errs() << "[unsafe-buffers] Error reading file: '"
                    << buffer.getError().message() << "'\n";
       return false;
     }
 
-    // Parse out the paths into `check_file_prefixes_.prefixes`.
+    // Parse out the paths into `check_file_prefixes_`.
     //
     // The file format is as follows:
     // * Lines that begin with `#` are comments are are ignored.
@@ -438,7 +397,9 @@ class UnsafeBuffersASTAction : public clang::PluginASTAction {
     // # for this one file.
     // +my/file.cc
 
-    llvm::StringRef string = check_file_prefixes_.buffer->getBuffer();
+    std::vector<llvm::StringRef> opt_in;
+    std::vector<llvm::StringRef> opt_out;
+    llvm::StringRef string = buffer.get()->getBuffer();
     while (!string.empty()) {
       auto [lhs, rhs] = string.split('\n');
       string = rhs;
@@ -451,9 +412,9 @@ class UnsafeBuffersASTAction : public clang::PluginASTAction {
       }
       if (keep_lhs) {
         if (lhs[0u] == '+' && lhs.size() > 1u) {
-          check_file_prefixes_.opt_in.push_back(lhs.substr(1u));
+          opt_in.push_back(lhs.substr(1u));
         } else if (lhs[0u] == '-' && lhs.size() > 1u) {
-          check_file_prefixes_.opt_out.push_back(lhs.substr(1u));
+          opt_out.push_back(lhs.substr(1u));
         } else {
           llvm::errs() << "[unsafe-buffers] Invalid line in paths file, must "
                           "start with +/-: '"
@@ -463,8 +424,8 @@ class UnsafeBuffersASTAction : public clang::PluginASTAction {
       }
     }
 
-    NormalizePrefixList(check_file_prefixes_.opt_in);
-    NormalizePrefixList(check_file_prefixes_.opt_out);
+    check_file_prefixes_.opt_in = SubstringMatcher(opt_in);
+    check_file_prefixes_.opt_out = SubstringMatcher(opt_out);
 
     return true;
   }
@@ -483,8 +444,6 @@ class AllowUnsafeBuffersPragmaHandler : public clang::PragmaHandler {
   void HandlePragma(clang::Preprocessor& preprocessor,
                     clang::PragmaIntroducer introducer,
                     clang::Token& token) override {
-    // TODO(danakj): It would be an optimization to find a way to avoid creating
-    // a std::string here.
     std::string filename =
         GetFilename(preprocessor.getSourceManager(), introducer.Loc,
                     FilenameLocationType::kExpansionLoc);
@@ -502,8 +461,6 @@ class CheckUnsafeBuffersPragmaHandler : public clang::PragmaHandler {
   void HandlePragma(clang::Preprocessor& preprocessor,
                     clang::PragmaIntroducer introducer,
                     clang::Token& token) override {
-    // TODO(danakj): It would be an optimization to find a way to avoid creating
-    // a std::string here.
     std::string filename =
         GetFilename(preprocessor.getSourceManager(), introducer.Loc,
                     FilenameLocationType::kExpansionLoc);
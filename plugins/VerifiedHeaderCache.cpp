@@ -0,0 +1,137 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "VerifiedHeaderCache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CacheKey.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBufferRef.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace chrome_checker {
+
+VerifiedHeaderCache::VerifiedHeaderCache(std::string directory,
+                                         std::string configuration)
+    : directory_(std::move(directory)),
+      configuration_(std::move(configuration)) {}
+
+std::string VerifiedHeaderCache::GetEntryPath(
+    const clang::SourceManager& sm,
+    clang::SourceLocation record_location,
+    llvm::ArrayRef<clang::FileID> dependencies) {
+  auto [fid, offset] = sm.getDecomposedExpansionLoc(record_location);
+  std::string header_hash = GetFileHash(sm, fid);
+  if (header_hash.empty()) {
+    return std::string();
+  }
+
+  // Sorted, so that the key doesn't depend on the order the dependencies were
+  // found in.
+  std::vector<std::string> dependency_hashes;
+  for (clang::FileID dependency : dependencies) {
+    if (dependency == fid) {
+      continue;
+    }
+    const std::string& dependency_hash = GetFileHash(sm, dependency);
+    if (dependency_hash.empty()) {
+      return std::string();
+    }
+    dependency_hashes.push_back(dependency_hash);
+  }
+  llvm::sort(dependency_hashes);
+  dependency_hashes.erase(
+      std::unique(dependency_hashes.begin(), dependency_hashes.end()),
+      dependency_hashes.end());
+
+  chrome_plugin_host::CacheKey key;
+  key.Add(configuration_);
+  key.Add(header_hash);
+  key.Add(std::to_string(offset));
+  for (const std::string& dependency_hash : dependency_hashes) {
+    key.Add(dependency_hash);
+  }
+
+  llvm::SmallString<256> path(directory_);
+  llvm::sys::path::append(path, key.Finish());
+  return std::string(path);
+}
+
+bool VerifiedHeaderCache::IsVerified(const std::string& entry_path) {
+  auto [it, inserted] = entries_.try_emplace(entry_path);
+  if (inserted) {
+    it->second.verified = llvm::sys::fs::exists(entry_path);
+  }
+  return it->second.verified;
+}
+
+void VerifiedHeaderCache::AddResult(const std::string& entry_path,
+                                    bool passed) {
+  auto it = entries_.find(entry_path);
+  assert(it != entries_.end() && !it->second.verified);
+  it->second.passed &= passed;
+}
+
+void VerifiedHeaderCache::Commit() {
+  bool created_directory = false;
+  for (const auto& entry : entries_) {
+    if (entry.second.verified || !entry.second.passed) {
+      continue;
+    }
+    if (!created_directory) {
+      if (llvm::sys::fs::create_directories(directory_)) {
+        return;
+      }
+      created_directory = true;
+    }
+
+    // Write the entry under a unique name and rename it into place, so that a
+    // concurrent compile never sees a partial entry.
+    std::string entry_path = entry.first().str();
+    int fd;
+    llvm::SmallString<256> temp_path;
+    if (llvm::sys::fs::createUniqueFile(entry_path + "-%%%%%%%%.tmp", fd,
+                                        temp_path)) {
+      continue;
+    }
+    {
+      llvm::raw_fd_ostream out(fd, /*shouldClose=*/true);
+      out << "verified\n";
+    }
+    if (llvm::sys::fs::rename(temp_path, entry_path)) {
+      llvm::sys::fs::remove(temp_path);
+    }
+  }
+}
+
+const std::string& VerifiedHeaderCache::GetFileHash(
+    const clang::SourceManager& sm,
+    clang::FileID fid) {
+  auto [it, inserted] = file_hashes_.try_emplace(fid);
+  if (!inserted) {
+    return it->second;
+  }
+
+  clang::OptionalFileEntryRef file = sm.getFileEntryRefForID(fid);
+  std::optional<llvm::MemoryBufferRef> buffer = sm.getBufferOrNone(fid);
+  if (!file || !buffer) {
+    return it->second;
+  }
+  chrome_plugin_host::CacheKey key;
+  key.Add(file->getName());
+  key.Add(buffer->getBuffer());
+  it->second = std::string(key.Finish());
+  return it->second;
+}
+
+}  // namespace chrome_checker
@@ -0,0 +1,81 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_CLANG_PLUGINS_VERIFIEDHEADERCACHE_H_
+#define TOOLS_CLANG_PLUGINS_VERIFIEDHEADERCACHE_H_
+
+#include <string>
+
+#include "clang/Basic/SourceLocation.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+
+namespace chrome_checker {
+
+// Remembers, across translation units, the records in headers that passed all
+// of the class checks, so that translation units including them later can
+// skip checking those records again.
+//
+// Each entry is a file in a cache directory, named by a hash of a
+// configuration string, of the path and contents of the record's header and of
+// the record's offset in it, and of the paths and contents of the files that
+// declare the other records its checks look at, such as its bases. The
+// configuration covers everything else the checks depend on, such as the
+// plugin arguments. Entries are written to a temporary file and renamed into
+// place, so concurrent compiles can share a directory.
+//
+// This is only sound if the declarations of a header depend on nothing but its
+// contents and the configuration. Macros defined by the files included before
+// a header can break that, which is why the cache is opt-in.
+class VerifiedHeaderCache {
+ public:
+  VerifiedHeaderCache(std::string directory, std::string configuration);
+
+  VerifiedHeaderCache(const VerifiedHeaderCache&) = delete;
+  VerifiedHeaderCache& operator=(const VerifiedHeaderCache&) = delete;
+
+  // Returns the path of the entry of the record at |record_location|, or an
+  // empty string if the record cannot be cached. |dependencies| are the files
+  // that declare the records its checks look at.
+  std::string GetEntryPath(const clang::SourceManager& sm,
+                           clang::SourceLocation record_location,
+                           llvm::ArrayRef<clang::FileID> dependencies);
+
+  // Returns true if an earlier translation unit recorded that the record of
+  // |entry_path| passed all checks.
+  bool IsVerified(const std::string& entry_path);
+
+  // Records whether the record of |entry_path| passed all checks. Must follow
+  // a call to IsVerified() for |entry_path| that returned false.
+  void AddResult(const std::string& entry_path, bool passed);
+
+  // Adds the entries of the records that passed every time they were checked.
+  // A header included more than once has its records checked once for each
+  // inclusion, and the results can differ if macros differ between them.
+  void Commit();
+
+ private:
+  struct Entry {
+    // Whether the entry existed.
+    bool verified = false;
+    // Whether every check of the record in this translation unit passed.
+    bool passed = true;
+  };
+
+  // Returns the hash of the path and contents of |fid|, or an empty string if
+  // it has no contents.
+  const std::string& GetFileHash(const clang::SourceManager& sm,
+                                 clang::FileID fid);
+
+  const std::string directory_;
+  const std::string configuration_;
+  llvm::DenseMap<clang::FileID, std::string> file_hashes_;
+  llvm::StringMap<Entry> entries_;
+};
+
+}  // namespace chrome_checker
+
+#endif  // TOOLS_CLANG_PLUGINS_VERIFIEDHEADERCACHE_H_
@@ -5,8 +5,10 @@
 
 import argparse
 import os
+import shutil
 import subprocess
 import sys
+import tempfile
 
 script_dir = os.path.dirname(os.path.realpath(__file__))
 tool_dir = os.path.abspath(os.path.join(script_dir, '../../pylib'))
@@ -30,6 +32,33 @@ class ChromeStylePluginTest(plugin_testing.ClangPluginTest):
         '.',
     ])
 
+  def RunOneTest(self, test_name, cmd):
+    if test_name != 'verified_header_cache':
+      return super().RunOneTest(test_name, cmd)
+
+    # Compiles the test twice with one cache directory, changing the header of
+    # the base class in between. Only the second compile should warn.
+    with tempfile.TemporaryDirectory() as temp_dir:
+      cmd = cmd[:-1] + [
+          '-Xclang', '-plugin-arg-find-bad-constructs', '-Xclang',
+          'verified-header-cache=' + os.path.join(temp_dir, 'cache'), '-I',
+          temp_dir, cmd[-1]
+      ]
+      actual = ''
+      for version in ('before', 'after'):
+        shutil.copyfile(
+            os.path.join(test_name, 'base_%s.h' % version),
+            os.path.join(temp_dir, 'verified_header_cache_base.h'))
+        try:
+          actual += subprocess.check_output(cmd,
+                                            stderr=subprocess.STDOUT,
+                                            universal_newlines=True)
+        except subprocess.CalledProcessError as e:
+          actual += e.output
+        except Exception as e:
+          return 'could not execute %s (%s)' % (cmd, e)
+    return self.ProcessOneResult(test_name, actual)
+
 
 def main():
   parser = argparse.ArgumentParser()
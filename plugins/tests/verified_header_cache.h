@@ -0,0 +1,17 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef VERIFIED_HEADER_CACHE_H_
+#define VERIFIED_HEADER_CACHE_H_
+
+#include "verified_header_cache_base.h"
+
+// Needs 'override' only once Base::Method() is virtual. test.py compiles this
+// twice, and the entry cached for Derived before then must not be used after.
+class Derived : public Base {
+ public:
+  void Method();
+};
+
+#endif  // VERIFIED_HEADER_CACHE_H_
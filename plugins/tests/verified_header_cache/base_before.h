@@ -0,0 +1,13 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef VERIFIED_HEADER_CACHE_BASE_H_
+#define VERIFIED_HEADER_CACHE_BASE_H_
+
+class Base {
+ public:
+  void Method();
+};
+
+#endif  // VERIFIED_HEADER_CACHE_BASE_H_
@@ -0,0 +1,151 @@
+# Copyright 2026 The Chromium Authors
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+"""Reads and writes the binary edit format.
+
+Clang tools may emit their edits as binary sections instead of text
+directives (see BinaryEditsWriter in raw_ptr_plugin/BinaryEdits.h):
+
+    ==== BEGIN BINARY EDITS <size> ====
+    <payload of <size> bytes>
+    ==== END BINARY EDITS ====
+
+The payload is a sequence of ULEB128 integers and length-prefixed strings:
+
+    <path count> (<length> <path bytes>)...
+    <edit count> (<type> <path index> [<offset> <length>]
+                  <length> <text bytes>)...
+
+where <type> indexes EDIT_TYPES, and <offset> and <length> are only present
+for replacements.
+
+extract_edits.py merges the sections of a run into a single payload, preceded
+by MAGIC so that apply_edits.py can tell it apart from text directives.
+
+Edits are represented as (edit_type, path, offset, length, text) tuples, the
+same fields as a text directive. Includes have an offset and length of -1, and
+|text| is bytes.
+"""
+
+import re
+
+# Indexed by the <type> of an edit. Must match BinaryEditsWriter::EditType.
+EDIT_TYPES = ('r', 'include-user-header', 'include-system-header')
+
+MAGIC = b'\0cr-binary-edits-1\n'
+
+BEGIN_RE = re.compile(br'^==== BEGIN BINARY EDITS (\d+) ====$')
+END_LINE = b'==== END BINARY EDITS ===='
+
+
+def _WriteULEB128(out, value):
+  while True:
+    byte = value & 0x7f
+    value >>= 7
+    if value:
+      out.append(byte | 0x80)
+    else:
+      out.append(byte)
+      return
+
+
+def _WriteString(out, data):
+  _WriteULEB128(out, len(data))
+  out.extend(data)
+
+
+def EncodePayload(edits):
+  """Returns the payload encoding |edits|, an iterable of edit tuples."""
+  edits = list(edits)
+  path_indices = {}
+  for edit in edits:
+    path_indices.setdefault(edit[1], len(path_indices))
+
+  out = bytearray()
+  _WriteULEB128(out, len(path_indices))
+  for path in path_indices:
+    _WriteString(out, path.encode('utf-8'))
+
+  _WriteULEB128(out, len(edits))
+  for edit_type, path, offset, length, text in edits:
+    type_index = EDIT_TYPES.index(edit_type)
+    _WriteULEB128(out, type_index)
+    _WriteULEB128(out, path_indices[path])
+    if type_index == 0:
+      _WriteULEB128(out, offset)
+      _WriteULEB128(out, length)
+    _WriteString(out, text)
+  return bytes(out)
+
+
+class _Reader(object):
+
+  def __init__(self, data):
+    self.data = data
+    self.pos = 0
+
+  def ULEB128(self):
+    value = 0
+    shift = 0
+    while True:
+      if self.pos >= len(self.data):
+        raise ValueError('Truncated binary edits')
+      byte = self.data[self.pos]
+      self.pos += 1
+      value |= (byte & 0x7f) << shift
+      if not byte & 0x80:
+        return value
+      shift += 7
+
+  def String(self):
+    length = self.ULEB128()
+    if self.pos + length > len(self.data):
+      raise ValueError('Truncated binary edits')
+    value = self.data[self.pos:self.pos + length]
+    self.pos += length
+    return value
+
+
+def DecodePayload(payload):
+  """Returns the list of edit tuples encoded in |payload|.
+
+  Raises:
+    ValueError: |payload| is malformed.
+  """
+  reader = _Reader(payload)
+  paths = [reader.String().decode('utf-8') for _ in range(reader.ULEB128())]
+  edits = []
+  for _ in range(reader.ULEB128()):
+    type_index = reader.ULEB128()
+    if type_index >= len(EDIT_TYPES):
+      raise ValueError('Unknown binary edit type %d' % type_index)
+    path_index = reader.ULEB128()
+    if path_index >= len(paths):
+      raise ValueError('Bad path index %d in binary edits' % path_index)
+    offset = length = -1
+    if type_index == 0:
+      offset = reader.ULEB128()
+      length = reader.ULEB128()
+    edits.append((EDIT_TYPES[type_index], paths[path_index], offset, length,
+                  reader.String()))
+  if reader.pos != len(payload):
+    raise ValueError('Trailing data after binary edits')
+  return edits
+
+
+def ReadSection(stream, begin_line):
+  """Reads the payload of the section started by |begin_line|, up to and
+  including the end marker.
+
+  Args:
+    stream: Binary file positioned right after |begin_line|.
+    begin_line: The line matching BEGIN_RE, without the line terminator.
+  """
+  size = int(BEGIN_RE.match(begin_line).group(1))
+  payload = stream.read(size)
+  if len(payload) != size:
+    raise ValueError('Truncated binary edits section')
+  for line in stream:
+    if line.rstrip(b'\r\n') == END_LINE:
+      break
+  return payload
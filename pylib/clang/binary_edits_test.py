@@ -0,0 +1,68 @@
+#!/usr/bin/env vpython3
+# Copyright 2026 The Chromium Authors
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+
+"""Tests for binary_edits."""
+
+import io
+import unittest
+
+import binary_edits
+
+# A section as written by raw_ptr_plugin::BinaryEditsWriter.
+_SECTION = (b'==== BEGIN BINARY EDITS 77 ====\n'
+            b'\x02\x08a/foo.cc\x07b/foo.h'
+            b'\x04'
+            b'\x00\x00\xac\x02\x00\x00'
+            b'\x02\x00\x06vector'
+            b'\x00\x01\n\x03\x0eraw_ptr<int>\nx'
+            b'\x01\x01\x15base/memory/raw_ptr.h'
+            b'\n==== END BINARY EDITS ====\n')
+
+_EDITS = [
+    ('r', 'a/foo.cc', 300, 0, b''),
+    ('include-system-header', 'a/foo.cc', -1, -1, b'vector'),
+    ('r', 'b/foo.h', 10, 3, b'raw_ptr<int>\nx'),
+    ('include-user-header', 'b/foo.h', -1, -1, b'base/memory/raw_ptr.h'),
+]
+
+
+class BinaryEditsTest(unittest.TestCase):
+
+  def testReadSection(self):
+    stream = io.BytesIO(_SECTION + b'after\n')
+    begin_line = stream.readline().rstrip(b'\n')
+    self.assertTrue(binary_edits.BEGIN_RE.match(begin_line))
+    payload = binary_edits.ReadSection(stream, begin_line)
+    self.assertEqual(_EDITS, binary_edits.DecodePayload(payload))
+    self.assertEqual(b'after\n', stream.read())
+
+  def testRoundTrip(self):
+    self.assertEqual(
+        _EDITS,
+        binary_edits.DecodePayload(binary_edits.EncodePayload(_EDITS)))
+
+  def testMatchesWriter(self):
+    payload = _SECTION[_SECTION.index(b'\n') + 1:_SECTION.rindex(b'\n====')]
+    self.assertEqual(payload, binary_edits.EncodePayload(_EDITS))
+
+  def testLargeValues(self):
+    edits = [('r', 'x' * 200, 1 << 40, 128, b'y' * 300)]
+    self.assertEqual(
+        edits, binary_edits.DecodePayload(binary_edits.EncodePayload(edits)))
+
+  def testMalformed(self):
+    payload = binary_edits.EncodePayload(_EDITS)
+    with self.assertRaises(ValueError):
+      binary_edits.DecodePayload(payload[:-1])
+    with self.assertRaises(ValueError):
+      binary_edits.DecodePayload(payload + b'\x00')
+    with self.assertRaises(ValueError):
+      binary_edits.ReadSection(io.BytesIO(b'\x00'),
+                               b'==== BEGIN BINARY EDITS 2 ====')
+
+
+if __name__ == '__main__':
+  unittest.main()
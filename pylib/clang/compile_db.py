@@ -24,6 +24,9 @@ _CLANG_WRAPPER_CMD_LINE_RE = re.compile(
     \s+
     (?P<args>.*)
     ''', re.VERBOSE)
+# Matches the first line of an entry in the output of 'ninja -t deps'.
+_NINJA_DEPS_TARGET_RE = re.compile(
+    r'^\S.*: #deps \d+, deps mtime \d+ \((\w+)\)$')
 _debugging = False
 
 
@@ -190,6 +193,13 @@ def GetNinjaPath():
                       '..', '..', 'third_party', 'ninja', ninja_executable)
 
 
+def _FindNinja():
+  ninja_path = GetNinjaPath()
+  if not os.path.exists(ninja_path):
+    ninja_path = shutil.which('ninja')
+  return ninja_path
+
+
 # FIXME: This really should be a build target, rather than generated at runtime.
 def GenerateWithNinja(path, targets=None):
   """Generates a compile database using ninja.
@@ -204,9 +214,7 @@ def GenerateWithNinja(path, targets=None):
   # TODO(dcheng): Ensure that clang is enabled somehow.
 
   # First, generate the compile database.
-  ninja_path = GetNinjaPath()
-  if not os.path.exists(ninja_path):
-    ninja_path = shutil.which('ninja')
+  ninja_path = _FindNinja()
   if targets is None:
     targets = []
   json_compile_db = subprocess.check_output(
@@ -223,3 +231,48 @@ def Read(path):
   """
   with open(os.path.join(path, 'compile_commands.json'), 'rb') as db:
     return json.load(db)
+
+
+def ParseNinjaDeps(build_directory, text):
+  """Parses the output of 'ninja -t deps' into the files included by each
+  source file. Entries which ninja reports as stale are skipped.
+
+  Args:
+    build_directory: Absolute path of the directory ninja was run in.
+    text: The output of 'ninja -t deps'.
+
+  Returns:
+    A dictionary from the path of each source file to the set of paths of the
+    files it includes, directly or not. Paths are made absolute against
+    |build_directory| and normalized with os.path.normpath. A source file built
+    into several objects gets the union of their includes.
+  """
+  deps = {}
+  valid = False
+  source = None
+  for line in text.splitlines():
+    match = _NINJA_DEPS_TARGET_RE.match(line)
+    if match:
+      valid = match.group(1) != 'STALE'
+      source = None
+      continue
+    line = line.strip()
+    if not valid or not line:
+      continue
+    path = os.path.normpath(os.path.join(build_directory, line))
+    if source is None:
+      # The first dependency of an object is its source file.
+      source = path
+      deps.setdefault(source, set())
+    else:
+      deps[source].add(path)
+  return deps
+
+
+def ReadNinjaDeps(build_directory):
+  """Returns the include graph recorded by the last build in |build_directory|,
+  see ParseNinjaDeps."""
+  build_directory = os.path.abspath(build_directory)
+  deps = subprocess.check_output(
+      [_FindNinja(), '-C', build_directory, '-t', 'deps']).decode('utf-8')
+  return ParseNinjaDeps(build_directory, deps)
@@ -146,5 +146,48 @@ class CompileDbTest(unittest.TestCase):
                       }])
 
 
+class ParseNinjaDepsTest(unittest.TestCase):
+
+  def testParse(self):
+    deps = compile_db.ParseNinjaDeps(
+        '/src/out/Default',
+        'obj/foo.o: #deps 3, deps mtime 123456789 (VALID)\n'
+        '    ../../foo.cc\n'
+        '    ../../foo.h\n'
+        '    gen/bar.h\n'
+        '\n'
+        'obj/bar.o: #deps 2, deps mtime 123456789 (VALID)\n'
+        '    ../../bar.cc\n'
+        '    ../../foo.h\n')
+    self.assertEqual(
+        {
+            '/src/foo.cc': {'/src/foo.h', '/src/out/Default/gen/bar.h'},
+            '/src/bar.cc': {'/src/foo.h'},
+        }, deps)
+
+  def testSkipsStaleEntries(self):
+    deps = compile_db.ParseNinjaDeps(
+        '/src/out/Default',
+        'obj/foo.o: #deps 2, deps mtime 123456789 (STALE)\n'
+        '    ../../foo.cc\n'
+        '    ../../foo.h\n'
+        '\n'
+        'obj/bar.o: #deps 1, deps mtime 123456789 (VALID)\n'
+        '    ../../bar.cc\n')
+    self.assertEqual({'/src/bar.cc': set()}, deps)
+
+  def testMergesObjectsOfTheSameSource(self):
+    deps = compile_db.ParseNinjaDeps(
+        '/src/out/Default',
+        'obj/x86/foo.o: #deps 2, deps mtime 123456789 (VALID)\n'
+        '    ../../foo.cc\n'
+        '    ../../x86.h\n'
+        '\n'
+        'obj/arm/foo.o: #deps 2, deps mtime 123456789 (VALID)\n'
+        '    ../../foo.cc\n'
+        '    ../../arm.h\n')
+    self.assertEqual({'/src/foo.cc': {'/src/x86.h', '/src/arm.h'}}, deps)
+
+
 if __name__ == '__main__':
   unittest.main()
@@ -0,0 +1,189 @@
+# Copyright 2026 The Chromium Authors
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+"""Reverse-include index, used by run_tool.py --include-index.
+
+Maps every file to the translation units that include it, directly or not, so
+that a rewrite restricted to some headers only needs to run over the
+translation units that can see them. The index is built from the include graph
+recorded by ninja, from the .filepaths files written by the translation_unit
+tool, or from the single index written by translation_unit --scan-deps-index,
+and saved as gzipped JSON:
+
+  {"source": "ninja", "filepaths" or "scan-deps",
+   "translation_units": ["/src/base/foo.cc", ...],
+   "files": {"/src/base/foo.h": [0, 12, ...], ...}}
+
+All paths are absolute and resolved with os.path.realpath, like the paths
+run_tool.py gets from git.
+"""
+
+import gzip
+import json
+import os
+import struct
+import tempfile
+
+NINJA = 'ninja'
+FILEPATHS = 'filepaths'
+SCAN_DEPS = 'scan-deps'
+
+# Must match WriteScanDepsIndex() in
+# translation_unit/TranslationUnitGenerator.cpp.
+_SCAN_DEPS_INDEX_MAGIC = b'TUINDEX1'
+
+
+class _RealPaths(object):
+  """Memoizes os.path.realpath, as most files are included by many
+  translation units."""
+
+  def __init__(self, build_directory):
+    self.__build_directory = build_directory
+    self.__cache = {}
+
+  def __call__(self, path):
+    real_path = self.__cache.get(path)
+    if real_path is None:
+      real_path = os.path.realpath(os.path.join(self.__build_directory, path))
+      self.__cache[path] = real_path
+    return real_path
+
+
+class IncludeIndex(object):
+  """Maps files to the translation units that include them."""
+
+  def __init__(self, source, translation_units, files):
+    """Initializer method. Use Build or Load instead.
+
+    Args:
+      source: How the index was built, NINJA, FILEPATHS or SCAN_DEPS.
+      translation_units: List of the paths of the translation units.
+      files: Dictionary from the path of each file to the list of indices in
+        |translation_units| of the translation units that include it.
+    """
+    self.source = source
+    self.__translation_units = translation_units
+    self.__files = files
+
+  @staticmethod
+  def Build(source, build_directory, includes):
+    """Builds an index from a forward include graph.
+
+    Args:
+      source: How |includes| was obtained, NINJA, FILEPATHS or SCAN_DEPS.
+      build_directory: Directory relative paths in |includes| are relative to.
+      includes: Dictionary from each translation unit to the files it
+        includes, e.g. as returned by compile_db.ParseNinjaDeps.
+    """
+    real_path = _RealPaths(os.path.abspath(build_directory))
+    translation_units = sorted(set(real_path(tu) for tu in includes))
+    index = {tu: i for i, tu in enumerate(translation_units)}
+    files = {}
+    for tu, headers in includes.items():
+      i = index[real_path(tu)]
+      for header in headers:
+        files.setdefault(real_path(header), set()).add(i)
+    return IncludeIndex(
+        source, translation_units,
+        {path: sorted(includers)
+         for path, includers in files.items()})
+
+  @staticmethod
+  def Load(path):
+    with gzip.open(path, 'rt', encoding='utf-8') as f:
+      contents = json.load(f)
+    return IncludeIndex(contents['source'], contents['translation_units'],
+                        contents['files'])
+
+  def Save(self, path):
+    """Writes the index to |path|, replacing it atomically."""
+    directory = os.path.dirname(os.path.abspath(path))
+    fd, temp_path = tempfile.mkstemp(dir=directory, suffix='.tmp')
+    try:
+      with os.fdopen(fd, 'wb') as raw, gzip.open(raw, 'wt',
+                                                 encoding='utf-8') as f:
+        json.dump(
+            {
+                'source': self.source,
+                'translation_units': self.__translation_units,
+                'files': self.__files,
+            }, f)
+      os.replace(temp_path, path)
+    except:
+      os.unlink(temp_path)
+      raise
+
+  def __len__(self):
+    return len(self.__translation_units)
+
+  def TranslationUnitsIncluding(self, paths):
+    """Returns the set of translation units that include any of |paths|."""
+    includers = set()
+    for path in paths:
+      includers.update(self.__files.get(path, ()))
+    return set(self.__translation_units[i] for i in includers)
+
+
+def ReadFilepaths(build_directory, translation_units):
+  """Reads the files included by |translation_units| from the .filepaths files
+  written next to them by the translation_unit tool.
+
+  Args:
+    build_directory: Directory the translation_unit tool was run in, which the
+      paths in .filepaths files are relative to.
+    translation_units: Paths of the source files, relative to
+      |build_directory|. Those without a .filepaths file are skipped.
+
+  Returns:
+    A dictionary from each translation unit to the list of files it includes,
+    for IncludeIndex.Build.
+  """
+  includes = {}
+  for tu in translation_units:
+    filepaths = os.path.join(build_directory, tu) + '.filepaths'
+    if not os.path.exists(filepaths):
+      continue
+    with open(filepaths) as f:
+      # System headers are written as <search path>//<relative path>; the
+      # double slash goes away when the path is resolved.
+      includes[tu] = [line.rstrip('\n') for line in f if line.strip()]
+  return includes
+
+
+def ReadScanDepsIndex(path):
+  """Reads the index written by translation_unit --scan-deps-index.
+
+  Returns:
+    A dictionary from each source file to the set of files it reads, for
+    IncludeIndex.Build. Paths are absolute.
+  """
+  with open(path, 'rb') as f:
+    data = f.read()
+  if not data.startswith(_SCAN_DEPS_INDEX_MAGIC):
+    raise ValueError('%s is not a translation_unit --scan-deps-index file' %
+                     path)
+  offset = len(_SCAN_DEPS_INDEX_MAGIC)
+
+  def Read(count):
+    nonlocal offset
+    values = struct.unpack_from('<%dI' % count, data, offset)
+    offset += 4 * count
+    return values
+
+  num_paths, num_sources = Read(2)
+  paths = []
+  for _ in range(num_paths):
+    (length, ) = Read(1)
+    paths.append(data[offset:offset + length].decode('utf-8',
+                                                     'surrogateescape'))
+    offset += length
+
+  includes = {}
+  for _ in range(num_sources):
+    source, num_ranges = Read(2)
+    ranges = Read(2 * num_ranges)
+    # A source compiled by several commands gets the union of their files.
+    files = includes.setdefault(paths[source], set())
+    for first, count in zip(ranges[::2], ranges[1::2]):
+      files.update(paths[first:first + count])
+  return includes
@@ -0,0 +1,125 @@
+#!/usr/bin/env vpython3
+# Copyright 2026 The Chromium Authors
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+
+"""Tests for include_index."""
+
+import os
+import shutil
+import struct
+import tempfile
+import unittest
+
+import include_index
+
+
+class IncludeIndexTest(unittest.TestCase):
+
+  def setUp(self):
+    self.temp_dir = os.path.realpath(tempfile.mkdtemp())
+    self.build_dir = os.path.join(self.temp_dir, 'out', 'Default')
+    os.makedirs(self.build_dir)
+
+  def tearDown(self):
+    shutil.rmtree(self.temp_dir)
+
+  def _Path(self, path):
+    return os.path.join(self.temp_dir, path)
+
+  def _Build(self):
+    return include_index.IncludeIndex.Build(
+        include_index.NINJA, self.build_dir, {
+            '../../a.cc': ['../../base/x.h', '../../base/y.h'],
+            '../../b.cc': ['../../base/y.h', 'gen/z.h'],
+            '../../c.cc': [],
+        })
+
+  def testTranslationUnitsIncluding(self):
+    index = self._Build()
+    self.assertEqual(3, len(index))
+    self.assertEqual({self._Path('a.cc')},
+                     index.TranslationUnitsIncluding([self._Path('base/x.h')]))
+    self.assertEqual({self._Path('a.cc'), self._Path('b.cc')},
+                     index.TranslationUnitsIncluding(
+                         [self._Path('base/x.h'),
+                          self._Path('base/y.h')]))
+    self.assertEqual({self._Path('b.cc')},
+                     index.TranslationUnitsIncluding(
+                         [self._Path('out/Default/gen/z.h')]))
+    self.assertEqual(set(),
+                     index.TranslationUnitsIncluding([self._Path('other.h')]))
+
+  def testResolvesSymlinks(self):
+    os.makedirs(self._Path('base'))
+    with open(self._Path('base/x.h'), 'w'):
+      pass
+    os.symlink(self._Path('base'), self._Path('link'))
+    index = include_index.IncludeIndex.Build(
+        include_index.NINJA, self.build_dir,
+        {'../../a.cc': ['../../link/x.h']})
+    self.assertEqual({self._Path('a.cc')},
+                     index.TranslationUnitsIncluding([self._Path('base/x.h')]))
+
+  def testSaveAndLoad(self):
+    path = self._Path('index.json.gz')
+    self._Build().Save(path)
+    index = include_index.IncludeIndex.Load(path)
+    self.assertEqual(include_index.NINJA, index.source)
+    self.assertEqual({self._Path('a.cc'), self._Path('b.cc')},
+                     index.TranslationUnitsIncluding([self._Path('base/y.h')]))
+
+  def testReadFilepaths(self):
+    with open(os.path.join(self.build_dir, '../../a.cc.filepaths'), 'w') as f:
+      f.write('../../a.cc\n../../base/x.h\n/usr/include//stdio.h\n')
+    includes = include_index.ReadFilepaths(self.build_dir,
+                                           ['../../a.cc', '../../b.cc'])
+    self.assertEqual(
+        {
+            '../../a.cc':
+            ['../../a.cc', '../../base/x.h', '/usr/include//stdio.h']
+        }, includes)
+    index = include_index.IncludeIndex.Build(include_index.FILEPATHS,
+                                             self.build_dir, includes)
+    self.assertEqual({self._Path('a.cc')},
+                     index.TranslationUnitsIncluding(['/usr/include/stdio.h']))
+
+
+class ReadScanDepsIndexTest(unittest.TestCase):
+
+  def setUp(self):
+    self.temp_dir = tempfile.mkdtemp()
+
+  def tearDown(self):
+    shutil.rmtree(self.temp_dir)
+
+  def _Write(self, contents):
+    path = os.path.join(self.temp_dir, 'index')
+    with open(path, 'wb') as f:
+      f.write(contents)
+    return path
+
+  def testRead(self):
+    paths = [b'/src/a.cc', b'/src/a.h', b'/src/b.cc', b'/src/b.h', b'/src/c.h']
+    contents = b'TUINDEX1' + struct.pack('<II', len(paths), 3)
+    for path in paths:
+      contents += struct.pack('<I', len(path)) + path
+    # a.cc reads itself, a.h and b.h.
+    contents += struct.pack('<IIIIII', 0, 2, 0, 2, 3, 1)
+    # b.cc, compiled twice, reads itself and b.h, then itself and c.h.
+    contents += struct.pack('<IIII', 2, 1, 2, 2)
+    contents += struct.pack('<IIIIII', 2, 2, 2, 1, 4, 1)
+    self.assertEqual(
+        {
+            '/src/a.cc': {'/src/a.cc', '/src/a.h', '/src/b.h'},
+            '/src/b.cc': {'/src/b.cc', '/src/b.h', '/src/c.h'},
+        }, include_index.ReadScanDepsIndex(self._Write(contents)))
+
+  def testBadMagic(self):
+    with self.assertRaises(ValueError):
+      include_index.ReadScanDepsIndex(self._Write(b'not an index'))
+
+
+if __name__ == '__main__':
+  unittest.main()
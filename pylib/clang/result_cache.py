@@ -0,0 +1,199 @@
+# Copyright 2026 The Chromium Authors
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+"""On-disk cache of clang tool results, used by run_tool.py --cache-dir.
+
+A result is keyed on the tool (the contents of its binary, its arguments and
+the contents of the files its arguments name), the compile command and the
+contents of every file the translation unit read.
+The files read are only known after running the tool, which reports them
+through its --inputs-file flag, so lookups go through two levels:
+
+  manifests/<command key>.json   inputs read by the last run of a command
+  results/<result key>.json      stdout/stderr of a run; the result key covers
+                                 the command key and the inputs' contents
+
+Entries are written to a temporary file and renamed into place, so several
+run_tool.py workers (or runs) can share a cache directory.
+"""
+
+import hashlib
+import json
+import os
+import re
+import tempfile
+
+# Matches a file name in a Makefile dependency file, where spaces in names are
+# escaped with a backslash.
+_DEPFILE_PATH_RE = re.compile(r'(?:\\ |[^\s])+')
+
+
+def ParseDepfile(text):
+  """Returns the prerequisites listed in a Makefile dependency file.
+
+  Args:
+    text: Contents of a dependency file with a single rule, as written by
+      clang's -dependency-file.
+  """
+  text = text.replace('\\\r\n', ' ').replace('\\\n', ' ')
+  # The rule's target is first; skip past it. A plain ':' can be part of a
+  # Windows path, but the target is always followed by ': '.
+  _, _, prerequisites = text.partition(': ')
+  return [
+      path.replace('\\ ', ' ').replace('\\#', '#').replace('$$', '$')
+      for path in _DEPFILE_PATH_RE.findall(prerequisites)
+  ]
+
+
+def _HashFile(path):
+  h = hashlib.sha256()
+  with open(path, 'rb') as f:
+    for chunk in iter(lambda: f.read(1 << 20), b''):
+      h.update(chunk)
+  return h.hexdigest()
+
+
+def _WriteAtomically(path, contents):
+  directory = os.path.dirname(path)
+  os.makedirs(directory, exist_ok=True)
+  fd, temp_path = tempfile.mkstemp(dir=directory, suffix='.tmp')
+  try:
+    with os.fdopen(fd, 'w') as f:
+      json.dump(contents, f)
+    os.replace(temp_path, path)
+  except:
+    os.unlink(temp_path)
+    raise
+
+
+def _ArgumentFiles(tool_args, directory):
+  """Yields the files named by |tool_args|, e.g. --exclude-fields=<file>, as
+  paths relative to |directory|, the directory the tool runs in."""
+  for arg in tool_args:
+    if arg.startswith('-'):
+      _, _, arg = arg.partition('=')
+    if arg and os.path.isfile(os.path.join(directory, arg)):
+      yield arg
+
+
+class ResultCache(object):
+  """Maps compile commands to previously recorded clang tool output."""
+
+  def __init__(self, cache_dir, toolname, tool_args, build_directory):
+    """Initializer method.
+
+    Args:
+      cache_dir: Directory holding the cache. Created if needed.
+      toolname: Path to the tool binary. Its contents are part of the key.
+      tool_args: Arguments passed to the tool. Can be None. The contents of
+        the files they name are part of the key too.
+      build_directory: Directory the tool runs in, which relative paths in
+        |tool_args| are relative to.
+    """
+    self.__cache_dir = cache_dir
+    tool_args = tool_args or []
+    h = hashlib.sha256()
+    h.update(_HashFile(toolname).encode('utf-8'))
+    h.update(json.dumps(tool_args).encode('utf-8'))
+    for path in _ArgumentFiles(tool_args, build_directory):
+      digest = _HashFile(os.path.join(build_directory, path))
+      h.update(('%s\0%s\0' % (path, digest)).encode('utf-8'))
+    self.__tool_key = h.hexdigest()
+    # Digest of each input file, keyed by (path, mtime, size), so that headers
+    # shared by many translation units are only read once by each instance.
+    # run_tool.py gives each of its workers a single instance for its whole
+    # lifetime.
+    self.__file_digests = {}
+
+  def __getstate__(self):
+    # Only the cache location and tool key are sent to worker processes, which
+    # start with an empty memo.
+    state = self.__dict__.copy()
+    state['_ResultCache__file_digests'] = {}
+    return state
+
+  def __CommandKey(self, directory, filename, arguments):
+    h = hashlib.sha256()
+    h.update(self.__tool_key.encode('utf-8'))
+    h.update(json.dumps([directory, filename, arguments]).encode('utf-8'))
+    return h.hexdigest()
+
+  def __ResultKey(self, command_key, directory, inputs):
+    """Returns the result key, or None if one of |inputs| can't be read."""
+    h = hashlib.sha256()
+    h.update(command_key.encode('utf-8'))
+    for path in inputs:
+      full_path = os.path.join(directory, path)
+      try:
+        stat = os.stat(full_path)
+        stamp = (full_path, stat.st_mtime_ns, stat.st_size)
+        digest = self.__file_digests.get(stamp)
+        if digest is None:
+          digest = _HashFile(full_path)
+          self.__file_digests[stamp] = digest
+      except OSError:
+        return None
+      h.update(('%s\0%s\0' % (path, digest)).encode('utf-8'))
+    return h.hexdigest()
+
+  def __ManifestPath(self, command_key):
+    return os.path.join(self.__cache_dir, 'manifests', command_key + '.json')
+
+  def __ResultPath(self, result_key):
+    return os.path.join(self.__cache_dir, 'results', result_key + '.json')
+
+  def Lookup(self, directory, filename, arguments):
+    """Returns the recorded (stdout_text, stderr_text) of the tool for the
+    given compile command, or None if there is no valid cache entry.
+
+    Args:
+      directory: Directory the tool runs in.
+      filename: Source file passed to the tool.
+      arguments: Compile arguments passed to the tool.
+    """
+    command_key = self.__CommandKey(directory, filename, arguments)
+    try:
+      with open(self.__ManifestPath(command_key)) as f:
+        inputs = json.load(f)['inputs']
+    except (OSError, ValueError, KeyError):
+      return None
+
+    result_key = self.__ResultKey(command_key, directory, inputs)
+    if result_key is None:
+      return None
+    try:
+      with open(self.__ResultPath(result_key)) as f:
+        result = json.load(f)
+      return result['stdout_text'], result['stderr_text']
+    except (OSError, ValueError, KeyError):
+      return None
+
+  def Store(self, directory, filename, arguments, inputs_file, stdout_text,
+            stderr_text):
+    """Records the output of a successful tool run.
+
+    Args:
+      directory: Directory the tool ran in.
+      filename: Source file passed to the tool.
+      arguments: Compile arguments passed to the tool.
+      inputs_file: Dependency file written by the tool's --inputs-file flag.
+      stdout_text: Output of the tool.
+      stderr_text: Diagnostics of the tool.
+    """
+    try:
+      with open(inputs_file) as f:
+        inputs = sorted(set(ParseDepfile(f.read())))
+    except OSError:
+      # The tool didn't report its inputs, so the result can't be validated
+      # later.
+      return
+
+    command_key = self.__CommandKey(directory, filename, arguments)
+    result_key = self.__ResultKey(command_key, directory, inputs)
+    if result_key is None:
+      return
+    _WriteAtomically(self.__ResultPath(result_key), {
+        'stdout_text': stdout_text,
+        'stderr_text': stderr_text,
+    })
+    _WriteAtomically(self.__ManifestPath(command_key), {'inputs': inputs})
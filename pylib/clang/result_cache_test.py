@@ -0,0 +1,141 @@
+#!/usr/bin/env vpython3
+# Copyright 2026 The Chromium Authors
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+
+"""Tests for result_cache."""
+
+import os
+import pickle
+import shutil
+import tempfile
+import unittest
+from unittest import mock
+
+import result_cache
+
+
+class ParseDepfileTest(unittest.TestCase):
+
+  def testSingleLine(self):
+    self.assertEqual(['../../a.cc', '../../a.h'],
+                     result_cache.ParseDepfile('inputs: ../../a.cc ../../a.h\n'))
+
+  def testContinuationLines(self):
+    self.assertEqual(['../../a.cc', '/usr/include/vector', 'gen/b.h'],
+                     result_cache.ParseDepfile('inputs: ../../a.cc \\\n'
+                                               '  /usr/include/vector \\\n'
+                                               '  gen/b.h\n'))
+
+  def testEscapes(self):
+    self.assertEqual(['dir with space/a#1.h', 'x$y.h'],
+                     result_cache.ParseDepfile(
+                         'inputs: dir\\ with\\ space/a\\#1.h x$$y.h\n'))
+
+  def testWindowsPaths(self):
+    self.assertEqual([r'C:\src\a.cc', r'C:\src\a.h'],
+                     result_cache.ParseDepfile(
+                         'inputs: C:\\src\\a.cc \\\r\n  C:\\src\\a.h\r\n'))
+
+
+class ResultCacheTest(unittest.TestCase):
+
+  def setUp(self):
+    self.temp_dir = tempfile.mkdtemp()
+    self.build_dir = os.path.join(self.temp_dir, 'out')
+    os.mkdir(self.build_dir)
+    self.tool = self._Write('tool', 'v1')
+    self._Write('a.cc', '#include "a.h"')
+    self._Write('a.h', 'int x;')
+    self.inputs_file = self._Write('inputs.d', 'inputs: ../a.cc ../a.h\n')
+    self.cache = self._NewCache()
+
+  def tearDown(self):
+    shutil.rmtree(self.temp_dir)
+
+  def _Write(self, name, contents):
+    path = os.path.join(self.temp_dir, name)
+    with open(path, 'w') as f:
+      f.write(contents)
+    return path
+
+  def _NewCache(self, tool_args=None):
+    return result_cache.ResultCache(os.path.join(self.temp_dir, 'cache'),
+                                    self.tool, tool_args, self.build_dir)
+
+  def _Lookup(self, cache=None, arguments=('-c', )):
+    return (cache or self.cache).Lookup(self.build_dir, '../a.cc',
+                                        list(arguments))
+
+  def _Store(self):
+    self.cache.Store(self.build_dir, '../a.cc', ['-c'], self.inputs_file,
+                     'edits', 'warnings')
+
+  def testHit(self):
+    self.assertIsNone(self._Lookup())
+    self._Store()
+    self.assertEqual(('edits', 'warnings'), self._Lookup())
+    self.assertEqual(('edits', 'warnings'), self._Lookup(self._NewCache()))
+
+  def testHitAfterPickling(self):
+    self._Store()
+    self.assertEqual(('edits', 'warnings'),
+                     self._Lookup(pickle.loads(pickle.dumps(self.cache))))
+
+  def testMissOnChangedInput(self):
+    self._Store()
+    self._Write('a.h', 'int y;')
+    self.assertIsNone(self._Lookup(self._NewCache()))
+
+  def testMissOnDeletedInput(self):
+    self._Store()
+    os.unlink(os.path.join(self.temp_dir, 'a.h'))
+    self.assertIsNone(self._Lookup(self._NewCache()))
+
+  def testMissOnChangedCommand(self):
+    self._Store()
+    self.assertIsNone(self._Lookup(arguments=('-c', '-DFOO')))
+
+  def testMissOnChangedTool(self):
+    self._Store()
+    self._Write('tool', 'v2')
+    self.assertIsNone(self._Lookup(self._NewCache()))
+    self.assertIsNone(self._Lookup(self._NewCache(['--some-flag'])))
+
+  def testMissOnChangedArgumentFile(self):
+    self._Write('fields.txt', 'A::b')
+    self.cache = self._NewCache(['--exclude-fields=../fields.txt'])
+    self._Store()
+    self.assertEqual(('edits', 'warnings'),
+                     self._Lookup(
+                         self._NewCache(['--exclude-fields=../fields.txt'])))
+    self._Write('fields.txt', 'A::c')
+    self.assertIsNone(
+        self._Lookup(self._NewCache(['--exclude-fields=../fields.txt'])))
+
+  def testSharedHeaderHashedOnce(self):
+    # Like a run_tool.py worker, which receives its cache once and then runs
+    # many entries with it.
+    cache = pickle.loads(pickle.dumps(self.cache))
+    self._Write('b.cc', '#include "a.h"')
+    b_inputs_file = self._Write('b.inputs.d', 'inputs: ../b.cc ../a.h\n')
+    with mock.patch.object(result_cache,
+                           '_HashFile',
+                           wraps=result_cache._HashFile) as hash_file:
+      cache.Store(self.build_dir, '../a.cc', ['-c'], self.inputs_file, 'a',
+                  '')
+      cache.Store(self.build_dir, '../b.cc', ['-c'], b_inputs_file, 'b', '')
+      self.assertEqual(('b', ''),
+                       cache.Lookup(self.build_dir, '../b.cc', ['-c']))
+    hashed = [os.path.basename(c.args[0]) for c in hash_file.call_args_list]
+    self.assertEqual(['a.cc', 'a.h', 'b.cc'], sorted(hashed))
+
+  def testNoInputsReported(self):
+    os.unlink(self.inputs_file)
+    self._Store()
+    self.assertIsNone(self._Lookup())
+
+
+if __name__ == '__main__':
+  unittest.main()
@@ -0,0 +1,102 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "BatchMode.h"
+
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "PrefixHeaderPch.h"
+#include "clang/Tooling/ArgumentsAdjusters.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace raw_ptr_plugin {
+
+const char kBatchEntryDoneMarker[] = "==== END OF BATCH ENTRY";
+
+namespace {
+
+struct BatchEntry {
+  std::string file;
+  std::vector<std::string> arguments;
+  std::optional<std::string> inputs_file;
+};
+
+bool fromJSON(const llvm::json::Value& value,
+              BatchEntry& entry,
+              llvm::json::Path path) {
+  llvm::json::ObjectMapper mapper(value, path);
+  return mapper && mapper.map("file", entry.file) &&
+         mapper.map("arguments", entry.arguments) &&
+         mapper.mapOptional("inputs_file", entry.inputs_file);
+}
+
+}  // namespace
+
+int RunToolInBatchMode(clang::tooling::FrontendActionFactory* factory,
+                       llvm::function_ref<void()> end_of_entry,
+                       PrefixHeaderPch* prefix_header_pch) {
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    if (line.empty())
+      continue;
+
+    llvm::Expected<BatchEntry> entry = llvm::json::parse<BatchEntry>(line);
+    if (!entry) {
+      llvm::errs() << "Malformed batch request: "
+                   << llvm::toString(entry.takeError()) << "\n";
+      return 1;
+    }
+
+    // Go through the same command line handling as a non-batch run, which
+    // receives the compile command after "--".
+    std::vector<const char*> argv = {"batch", "--"};
+    for (const std::string& arg : entry->arguments)
+      argv.push_back(arg.c_str());
+    int argc = argv.size();
+    std::string error_message;
+    std::unique_ptr<clang::tooling::FixedCompilationDatabase> compilations =
+        clang::tooling::FixedCompilationDatabase::loadFromCommandLine(
+            argc, argv.data(), error_message);
+
+    int result = 1;
+    if (compilations) {
+      clang::tooling::ClangTool tool(*compilations, {entry->file});
+      // This goes first, as the PCH is keyed on the compile command.
+      if (prefix_header_pch)
+        tool.appendArgumentsAdjuster(prefix_header_pch->GetArgumentsAdjuster());
+      if (entry->inputs_file)
+        ReportToolInputs(tool, *entry->inputs_file);
+      result = tool.run(factory);
+    } else {
+      llvm::errs() << "Invalid compile command for " << entry->file << ": "
+                   << error_message << "\n";
+    }
+
+    end_of_entry();
+    llvm::outs() << kBatchEntryDoneMarker << " " << result << " ====\n";
+    llvm::outs().flush();
+  }
+  return 0;
+}
+
+void ReportToolInputs(clang::tooling::ClangTool& tool,
+                      const std::string& path) {
+  // ClangTool strips -M* flags from the compile command before running
+  // adjusters appended here, and the driver-level spelling differs between
+  // clang and clang-cl, so ask for the dependency file at the cc1 level.
+  // System headers are included so that e.g. libc++ updates are noticed.
+  tool.appendArgumentsAdjuster(clang::tooling::getInsertArgumentAdjuster(
+      {"-Xclang", "-dependency-file", "-Xclang", path, "-Xclang", "-MT",
+       "-Xclang", "inputs", "-Xclang", "-sys-header-deps"},
+      clang::tooling::ArgumentInsertPosition::END));
+}
+
+}  // namespace raw_ptr_plugin
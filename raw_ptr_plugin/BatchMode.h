@@ -0,0 +1,56 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_CLANG_RAW_PTR_PLUGIN_BATCHMODE_H_
+#define TOOLS_CLANG_RAW_PTR_PLUGIN_BATCHMODE_H_
+
+#include <string>
+
+#include "llvm/ADT/STLFunctionalExtras.h"
+
+namespace clang::tooling {
+class ClangTool;
+class FrontendActionFactory;
+}  // namespace clang::tooling
+
+namespace raw_ptr_plugin {
+
+class PrefixHeaderPch;
+
+// Prefix of the line written to stdout after each compile command processed in
+// batch mode. run_tool.py waits for it before handing the worker its next
+// entry. The full line is:
+//     ==== END OF BATCH ENTRY <exit status> ====
+extern const char kBatchEntryDoneMarker[];
+
+// Runs a ClangTool-based rewriter as a long-lived worker process, so that
+// process startup, option parsing and matcher construction are paid once
+// instead of once per translation unit.
+//
+// Compile commands are read from stdin, one JSON object per line:
+//     {"file": "../../foo.cc", "arguments": ["clang++", "-c", ...],
+//      "inputs_file": "/tmp/foo.d"}
+// |arguments| has the same meaning as the arguments following "--" on the
+// command line of a non-batch run. The optional |inputs_file| is passed to
+// ReportToolInputs() for that command. Each command is run through |factory| in
+// the current directory, then |end_of_entry| is called so that the tool can
+// emit and reset any output accumulated for that entry, and finally
+// kBatchEntryDoneMarker is written and stdout is flushed.
+//
+// If |prefix_header_pch| is not null, each command uses its PCHs, which are
+// then shared by all of the commands with the same flags.
+//
+// Returns 0 once stdin is exhausted, or 1 if a request is malformed.
+int RunToolInBatchMode(clang::tooling::FrontendActionFactory* factory,
+                       llvm::function_ref<void()> end_of_entry,
+                       PrefixHeaderPch* prefix_header_pch = nullptr);
+
+// Makes |tool| write the list of files read by the translation unit to |path|,
+// in Makefile dependency format. run_tool.py --cache-dir keys its result cache
+// on the contents of these files.
+void ReportToolInputs(clang::tooling::ClangTool& tool, const std::string& path);
+
+}  // namespace raw_ptr_plugin
+
+#endif  // TOOLS_CLANG_RAW_PTR_PLUGIN_BATCHMODE_H_
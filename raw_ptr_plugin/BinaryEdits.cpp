@@ -0,0 +1,118 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "BinaryEdits.h"
+
+#include <algorithm>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/LEB128.h"
+
+namespace raw_ptr_plugin {
+
+namespace {
+
+// Must match MAGIC in tools/clang/pylib/clang/binary_edits.py.
+constexpr char kStreamMagic[] = "\0cr-binary-edits-1\n";
+
+void WriteString(llvm::raw_ostream& out, llvm::StringRef str) {
+  llvm::encodeULEB128(str.size(), out);
+  out << str;
+}
+
+}  // namespace
+
+void BinaryEditsWriter::AddReplacement(llvm::StringRef path,
+                                       unsigned offset,
+                                       unsigned length,
+                                       llvm::StringRef replacement_text) {
+  edits_.emplace(path.str(), EditType::kReplacement, offset, length,
+                 replacement_text.str());
+}
+
+void BinaryEditsWriter::AddInclude(llvm::StringRef path,
+                                   llvm::StringRef include_path,
+                                   bool is_system_include_path) {
+  edits_.emplace(path.str(),
+                 is_system_include_path ? EditType::kIncludeSystemHeader
+                                        : EditType::kIncludeUserHeader,
+                 0, 0, include_path.str());
+}
+
+bool BinaryEditsWriter::AddDirective(llvm::StringRef directive) {
+  llvm::SmallVector<llvm::StringRef, 5> fields;
+  directive.split(fields, ":::", /*MaxSplit=*/4);
+  if (fields.size() != 5)
+    return false;
+  // Newlines are escaped as '\0' in text directives.
+  std::string text = fields[4].str();
+  std::replace(text.begin(), text.end(), '\0', '\n');
+
+  if (fields[0] == "r") {
+    unsigned offset;
+    unsigned length;
+    if (fields[2].getAsInteger(10, offset) ||
+        fields[3].getAsInteger(10, length)) {
+      return false;
+    }
+    AddReplacement(fields[1], offset, length, text);
+    return true;
+  }
+  if (fields[0] == "include-user-header" ||
+      fields[0] == "include-system-header") {
+    AddInclude(fields[1], text, fields[0] == "include-system-header");
+    return true;
+  }
+  return false;
+}
+
+void BinaryEditsWriter::Emit(llvm::raw_ostream& out) {
+  if (edits_.empty())
+    return;
+
+  llvm::SmallString<4096> payload;
+  llvm::raw_svector_ostream payload_out(payload);
+  EncodePayload(payload_out);
+
+  out << "==== BEGIN BINARY EDITS " << payload.size() << " ====\n";
+  out << payload;
+  out << "\n==== END BINARY EDITS ====\n";
+  edits_.clear();
+}
+
+void BinaryEditsWriter::EmitStream(llvm::raw_ostream& out) {
+  out.write(kStreamMagic, sizeof(kStreamMagic) - 1);
+  EncodePayload(out);
+  edits_.clear();
+}
+
+void BinaryEditsWriter::EncodePayload(llvm::raw_ostream& out) const {
+  // |edits_| is sorted by path, so the path table is built in sorted order.
+  llvm::StringMap<unsigned> path_indices;
+  llvm::SmallVector<llvm::StringRef, 16> paths;
+  for (const Edit& edit : edits_) {
+    const std::string& path = std::get<0>(edit);
+    if (path_indices.try_emplace(path, paths.size()).second)
+      paths.push_back(path);
+  }
+
+  llvm::encodeULEB128(paths.size(), out);
+  for (llvm::StringRef path : paths)
+    WriteString(out, path);
+
+  llvm::encodeULEB128(edits_.size(), out);
+  for (const auto& [path, type, offset, length, text] : edits_) {
+    llvm::encodeULEB128(static_cast<unsigned>(type), out);
+    llvm::encodeULEB128(path_indices[path], out);
+    if (type == EditType::kReplacement) {
+      llvm::encodeULEB128(offset, out);
+      llvm::encodeULEB128(length, out);
+    }
+    WriteString(out, text);
+  }
+}
+
+}  // namespace raw_ptr_plugin
@@ -0,0 +1,94 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_CLANG_RAW_PTR_PLUGIN_BINARYEDITS_H_
+#define TOOLS_CLANG_RAW_PTR_PLUGIN_BINARYEDITS_H_
+
+#include <set>
+#include <string>
+#include <tuple>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace raw_ptr_plugin {
+
+// BinaryEditsWriter gathers edits and emits them as a compact, length-prefixed
+// section, as an alternative to the text directives
+//     r:::<path>:::<offset>:::<length>:::<replacement text>
+// which repeat the path on every line and need newlines escaped.
+//
+// The section looks like this, where <size> is the size of the payload in
+// bytes:
+//     ==== BEGIN BINARY EDITS <size> ====
+//     <payload>
+//     ==== END BINARY EDITS ====
+//
+// The payload is a sequence of ULEB128 integers and length-prefixed strings:
+//     <path count> (<length> <path bytes>)...
+//     <edit count> (<type> <path index> [<offset> <length>]
+//                   <length> <text bytes>)...
+// where <type> is one of EditType, and <offset> and <length> are only present
+// for replacements. The text is the replacement text or the header to include.
+//
+// tools/clang/pylib/clang/binary_edits.py reads this format, and
+// extract_edits.py and apply_edits.py accept it alongside the text format.
+//
+// rewrite_raw_ptr_fields and base_bind_rewriters use it with --binary-edits,
+// and spanify_extract_edits with --binary-edits writes the edits it selects as
+// a stream. The other rewriters still print text directives only; both can be
+// mixed in one run.
+class BinaryEditsWriter {
+ public:
+  // Must match EDIT_TYPES in tools/clang/pylib/clang/binary_edits.py.
+  enum class EditType : unsigned {
+    kReplacement = 0,
+    kIncludeUserHeader = 1,
+    kIncludeSystemHeader = 2,
+  };
+
+  BinaryEditsWriter() = default;
+  BinaryEditsWriter(const BinaryEditsWriter&) = delete;
+  BinaryEditsWriter& operator=(const BinaryEditsWriter&) = delete;
+
+  void AddReplacement(llvm::StringRef path,
+                      unsigned offset,
+                      unsigned length,
+                      llvm::StringRef replacement_text);
+
+  void AddInclude(llvm::StringRef path,
+                  llvm::StringRef include_path,
+                  bool is_system_include_path = false);
+
+  // Adds the edit described by a text directive, e.g.
+  //     r:::<path>:::<offset>:::<length>:::<replacement text>
+  // for tools whose edits go through an intermediate format before being
+  // emitted. Returns false, and adds nothing, if |directive| is malformed.
+  bool AddDirective(llvm::StringRef directive);
+
+  // Writes the gathered edits, if any, as a section to |out| and forgets them.
+  // Edits are deduplicated and sorted, so the output is deterministic.
+  void Emit(llvm::raw_ostream& out);
+
+  // Writes the gathered edits to |out| as a whole stream, in the form
+  // extract_edits.py writes after merging sections, which apply_edits.py reads
+  // directly, and forgets them. Unlike Emit(), always writes a stream, possibly
+  // with no edits.
+  void EmitStream(llvm::raw_ostream& out);
+
+  // Forgets the gathered edits without writing them.
+  void Clear() { edits_.clear(); }
+
+ private:
+  using Edit = std::
+      tuple<std::string, EditType, unsigned, unsigned, std::string>;
+
+  void EncodePayload(llvm::raw_ostream& out) const;
+
+  std::set<Edit> edits_;
+};
+
+}  // namespace raw_ptr_plugin
+
+#endif  // TOOLS_CLANG_RAW_PTR_PLUGIN_BINARYEDITS_H_
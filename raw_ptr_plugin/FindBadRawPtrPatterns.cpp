@@ -361,72 +361,113 @@ class SpanFieldMatcher : public MatchFinder::MatchCallback {
   const RawPtrAndRefExclusionsOptions& exclusion_options_;
 };
 
-void FindBadRawPtrPatterns(const Options& options,
-                           clang::ASTContext& ast_context,
-                           clang::CompilerInstance& compiler) {
-  llvm::StringMap<llvm::TimeRecord> Records;
-  MatchFinder::MatchFinderOptions FinderOptions;
-  if (options.enable_match_profiling) {
-    FinderOptions.CheckProfiling.emplace(Records);
-  }
-  MatchFinder match_finder(std::move(FinderOptions));
+namespace {
 
+std::vector<std::string> GetPathsToExcludeLines(const Options& options) {
   std::vector<std::string> paths_to_exclude_lines;
-  std::vector<std::string> check_bad_raw_ptr_cast_exclude_paths;
   for (auto* const line : kRawPtrManualPathsToIgnore) {
     paths_to_exclude_lines.push_back(line);
   }
   for (auto* const line : kSeparateRepositoryPaths) {
     paths_to_exclude_lines.push_back(line);
-    check_bad_raw_ptr_cast_exclude_paths.push_back(line);
   }
   paths_to_exclude_lines.insert(paths_to_exclude_lines.end(),
                                 options.raw_ptr_paths_to_exclude_lines.begin(),
                                 options.raw_ptr_paths_to_exclude_lines.end());
+  return paths_to_exclude_lines;
+}
+
+std::vector<std::string> GetCheckBadRawPtrCastExcludePaths(
+    const Options& options) {
+  std::vector<std::string> check_bad_raw_ptr_cast_exclude_paths;
+  for (auto* const line : kSeparateRepositoryPaths) {
+    check_bad_raw_ptr_cast_exclude_paths.push_back(line);
+  }
   check_bad_raw_ptr_cast_exclude_paths.insert(
       check_bad_raw_ptr_cast_exclude_paths.end(),
       options.check_bad_raw_ptr_cast_exclude_paths.begin(),
       options.check_bad_raw_ptr_cast_exclude_paths.end());
+  return check_bad_raw_ptr_cast_exclude_paths;
+}
 
-  FilterFile exclude_fields(options.exclude_fields_file, "exclude-fields");
-  FilterFile exclude_lines(paths_to_exclude_lines);
-
+}  // namespace
+
+// Everything the matchers refer to, so that it lives as long as the
+// BadRawPtrPatternsFinder.
+struct BadRawPtrPatternsFinder::State {
+  State(const Options& options, clang::CompilerInstance& compiler)
+      : options(options),
+        exclude_fields(options.exclude_fields_file, "exclude-fields"),
+        exclude_lines(GetPathsToExcludeLines(options)),
+        exclusion_options{&exclude_fields, &exclude_lines,
+                          options.check_raw_ptr_to_stack_allocated,
+                          &stack_allocated_predicate,
+                          options.check_ptrs_to_non_string_literals},
+        filter_check_bad_raw_ptr_cast_exclude_paths(
+            GetCheckBadRawPtrCastExcludePaths(options)),
+        filter_check_bad_raw_ptr_cast_exclude_funcs(
+            options.check_bad_raw_ptr_cast_exclude_funcs),
+        bad_cast_matcher(compiler,
+                         filter_check_bad_raw_ptr_cast_exclude_paths,
+                         filter_check_bad_raw_ptr_cast_exclude_funcs),
+        field_matcher(compiler, exclusion_options),
+        ref_field_matcher(compiler, exclusion_options),
+        raw_ptr_to_stack(compiler),
+        raw_span_matcher(compiler, exclusion_options) {}
+
+  const Options options;
+  FilterFile exclude_fields;
+  FilterFile exclude_lines;
   StackAllocatedPredicate stack_allocated_predicate;
-  RawPtrAndRefExclusionsOptions exclusion_options{
-      &exclude_fields, &exclude_lines, options.check_raw_ptr_to_stack_allocated,
-      &stack_allocated_predicate, options.check_ptrs_to_non_string_literals};
-
-  FilterFile filter_check_bad_raw_ptr_cast_exclude_paths(
-      check_bad_raw_ptr_cast_exclude_paths);
-  FilterFile filter_check_bad_raw_ptr_cast_exclude_funcs(
-      options.check_bad_raw_ptr_cast_exclude_funcs);
-  BadCastMatcher bad_cast_matcher(compiler,
-                                  filter_check_bad_raw_ptr_cast_exclude_paths,
-                                  filter_check_bad_raw_ptr_cast_exclude_funcs);
+  RawPtrAndRefExclusionsOptions exclusion_options;
+  FilterFile filter_check_bad_raw_ptr_cast_exclude_paths;
+  FilterFile filter_check_bad_raw_ptr_cast_exclude_funcs;
+  BadCastMatcher bad_cast_matcher;
+  RawPtrFieldMatcher field_matcher;
+  RawRefFieldMatcher ref_field_matcher;
+  RawPtrToStackAllocatedMatcher raw_ptr_to_stack;
+  SpanFieldMatcher raw_span_matcher;
+};
+
+BadRawPtrPatternsFinder::BadRawPtrPatternsFinder(
+    const Options& options,
+    clang::CompilerInstance& compiler)
+    : state_(std::make_unique<State>(options, compiler)) {}
+
+BadRawPtrPatternsFinder::~BadRawPtrPatternsFinder() = default;
+
+void BadRawPtrPatternsFinder::Register(MatchFinder& match_finder) {
+  const Options& options = state_->options;
   if (options.check_bad_raw_ptr_cast) {
-    bad_cast_matcher.Register(match_finder);
+    state_->bad_cast_matcher.Register(match_finder);
   }
-
-  RawPtrFieldMatcher field_matcher(compiler, exclusion_options);
   if (options.check_raw_ptr_fields) {
-    field_matcher.Register(match_finder);
+    state_->field_matcher.Register(match_finder);
   }
-
-  RawRefFieldMatcher ref_field_matcher(compiler, exclusion_options);
   if (options.check_raw_ref_fields) {
-    ref_field_matcher.Register(match_finder);
+    state_->ref_field_matcher.Register(match_finder);
   }
-
-  RawPtrToStackAllocatedMatcher raw_ptr_to_stack(compiler);
   if (options.check_raw_ptr_to_stack_allocated &&
       !options.disable_check_raw_ptr_to_stack_allocated_error) {
-    raw_ptr_to_stack.Register(match_finder);
+    state_->raw_ptr_to_stack.Register(match_finder);
   }
-
-  SpanFieldMatcher raw_span_matcher(compiler, exclusion_options);
   if (options.check_span_fields) {
-    raw_span_matcher.Register(match_finder);
+    state_->raw_span_matcher.Register(match_finder);
   }
+}
+
+void FindBadRawPtrPatterns(const Options& options,
+                           clang::ASTContext& ast_context,
+                           clang::CompilerInstance& compiler) {
+  llvm::StringMap<llvm::TimeRecord> Records;
+  MatchFinder::MatchFinderOptions FinderOptions;
+  if (options.enable_match_profiling) {
+    FinderOptions.CheckProfiling.emplace(Records);
+  }
+  MatchFinder match_finder(std::move(FinderOptions));
+
+  BadRawPtrPatternsFinder finder(options, compiler);
+  finder.Register(match_finder);
 
   {
     llvm::TimeTraceScope TimeScope(
@@ -5,12 +5,36 @@
 #ifndef TOOLS_CLANG_RAW_PTR_PLUGIN_FINDBADRAWPTRPATTERNS_H_
 #define TOOLS_CLANG_RAW_PTR_PLUGIN_FINDBADRAWPTRPATTERNS_H_
 
+#include <memory>
+
 #include "Options.h"
 #include "clang/AST/ASTContext.h"
+#include "clang/ASTMatchers/ASTMatchFinder.h"
 #include "clang/Frontend/CompilerInstance.h"
 
 namespace raw_ptr_plugin {
 
+// Holds the matchers for the checks enabled by |options|. Register() adds them
+// to a MatchFinder, which may be shared with other plugins. They report
+// diagnostics while the finder runs, so the BadRawPtrPatternsFinder must
+// outlive the MatchFinder::matchAST() call.
+class BadRawPtrPatternsFinder {
+ public:
+  BadRawPtrPatternsFinder(const Options& options,
+                          clang::CompilerInstance& compiler);
+  ~BadRawPtrPatternsFinder();
+
+  BadRawPtrPatternsFinder(const BadRawPtrPatternsFinder&) = delete;
+  BadRawPtrPatternsFinder& operator=(const BadRawPtrPatternsFinder&) = delete;
+
+  void Register(clang::ast_matchers::MatchFinder& match_finder);
+
+ private:
+  struct State;
+  std::unique_ptr<State> state_;
+};
+
+// Runs the checks enabled by |options| with a MatchFinder of its own.
 void FindBadRawPtrPatterns(const Options& options,
                            clang::ASTContext& ast_context,
                            clang::CompilerInstance& compiler);
@@ -0,0 +1,190 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "PrefixHeaderPch.h"
+
+#include <utility>
+
+#include "CacheKey.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/FileSystemOptions.h"
+#include "clang/Frontend/FrontendActions.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace raw_ptr_plugin {
+
+namespace {
+
+bool IsCxxSource(llvm::StringRef filename) {
+  llvm::StringRef extension = llvm::sys::path::extension(filename);
+  return extension == ".cc" || extension == ".cpp" || extension == ".cxx" ||
+         extension == ".C";
+}
+
+bool IsClangCl(const clang::tooling::CommandLineArguments& args) {
+  for (const std::string& arg : args) {
+    if (arg == "--driver-mode=cl")
+      return true;
+  }
+  return !args.empty() &&
+         llvm::sys::path::stem(args[0]).ends_with_insensitive("clang-cl");
+}
+
+// Returns |args| without the source file |filename|, which may be spelled
+// differently, e.g. as an absolute path.
+clang::tooling::CommandLineArguments RemoveSourceFile(
+    const clang::tooling::CommandLineArguments& args,
+    llvm::StringRef filename) {
+  llvm::StringRef basename = llvm::sys::path::filename(filename);
+  clang::tooling::CommandLineArguments result;
+  for (const std::string& arg : args) {
+    if (arg == filename || (llvm::sys::path::filename(arg) == basename &&
+                            llvm::sys::fs::equivalent(arg, filename))) {
+      continue;
+    }
+    result.push_back(arg);
+  }
+  return result;
+}
+
+}  // namespace
+
+PrefixHeaderPch::Options::Options(llvm::cl::OptionCategory& category)
+    : header("prefix-header",
+             llvm::cl::value_desc("filepath"),
+             llvm::cl::desc("header to precompile once per distinct compile "
+                            "command and include in each C++ translation "
+                            "unit, to avoid reparsing the headers it "
+                            "includes"),
+             llvm::cl::cat(category)),
+      directory("prefix-header-pch-dir",
+                llvm::cl::value_desc("dirpath"),
+                llvm::cl::desc("directory to share the precompiled "
+                               "--prefix-header in, across processes; a "
+                               "temporary directory by default"),
+                llvm::cl::cat(category)) {}
+
+// static
+std::unique_ptr<PrefixHeaderPch> PrefixHeaderPch::Create(
+    const Options& options) {
+  if (options.header.empty())
+    return nullptr;
+  return std::make_unique<PrefixHeaderPch>(options.header, options.directory);
+}
+
+PrefixHeaderPch::PrefixHeaderPch(std::string header, std::string directory)
+    : directory_(std::move(directory)) {
+  // Compile commands run in their own directory, so the header path must not
+  // depend on it.
+  llvm::SmallString<256> absolute_header(header);
+  llvm::sys::fs::make_absolute(absolute_header);
+  header_ = std::string(absolute_header);
+
+  if (directory_.empty()) {
+    llvm::SmallString<256> temp_directory;
+    if (!llvm::sys::fs::createUniqueDirectory("prefix-header-pch",
+                                              temp_directory)) {
+      directory_ = std::string(temp_directory);
+      owns_directory_ = true;
+    }
+  } else {
+    llvm::SmallString<256> absolute_directory(directory_);
+    llvm::sys::fs::make_absolute(absolute_directory);
+    directory_ = std::string(absolute_directory);
+    llvm::sys::fs::create_directories(directory_);
+  }
+}
+
+PrefixHeaderPch::~PrefixHeaderPch() {
+  if (!owns_directory_)
+    return;
+  for (const std::string& path : built_pchs_)
+    llvm::sys::fs::remove(path);
+  llvm::sys::fs::remove(directory_);
+}
+
+clang::tooling::ArgumentsAdjuster PrefixHeaderPch::GetArgumentsAdjuster() {
+  return [this](const clang::tooling::CommandLineArguments& args,
+                llvm::StringRef filename) {
+    if (directory_.empty() || !IsCxxSource(filename) || IsClangCl(args))
+      return args;
+    const std::string& pch = GetPch(RemoveSourceFile(args, filename));
+    if (pch.empty())
+      return args;
+
+    clang::tooling::CommandLineArguments result = args;
+    result.insert(result.begin() + 1, {"-include-pch", pch});
+    return result;
+  };
+}
+
+const std::string& PrefixHeaderPch::GetPch(
+    const clang::tooling::CommandLineArguments& args) {
+  // Relative paths in |args| are relative to the current directory.
+  llvm::SmallString<256> current_directory;
+  llvm::sys::fs::current_path(current_directory);
+
+  chrome_plugin_host::CacheKey key_builder;
+  key_builder.Add(header_);
+  key_builder.Add(current_directory);
+  for (const std::string& arg : args)
+    key_builder.Add(arg);
+  llvm::SmallString<32> key = key_builder.Finish();
+
+  auto [it, inserted] = pchs_.try_emplace(key);
+  if (!inserted)
+    return it->second;
+
+  llvm::SmallString<256> path(directory_);
+  llvm::sys::path::append(path, llvm::Twine(key) + ".pch");
+  if (llvm::sys::fs::exists(path) || BuildPch(args, std::string(path))) {
+    it->second = std::string(path);
+  } else {
+    llvm::errs() << "Could not precompile " << header_
+                 << "; running without it\n";
+  }
+  return it->second;
+}
+
+bool PrefixHeaderPch::BuildPch(const clang::tooling::CommandLineArguments& args,
+                               const std::string& path) {
+  // Build under a unique name and rename it into place, so that a concurrent
+  // process never sees a partial PCH.
+  llvm::SmallString<256> temp_path;
+  llvm::sys::fs::createUniquePath(path + "-%%%%%%%%.tmp", temp_path,
+                                  /*MakeAbsolute=*/false);
+
+  std::vector<std::string> command_line;
+  for (const std::string& arg : args) {
+    if (arg != "-fsyntax-only")
+      command_line.push_back(arg);
+  }
+  command_line.insert(command_line.end(), {"-xc++-header", header_, "-o",
+                                           std::string(temp_path)});
+
+  llvm::IntrusiveRefCntPtr<clang::FileManager> files(new clang::FileManager(
+      clang::FileSystemOptions(), llvm::vfs::getRealFileSystem()));
+  clang::tooling::ToolInvocation invocation(
+      std::move(command_line), std::make_unique<clang::GeneratePCHAction>(),
+      files.get());
+  if (!invocation.run() || !llvm::sys::fs::exists(temp_path)) {
+    llvm::sys::fs::remove(temp_path);
+    return false;
+  }
+  if (llvm::sys::fs::rename(temp_path, path)) {
+    llvm::sys::fs::remove(temp_path);
+    return false;
+  }
+  built_pchs_.push_back(path);
+  return true;
+}
+
+}  // namespace raw_ptr_plugin
@@ -0,0 +1,87 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_CLANG_RAW_PTR_PLUGIN_PREFIXHEADERPCH_H_
+#define TOOLS_CLANG_RAW_PTR_PLUGIN_PREFIXHEADERPCH_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "clang/Tooling/ArgumentsAdjusters.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
+
+namespace raw_ptr_plugin {
+
+// Lets a ClangTool-based rewriter parse a prefix header, such as one including
+// the STL, base/ and content/public/ headers that most translation units
+// include, once per distinct set of compile flags instead of once per
+// translation unit.
+//
+// The prefix header is precompiled with the flags of the first translation
+// unit that uses them, and every C++ translation unit is then run with
+// -include-pch. Its own #includes of headers in the PCH are skipped by their
+// include guards, and the declarations from the PCH are still visited by the
+// matchers. The PCHs are reused by every later translation unit in the same
+// process (e.g. a run_tool.py --batch worker) and, given a directory, by other
+// processes too.
+//
+// This is only sound if the translation units are not affected by seeing the
+// prefix header first, i.e. if they do not define macros that its headers
+// depend on before including them, which is why it is opt-in. A PCH is
+// rejected by clang if a header it includes changed after it was built, so a
+// shared directory should be emptied after syncing.
+class PrefixHeaderPch {
+ public:
+  // The command line options, added to |category|. These must be created
+  // before the command line is parsed.
+  struct Options {
+    explicit Options(llvm::cl::OptionCategory& category);
+
+    llvm::cl::opt<std::string> header;
+    llvm::cl::opt<std::string> directory;
+  };
+
+  // Returns nullptr if no prefix header was given.
+  static std::unique_ptr<PrefixHeaderPch> Create(const Options& options);
+
+  // PCHs are written to |directory|, which may be shared by concurrent
+  // processes, or, if |directory| is empty, to a temporary directory that is
+  // removed by the destructor.
+  PrefixHeaderPch(std::string header, std::string directory);
+  ~PrefixHeaderPch();
+
+  PrefixHeaderPch(const PrefixHeaderPch&) = delete;
+  PrefixHeaderPch& operator=(const PrefixHeaderPch&) = delete;
+
+  // Returns an adjuster that makes a compile command include the PCH for its
+  // flags, building it first if needed. Commands that are not C++, or for which
+  // the PCH cannot be built, are left unchanged.
+  //
+  // The PCH is keyed on the compile command, so this must run before any
+  // adjuster that adds arguments specific to the translation unit, such as the
+  // one added by ReportToolInputs().
+  clang::tooling::ArgumentsAdjuster GetArgumentsAdjuster();
+
+ private:
+  // Returns the path to the PCH for the compile command |args|, which does
+  // not contain the source file, or an empty string if it cannot be built.
+  const std::string& GetPch(const clang::tooling::CommandLineArguments& args);
+
+  bool BuildPch(const clang::tooling::CommandLineArguments& args,
+                const std::string& path);
+
+  std::string header_;
+  std::string directory_;
+  bool owns_directory_ = false;
+  // The PCH path for each compile command, keyed by the hash of the command.
+  llvm::StringMap<std::string> pchs_;
+  // The PCHs built by this process.
+  std::vector<std::string> built_pchs_;
+};
+
+}  // namespace raw_ptr_plugin
+
+#endif  // TOOLS_CLANG_RAW_PTR_PLUGIN_PREFIXHEADERPCH_H_
@@ -25,30 +25,30 @@ bool FilterFile::ContainsLine(llvm::StringRef line) const {
 }
 
 bool FilterFile::ContainsSubstringOf(llvm::StringRef string_to_match) const {
-  if (!inclusion_substring_regex_.has_value()) {
-    std::vector<std::string> regex_escaped_inclusion_file_lines;
-    std::vector<std::string> regex_escaped_exclusion_file_lines;
-    regex_escaped_inclusion_file_lines.reserve(file_lines_.size());
+  if (!inclusion_matcher_.has_value()) {
+    std::vector<llvm::StringRef> inclusion_file_lines;
+    std::vector<llvm::StringRef> exclusion_file_lines;
+    inclusion_file_lines.reserve(file_lines_.size());
     for (const llvm::StringRef& file_line : file_lines_.keys()) {
       if (file_line.starts_with("!")) {
-        regex_escaped_exclusion_file_lines.push_back(
-            llvm::Regex::escape(file_line.substr(1)));
+        exclusion_file_lines.push_back(file_line.substr(1));
       } else {
-        regex_escaped_inclusion_file_lines.push_back(
-            llvm::Regex::escape(file_line));
+        inclusion_file_lines.push_back(file_line);
       }
     }
-    std::string inclusion_substring_regex_pattern =
-        llvm::join(regex_escaped_inclusion_file_lines.begin(),
-                   regex_escaped_inclusion_file_lines.end(), "|");
-    inclusion_substring_regex_.emplace(inclusion_substring_regex_pattern);
-    std::string exclusion_substring_regex_pattern =
-        llvm::join(regex_escaped_exclusion_file_lines.begin(),
-                   regex_escaped_exclusion_file_lines.end(), "|");
-    exclusion_substring_regex_.emplace(exclusion_substring_regex_pattern);
+    inclusion_matcher_.emplace(inclusion_file_lines);
+    exclusion_matcher_.emplace(exclusion_file_lines);
   }
-  return inclusion_substring_regex_->match(string_to_match) &&
-         !exclusion_substring_regex_->match(string_to_match);
+  return inclusion_matcher_->MatchesSubstringOf(string_to_match) &&
+         !exclusion_matcher_->MatchesSubstringOf(string_to_match);
+}
+
+bool FilterFile::ContainsSubstringOfFileAt(const clang::SourceManager& sm,
+                                           clang::SourceLocation loc) const {
+  return file_results_.Get(sm, sm.getFileID(sm.getSpellingLoc(loc)), [&] {
+    return ContainsSubstringOf(
+        GetFilename(sm, loc, FilenameLocationType::kSpellingLoc));
+  });
 }
 
 void FilterFile::ParseInputFile(const std::string& filepath,
@@ -5,13 +5,18 @@
 #ifndef TOOLS_CLANG_RAW_PTR_PLUGIN_RAWPTRHELPERS_H_
 #define TOOLS_CLANG_RAW_PTR_PLUGIN_RAWPTRHELPERS_H_
 
+#include <memory>
 #include <optional>
+#include <string>
 
 #include "RawPtrCastingUnsafeChecker.h"
 #include "StackAllocatedChecker.h"
+#include "SubstringMatcher.h"
 #include "Util.h"
 #include "clang/ASTMatchers/ASTMatchers.h"
 #include "clang/ASTMatchers/ASTMatchersMacros.h"
+#include "clang/Basic/SourceLocation.h"
+#include "clang/Basic/SourceManager.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Support/CommandLine.h"
 
@@ -47,6 +52,11 @@ class FilterFile {
   // is *not* matched by an exclusion filter.
   bool ContainsSubstringOf(llvm::StringRef string_to_match) const;
 
+  // Same as ContainsSubstringOf(), applied to the name of the file holding the
+  // spelling location of |loc|. Results are cached per FileID.
+  bool ContainsSubstringOfFileAt(const clang::SourceManager& sm,
+                                 clang::SourceLocation loc) const;
+
  private:
   void ParseInputFile(const std::string& filepath, const std::string& arg_name);
 
@@ -56,13 +66,17 @@ class FilterFile {
   // |file_lines_| is partitioned based on whether the line starts with a !
   // (exclusion line) or not (inclusion line). Inclusion lines specify things to
   // be matched by the filter. The exclusion lines specify what to force exclude
-  // from the filter. Lazily-constructed regex that matches strings that contain
-  // any of the inclusion lines in |file_lines_|.
-  mutable std::optional<llvm::Regex> inclusion_substring_regex_;
+  // from the filter. Lazily-constructed matcher for strings that contain any of
+  // the inclusion lines in |file_lines_|.
+  mutable std::optional<SubstringMatcher> inclusion_matcher_;
+
+  // Lazily-constructed matcher for strings that contain any of the exclusion
+  // lines in |file_lines_|.
+  mutable std::optional<SubstringMatcher> exclusion_matcher_;
 
-  // Lazily-constructed regex that matches strings that contain any of the
-  // exclusion lines in |file_lines_|.
-  mutable std::optional<llvm::Regex> exclusion_substring_regex_;
+  // Results of ContainsSubstringOfFileAt(). The rewriters share a FilterFile
+  // across translation units, which FileIDCache allows for.
+  mutable FileIDCache<bool> file_results_;
 };
 
 // Represents an exclusion rules for raw pointers/references errors.
@@ -96,27 +110,38 @@ AST_POLYMORPHIC_MATCHER(isNotSpelledInSource,
          source_manager.isWrittenInScratchSpace(loc);
 }
 
-AST_POLYMORPHIC_MATCHER(isInThirdPartyLocation,
-                        AST_POLYMORPHIC_SUPPORTED_TYPES(clang::Decl,
-                                                        clang::Stmt,
-                                                        clang::TypeLoc)) {
+// Implements isInThirdPartyLocation() below, with |cache| owned by the matcher,
+// and so by the MatchFinder it is added to.
+AST_POLYMORPHIC_MATCHER_P(isInThirdPartyLocationWithCache,
+                          AST_POLYMORPHIC_SUPPORTED_TYPES(clang::Decl,
+                                                          clang::Stmt,
+                                                          clang::TypeLoc),
+                          std::shared_ptr<FileIDCache<bool>>,
+                          cache) {
   clang::SourceManager& sm = Finder->getASTContext().getSourceManager();
-  std::string filename = GetFilename(sm, getRepresentativeLocation(Node),
-                                     FilenameLocationType::kSpellingLoc);
+  clang::SourceLocation loc = getRepresentativeLocation(Node);
+  return cache->Get(sm, sm.getFileID(sm.getSpellingLoc(loc)), [&] {
+    std::string filename =
+        GetFilename(sm, loc, FilenameLocationType::kSpellingLoc);
 
-  // Blink is part of the Chromium git repo, even though it contains
-  // "third_party" in its path.
-  if (filename.find("/third_party/blink/") != std::string::npos) {
-    return false;
-  }
-  // Dawn repo has started using raw_ptr.
-  if (filename.find("/third_party/dawn/") != std::string::npos) {
-    return false;
-  }
-  // Otherwise, just check if the paths contains the "third_party" substring.
-  // We don't want to rewrite content of such paths even if they are in the main
-  // Chromium git repository.
-  return filename.find("/third_party/") != std::string::npos;
+    // Blink is part of the Chromium git repo, even though it contains
+    // "third_party" in its path.
+    if (filename.find("/third_party/blink/") != std::string::npos) {
+      return false;
+    }
+    // Dawn repo has started using raw_ptr.
+    if (filename.find("/third_party/dawn/") != std::string::npos) {
+      return false;
+    }
+    // Otherwise, just check if the paths contains the "third_party" substring.
+    // We don't want to rewrite content of such paths even if they are in the
+    // main Chromium git repository.
+    return filename.find("/third_party/") != std::string::npos;
+  });
+}
+
+inline auto isInThirdPartyLocation() {
+  return isInThirdPartyLocationWithCache(std::make_shared<FileIDCache<bool>>());
 }
 
 AST_MATCHER(clang::Stmt, isInStdBitCastHeader) {
@@ -135,16 +160,26 @@ AST_MATCHER(clang::Stmt, isInRawPtrCastHeader) {
              "raw_ptr_cast.h") != std::string::npos;
 }
 
-AST_POLYMORPHIC_MATCHER(isInGeneratedLocation,
-                        AST_POLYMORPHIC_SUPPORTED_TYPES(clang::Decl,
-                                                        clang::Stmt,
-                                                        clang::TypeLoc)) {
+// Implements isInGeneratedLocation() below, like
+// isInThirdPartyLocationWithCache.
+AST_POLYMORPHIC_MATCHER_P(isInGeneratedLocationWithCache,
+                          AST_POLYMORPHIC_SUPPORTED_TYPES(clang::Decl,
+                                                          clang::Stmt,
+                                                          clang::TypeLoc),
+                          std::shared_ptr<FileIDCache<bool>>,
+                          cache) {
   clang::SourceManager& sm = Finder->getASTContext().getSourceManager();
-  std::string filename = GetFilename(sm, getRepresentativeLocation(Node),
-                                     FilenameLocationType::kSpellingLoc);
+  clang::SourceLocation loc = getRepresentativeLocation(Node);
+  return cache->Get(sm, sm.getFileID(sm.getSpellingLoc(loc)), [&] {
+    std::string filename =
+        GetFilename(sm, loc, FilenameLocationType::kSpellingLoc);
+    return filename.find("/gen/") != std::string::npos ||
+           filename.rfind("gen/", 0) == 0;
+  });
+}
 
-  return filename.find("/gen/") != std::string::npos ||
-         filename.rfind("gen/", 0) == 0;
+inline auto isInGeneratedLocation() {
+  return isInGeneratedLocationWithCache(std::make_shared<FileIDCache<bool>>());
 }
 
 AST_MATCHER_P(clang::NamedDecl,
@@ -165,9 +200,7 @@ AST_POLYMORPHIC_MATCHER_P(isInLocationListedInFilterFile,
     return false;
   }
   clang::SourceManager& sm = Finder->getASTContext().getSourceManager();
-  std::string file_path =
-      GetFilename(sm, loc, FilenameLocationType::kSpellingLoc);
-  return Filter->ContainsSubstringOf(file_path);
+  return Filter->ContainsSubstringOfFileAt(sm, loc);
 }
 
 AST_MATCHER(clang::Decl, isInExternCContext) {
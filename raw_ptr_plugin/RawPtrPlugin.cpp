@@ -5,6 +5,7 @@
 #include "RawPtrPlugin.h"
 
 #include "FindBadRawPtrPatterns.h"
+#include "SharedMatchFinder.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/Frontend/FrontendPluginRegistry.h"
 #include "llvm/Support/TimeProfiler.h"
@@ -49,22 +50,45 @@ class PluginConsumer : public ASTConsumer {
   PluginConsumer(CompilerInstance* instance, const Options& options)
       : options_(options), instance_(*instance) {}
 
+  void Initialize(clang::ASTContext& context) override {
+    // Match profiling reports on a MatchFinder of its own, so it is not
+    // shared.
+    if (IsEnabled() && !options_.enable_match_profiling) {
+      shared_match_finder_ =
+          chrome_plugin_host::SharedMatchFinder::Join(context);
+    }
+  }
+
   void HandleTranslationUnit(clang::ASTContext& context) override {
     llvm::TimeTraceScope TimeScope("HandleTranslationUnit for raw-ptr plugin");
-    if (options_.check_bad_raw_ptr_cast || options_.check_raw_ptr_fields ||
-        options_.check_raw_ref_fields ||
-        (options_.check_raw_ptr_to_stack_allocated &&
-         !options_.disable_check_raw_ptr_to_stack_allocated_error) ||
-        options_.check_span_fields) {
+    if (shared_match_finder_) {
+      patterns_finder_ =
+          std::make_unique<BadRawPtrPatternsFinder>(options_, instance_);
+      patterns_finder_->Register(shared_match_finder_->finder());
+      shared_match_finder_->Run();
+    } else if (IsEnabled()) {
       FindBadRawPtrPatterns(options_, context, instance_);
     }
   }
 
  private:
+  bool IsEnabled() const {
+    return options_.check_bad_raw_ptr_cast || options_.check_raw_ptr_fields ||
+           options_.check_raw_ref_fields ||
+           (options_.check_raw_ptr_to_stack_allocated &&
+            !options_.disable_check_raw_ptr_to_stack_allocated_error) ||
+           options_.check_span_fields;
+  }
+
   // Options.
   const Options options_;
 
   clang::CompilerInstance& instance_;
+
+  std::shared_ptr<chrome_plugin_host::SharedMatchFinder> shared_match_finder_;
+  // Owns the matchers added to `shared_match_finder_`, which may run after
+  // HandleTranslationUnit() returns.
+  std::unique_ptr<BadRawPtrPatternsFinder> patterns_finder_;
 };
 
 }  // namespace
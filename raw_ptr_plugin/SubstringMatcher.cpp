@@ -0,0 +1,126 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "SubstringMatcher.h"
+
+#include <algorithm>
+
+namespace raw_ptr_plugin {
+
+SubstringMatcher::SubstringMatcher() : states_(1) {}
+
+SubstringMatcher::SubstringMatcher(llvm::ArrayRef<llvm::StringRef> patterns)
+    : states_(1), num_patterns_(patterns.size()) {
+  // Build the trie.
+  for (uint32_t i = 0; i < num_patterns_; ++i) {
+    if (patterns[i].empty()) {
+      continue;
+    }
+    uint32_t state = 0;
+    for (unsigned char c : patterns[i].bytes()) {
+      auto& edges = states_[state].edges;
+      auto it = std::lower_bound(
+          edges.begin(), edges.end(), c,
+          [](const auto& edge, unsigned char c) { return edge.first < c; });
+      if (it != edges.end() && it->first == c) {
+        state = it->second;
+        continue;
+      }
+      uint32_t child = states_.size();
+      edges.insert(it, {c, child});
+      // May reallocate `states_`, so `edges` must not be used after this.
+      states_.emplace_back();
+      state = child;
+    }
+    states_[state].patterns.push_back(i);
+  }
+
+  // Compute the failure and output links in breadth-first order, so that the
+  // links of shorter strings are known before they are needed.
+  std::vector<uint32_t> queue;
+  queue.reserve(states_.size());
+  for (const auto& edge : states_[0].edges) {
+    queue.push_back(edge.second);
+  }
+  for (size_t head = 0; head < queue.size(); ++head) {
+    const uint32_t state = queue[head];
+    State& s = states_[state];
+    s.output = s.patterns.empty() ? states_[s.failure].output : state;
+    for (const auto& [c, child] : s.edges) {
+      uint32_t failure = s.failure;
+      while (failure != 0 && Child(failure, c) == kNone) {
+        failure = states_[failure].failure;
+      }
+      const uint32_t next = Child(failure, c);
+      states_[child].failure = next == kNone ? 0 : next;
+      queue.push_back(child);
+    }
+  }
+}
+
+uint32_t SubstringMatcher::Child(uint32_t state, unsigned char c) const {
+  const auto& edges = states_[state].edges;
+  auto it = std::lower_bound(
+      edges.begin(), edges.end(), c,
+      [](const auto& edge, unsigned char c) { return edge.first < c; });
+  return it != edges.end() && it->first == c ? it->second : kNone;
+}
+
+uint32_t SubstringMatcher::Next(uint32_t state, unsigned char c) const {
+  while (true) {
+    if (uint32_t child = Child(state, c); child != kNone) {
+      return child;
+    }
+    if (state == 0) {
+      return 0;
+    }
+    state = states_[state].failure;
+  }
+}
+
+bool SubstringMatcher::MatchesSubstringOf(llvm::StringRef text) const {
+  if (empty()) {
+    return false;
+  }
+  uint32_t state = 0;
+  for (unsigned char c : text.bytes()) {
+    state = Next(state, c);
+    if (states_[state].output != kNone) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool SubstringMatcher::MatchesPrefixOf(llvm::StringRef text) const {
+  uint32_t state = 0;
+  for (unsigned char c : text.bytes()) {
+    state = Child(state, c);
+    if (state == kNone) {
+      return false;
+    }
+    if (!states_[state].patterns.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void SubstringMatcher::FindSubstringsOf(llvm::StringRef text,
+                                        llvm::SmallBitVector& matches) const {
+  matches.clear();
+  matches.resize(num_patterns_);
+  uint32_t state = 0;
+  for (unsigned char c : text.bytes()) {
+    state = Next(state, c);
+    for (uint32_t out = states_[state].output; out != kNone;
+         out = states_[states_[out].failure].output) {
+      for (uint32_t pattern : states_[out].patterns) {
+        matches.set(pattern);
+      }
+    }
+  }
+}
+
+}  // namespace raw_ptr_plugin
@@ -5,9 +5,13 @@
 #include "Util.h"
 
 #include <algorithm>
+#include <iterator>
+#include <vector>
 
+#include "SubstringMatcher.h"
 #include "clang/AST/Decl.h"
 #include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/SmallBitVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/raw_ostream.h"
@@ -30,6 +34,27 @@ const char* kTreatAsThirdPartyDirs[] = {
     "/v8/",             //
 };
 
+// Indices of the patterns of GetClassificationMatcher(). The
+// kTreatAsThirdPartyDirs follow kThirdPartyDirPattern.
+enum ClassificationPattern : unsigned {
+  kGenDirPattern,
+  kBlinkDirPattern,
+  kThirdPartyDirPattern,
+};
+
+// Matches all the directories ClassifySourceLocation() looks for, so that a
+// path is scanned once rather than once per directory.
+const SubstringMatcher& GetClassificationMatcher() {
+  static const SubstringMatcher matcher([] {
+    std::vector<llvm::StringRef> patterns = {"/gen/", "/third_party/blink/",
+                                             "/third_party/"};
+    patterns.insert(patterns.end(), std::begin(kTreatAsThirdPartyDirs),
+                    std::end(kTreatAsThirdPartyDirs));
+    return SubstringMatcher(patterns);
+  }());
+  return matcher;
+}
+
 std::string GetNamespaceImpl(const clang::DeclContext* context,
                              const std::string& candidate) {
   switch (context->getDeclKind()) {
@@ -136,13 +161,17 @@ LocationClassification ClassifySourceLocation(
     filename.insert(0, 1, '/');
   }
 
-  if (filename.find("/gen/") != std::string::npos) {
+  llvm::SmallBitVector matches;
+  GetClassificationMatcher().FindSubstringsOf(filename, matches);
+
+  if (matches[kGenDirPattern]) {
     return LocationClassification::kGenerated;
   }
 
   // While blink is inside third_party, it's not all treated like third-party
   // code.
-  if (auto p = filename.find("/third_party/blink/"); p != std::string::npos) {
+  if (matches[kBlinkDirPattern]) {
+    auto p = filename.find("/third_party/blink/");
     // Browser-side code is treated like first party in order to have all
     // diagnostics applied. Over time we want the rest of blink code to
     // converge as well.
@@ -153,12 +182,9 @@ LocationClassification ClassifySourceLocation(
     }
   }
 
-  if (filename.find("/third_party/") != std::string::npos) {
-    return LocationClassification::kThirdParty;
-  }
-
-  for (const char* dir : kTreatAsThirdPartyDirs) {
-    if (filename.find(dir) != std::string::npos) {
+  // "/third_party/" or any of the kTreatAsThirdPartyDirs.
+  for (unsigned i = kThirdPartyDirPattern; i < matches.size(); ++i) {
+    if (matches[i]) {
       return LocationClassification::kThirdParty;
     }
   }
@@ -168,4 +194,17 @@ LocationClassification ClassifySourceLocation(
   return LocationClassification::kFirstParty;
 }
 
+LocationClassification LocationClassifier::Classify(
+    const clang::SourceManager& sm,
+    clang::SourceLocation loc) {
+  // The system header check is cheap and does not depend on the file name, so
+  // it is not cached. Everything else depends only on the name of the file
+  // that `loc` is expanded into.
+  if (sm.isInSystemHeader(loc)) {
+    return LocationClassification::kSystem;
+  }
+  return cache_.Get(sm, sm.getFileID(sm.getExpansionLoc(loc)),
+                    [&] { return ClassifySourceLocation(search_, sm, loc); });
+}
+
 }  // namespace raw_ptr_plugin
@@ -14,6 +14,7 @@
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Lex/HeaderSearchOptions.h"
+#include "llvm/ADT/DenseMap.h"
 
 namespace raw_ptr_plugin {
 
@@ -123,6 +124,66 @@ LocationClassification ClassifySourceLocation(
     const clang::SourceManager& sm,
     clang::SourceLocation loc);
 
+// Caches a value computed from the file |fid|, so that per-file checks run
+// once per file rather than once per query.
+//
+// FileIDs are only meaningful for one SourceManager, so the cache forgets
+// everything when it is queried with another one. A cache can therefore
+// outlive a SourceManager and be reused across translation units. Each entry
+// also remembers the name of its file and is recomputed if the name differs,
+// in case a new SourceManager is allocated where the previous one was. Files
+// with line directives, whose presumed name can change within the file, and
+// buffers without a file entry are never cached.
+template <typename T>
+class FileIDCache {
+ public:
+  template <typename Compute>
+  T Get(const clang::SourceManager& sm, clang::FileID fid, Compute compute) {
+    if (&sm != source_manager_) {
+      entries_.clear();
+      source_manager_ = &sm;
+    }
+    bool invalid = false;
+    const clang::SrcMgr::SLocEntry& entry = sm.getSLocEntry(fid, &invalid);
+    if (invalid || !entry.isFile() || entry.getFile().hasLineDirectives()) {
+      return compute();
+    }
+    clang::OptionalFileEntryRef file = sm.getFileEntryRefForID(fid);
+    if (!file) {
+      return compute();
+    }
+    auto [it, inserted] = entries_.try_emplace(fid);
+    if (inserted || it->second.file_name != file->getName()) {
+      it->second.file_name = file->getName().str();
+      it->second.value = compute();
+    }
+    return it->second.value;
+  }
+
+ private:
+  struct Entry {
+    std::string file_name;
+    T value{};
+  };
+  const clang::SourceManager* source_manager_ = nullptr;
+  llvm::DenseMap<clang::FileID, Entry> entries_;
+};
+
+// ClassifySourceLocation(), computed once per file. Meant to be owned by
+// something with the lifetime of a CompilerInstance.
+class LocationClassifier {
+ public:
+  explicit LocationClassifier(const clang::HeaderSearchOptions& search)
+      : search_(search) {}
+
+  LocationClassification Classify(const clang::SourceManager& sm,
+                                  clang::SourceLocation loc);
+
+ private:
+  const clang::HeaderSearchOptions& search_;
+  FileIDCache<LocationClassification> cache_;
+};
+
 }  // namespace raw_ptr_plugin
 
 #endif  // TOOLS_CLANG_RAW_PTR_PLUGIN_UTIL_H_
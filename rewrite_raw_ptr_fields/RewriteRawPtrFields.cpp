@@ -36,6 +36,9 @@
 #include <string>
 #include <vector>
 
+#include "BatchMode.h"
+#include "BinaryEdits.h"
+#include "PrefixHeaderPch.h"
 #include "RawPtrHelpers.h"
 #include "RawPtrManualPathsToIgnore.h"
 #include "SeparateRepositoryPaths.h"
@@ -61,6 +64,7 @@
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace clang::ast_matchers;
 
@@ -113,6 +117,8 @@ const char kOverrideExcludePathsParamName[] = "override-exclude-paths";
 //
 // See also:
 // - raw_ptr_plugin::FilterFile
+// - raw_ptr_plugin::BinaryEditsWriter (replaces the EDITS section when the
+//   --binary-edits cmdline parameter is used)
 // - OutputHelper
 class OutputSectionHelper {
  public:
@@ -169,6 +175,14 @@ class OutputSectionHelper {
       llvm::outs() << "\n";
     }
     llvm::outs() << "==== END " << output_delimiter_ << " ====\n";
+    Clear();
+  }
+
+  // In batch mode the same helper serves many translation units, each of
+  // which must only report its own output.
+  void Clear() {
+    output_line_to_tags_.clear();
+    output_line_to_locs_.clear();
   }
 
  private:
@@ -188,8 +202,12 @@ class OutputSectionHelper {
 // Output format is documented in //docs/clang_tool_refactoring.md
 class OutputHelper : public clang::tooling::SourceFileCallbacks {
  public:
-  OutputHelper()
-      : edits_helper_("EDITS"), field_decl_filter_helper_("FIELD FILTERS") {}
+  // If |binary_edits| is true, edits are emitted in the format of
+  // raw_ptr_plugin::BinaryEditsWriter instead of as text directives.
+  explicit OutputHelper(bool binary_edits)
+      : binary_edits_(binary_edits),
+        edits_helper_("EDITS"),
+        field_decl_filter_helper_("FIELD FILTERS") {}
   ~OutputHelper() = default;
 
   OutputHelper(const OutputHelper&) = delete;
@@ -207,6 +225,15 @@ class OutputHelper : public clang::tooling::SourceFileCallbacks {
     if (file_path.empty())
       return;
 
+    if (binary_edits_) {
+      binary_edits_helper_.AddReplacement(file_path, replacement.getOffset(),
+                                          replacement.getLength(),
+                                          replacement_text);
+      if (include_path)
+        binary_edits_helper_.AddInclude(file_path, include_path);
+      return;
+    }
+
     std::replace(replacement_text.begin(), replacement_text.end(), '\n', '\0');
     std::string replacement_directive = llvm::formatv(
         "r:::{0}:::{1}:::{2}:::{3}", file_path, replacement.getOffset(),
@@ -257,11 +284,17 @@ class OutputHelper : public clang::tooling::SourceFileCallbacks {
 
   // clang::tooling::SourceFileCallbacks override:
   void handleEndSource() override {
-    if (ShouldSuppressOutput())
-      return;
+    if (!ShouldSuppressOutput()) {
+      edits_helper_.Emit();
+      binary_edits_helper_.Emit(llvm::outs());
+      field_decl_filter_helper_.Emit();
+    }
 
-    edits_helper_.Emit();
-    field_decl_filter_helper_.Emit();
+    // Emitting forgets the output, but suppressed output must be forgotten
+    // too, or in batch mode it would show up in the next translation unit's.
+    edits_helper_.Clear();
+    binary_edits_helper_.Clear();
+    field_decl_filter_helper_.Clear();
   }
 
   bool ShouldSuppressOutput() {
@@ -294,7 +327,9 @@ class OutputHelper : public clang::tooling::SourceFileCallbacks {
     return true;
   }
 
+  const bool binary_edits_;
   OutputSectionHelper edits_helper_;
+  raw_ptr_plugin::BinaryEditsWriter binary_edits_helper_;
   OutputSectionHelper field_decl_filter_helper_;
   clang::Language current_language_ = clang::Language::Unknown;
 };
@@ -1485,18 +1520,48 @@ int main(int argc, const char* argv[]) {
       llvm::cl::desc("Exclude pointers/references to `STACK_ALLOCATED` objects "
                      "from the rewrite"));
 
+  llvm::cl::opt<bool> batch(
+      "batch", llvm::cl::init(false),
+      llvm::cl::desc("Read compile commands from stdin and process them in "
+                     "this process (used by run_tool.py --batch)"));
+  llvm::cl::opt<bool> binary_edits(
+      "binary-edits", llvm::cl::init(false),
+      llvm::cl::desc("Emit edits in the compact binary format understood by "
+                     "extract_edits.py and apply_edits.py"));
+  llvm::cl::opt<std::string> inputs_file(
+      "inputs-file", llvm::cl::value_desc("filepath"),
+      llvm::cl::desc("file to write the list of files read by the translation "
+                     "unit to (used by run_tool.py --cache-dir)"));
+  raw_ptr_plugin::PrefixHeaderPch::Options prefix_header_options(category);
+
   llvm::Expected<clang::tooling::CommonOptionsParser> options =
-      clang::tooling::CommonOptionsParser::create(argc, argv, category);
+      clang::tooling::CommonOptionsParser::create(
+          argc, argv, category,
+          // Batch mode reads the source paths from stdin instead.
+          llvm::cl::ZeroOrMore);
   assert(static_cast<bool>(options));  // Should not return an error.
+  if (!batch && options->getSourcePathList().empty()) {
+    llvm::errs() << "No source files given; pass at least one source path, "
+                    "or use --batch.\n";
+    return 1;
+  }
   clang::tooling::ClangTool tool(options->getCompilations(),
                                  options->getSourcePathList());
+  std::unique_ptr<raw_ptr_plugin::PrefixHeaderPch> prefix_header_pch =
+      raw_ptr_plugin::PrefixHeaderPch::Create(prefix_header_options);
+  if (prefix_header_pch) {
+    tool.appendArgumentsAdjuster(prefix_header_pch->GetArgumentsAdjuster());
+  }
+  if (!inputs_file.empty()) {
+    raw_ptr_plugin::ReportToolInputs(tool, inputs_file);
+  }
 
   // Rewrite both T& and T* into const raw_ref<T> and raw_ptr<T> respectively if
   // no argument is provided.
   bool rewrite_raw_ref_and_ptr =
       !enable_raw_ref_rewrite && !enable_raw_ptr_rewrite;
   MatchFinder match_finder;
-  OutputHelper output_helper;
+  OutputHelper output_helper(binary_edits);
   raw_ptr_plugin::FilterFile fields_to_exclude(
       exclude_fields_param, exclude_fields_param.ArgStr.str());
 
@@ -1540,6 +1605,16 @@ int main(int argc, const char* argv[]) {
   // Prepare and run the tool.
   std::unique_ptr<clang::tooling::FrontendActionFactory> factory =
       clang::tooling::newFrontendActionFactory(&match_finder, &output_helper);
+  if (batch) {
+    return raw_ptr_plugin::RunToolInBatchMode(
+        factory.get(),
+        [&] {
+          // The predicate caches its answers by decl pointer, which do not
+          // outlive the translation unit.
+          stack_allocated_checker = raw_ptr_plugin::StackAllocatedPredicate();
+        },
+        prefix_header_pch.get());
+  }
   int result = tool.run(factory.get());
   if (result != 0)
     return result;
@@ -4,10 +4,14 @@
 # found in the LICENSE file.
 
 import glob
+import json
 import os.path
 import shutil
 import subprocess
 import sys
+import tempfile
+
+TOOL_PATH = "third_party/llvm-build/Release+Asserts/bin/rewrite_raw_ptr_fields"
 
 
 def RunRewritingTests():
@@ -37,20 +41,58 @@ def RunGeneratingTests():
     RunGeneratingTest(test_path)
 
 
+def RunBatchTest():
+  """Checks that the output held back for a C translation unit in --batch mode
+  does not leak into the output of the next translation unit."""
+  with tempfile.TemporaryDirectory() as temp_dir:
+    c_path = os.path.join(temp_dir, "suppressed.c")
+    cc_path = os.path.join(temp_dir, "rewritten.cc")
+    with open(c_path, "w") as f:
+      f.write("struct S { int* c_field; };\n")
+    with open(cc_path, "w") as f:
+      f.write("struct S { int* cc_field; };\n")
+    requests = [
+        {
+            "file": c_path,
+            "arguments": ["clang", "-c"]
+        },
+        {
+            "file": cc_path,
+            "arguments": ["clang++", "-std=c++20", "-c"]
+        },
+    ]
+    result = subprocess.run(
+        [os.path.abspath(TOOL_PATH), "--batch", "--"],
+        input="".join(json.dumps(r) + "\n" for r in requests),
+        stdout=subprocess.PIPE,
+        universal_newlines=True,
+        cwd=temp_dir)
+
+  # Must match kBatchEntryDoneMarker in raw_ptr_plugin/BatchMode.h.
+  entries = result.stdout.split("==== END OF BATCH ENTRY")
+  if (len(entries) != 3 or "suppressed.c" in result.stdout
+      or "rewritten.cc" not in entries[1]):
+    sys.stderr.write("FAILED: batch test, output was:\n%s\n" % result.stdout)
+    return False
+  print("PASSED: batch test")
+  return True
+
+
 def main():
   if not os.path.exists("ATL_OWNERS"):
     sys.stderr.write(
         "Please run run_all_tests.py from the root dir of Chromium")
     return -1
 
-  if not os.path.exists(
-      "third_party/llvm-build/Release+Asserts/bin/rewrite_raw_ptr_fields"):
+  if not os.path.exists(TOOL_PATH):
     sys.stderr.write("Please build rewrite_raw_ptr_fields first")
     return -1
 
   RunRewritingTests()
   RunGeneratingTests()
+  if not RunBatchTest():
+    return 1
 
 
 if __name__ == "__main__":
-  main()
+  sys.exit(main())
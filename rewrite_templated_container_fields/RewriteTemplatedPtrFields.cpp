@@ -39,6 +39,7 @@
 #include <string_view>
 #include <vector>
 
+#include "PrefixHeaderPch.h"
 #include "RawPtrHelpers.h"
 #include "RawPtrManualPathsToIgnore.h"
 #include "SeparateRepositoryPaths.h"
@@ -1437,11 +1438,17 @@ int main(int argc, const char* argv[]) {
       kOverrideExcludePathsParamName, llvm::cl::value_desc("filepath"),
       llvm::cl::desc(
           "override file listing paths to be blocked (not rewritten)"));
+  raw_ptr_plugin::PrefixHeaderPch::Options prefix_header_options(category);
   llvm::Expected<clang::tooling::CommonOptionsParser> options =
       clang::tooling::CommonOptionsParser::create(argc, argv, category);
   assert(static_cast<bool>(options));  // Should not return an error.
   clang::tooling::ClangTool tool(options->getCompilations(),
                                  options->getSourcePathList());
+  std::unique_ptr<raw_ptr_plugin::PrefixHeaderPch> prefix_header_pch =
+      raw_ptr_plugin::PrefixHeaderPch::Create(prefix_header_options);
+  if (prefix_header_pch) {
+    tool.appendArgumentsAdjuster(prefix_header_pch->GetArgumentsAdjuster());
+  }
 
   std::unique_ptr<raw_ptr_plugin::FilterFile> paths_to_exclude;
   if (override_exclude_paths_param.getValue().empty()) {
@@ -41,14 +41,30 @@ extract_edits.py would then emit the following output:
     ...
 Where the edit is either a replacemnt or an include directive.
 
+Instead of reading the output of all the tool invocations at once, the graph
+can be built in parts, e.g. one per platform or per run_tool.py shard:
+    run_tool.py ... | extract_edits.py --write-partial-graph=linux.graph
+    run_tool.py ... | extract_edits.py --write-partial-graph=win.graph
+    extract_edits.py linux.graph win.graph | apply_edits.py ...
+A partial graph file holds the deduplicated nodes and edges of its input.
+Merging partial graphs in order gives the same edits as running on the
+concatenated tool outputs. Partial graphs can also be merged into a new
+partial graph.
+
 For more details about how the tool works, see the doc here:
 https://docs.google.com/document/d/1P8wLVS3xueI4p3EAPO4JJP6d1_zVp5SapQB0EW9iHQI/
 """
 
 from __future__ import print_function
 from collections import defaultdict
+import argparse
+import gzip
+import json
 import sys
 
+# Version of the partial graph file format.
+_PARTIAL_GRAPH_VERSION = 1
+
 
 class Node:
   is_field = "0"
@@ -66,6 +82,10 @@ class Node:
     self.has_auto_type = has_auto_type
     self.include_directive = include_directive
     self.neighbors = set()
+    # Whether |is_field| was last set from a field declaration. Otherwise it
+    # also depends on the input read before, which matters when merging
+    # partial graphs.
+    self.is_field_declared = False
 
   def __eq__(self, other):
     if isinstance(other, Node):
@@ -84,46 +104,63 @@ def GetNode(txt: str):
 
 def DFS(visited: set, graph: defaultdict, key: str, key_to_node: defaultdict,
         changes: set):
-  if key not in visited:
+  # Iterative, as the graph of a full build has long paths.
+  stack = [key]
+  while stack:
+    key = stack.pop()
+    if key in visited:
+      continue
     node = key_to_node[key]
     if node.has_auto_type == "0":
       changes.add(node.replacement)
       changes.add(node.include_directive)
     visited.add(key)
-    for neighbour in graph[key]:
-      DFS(visited, graph, neighbour.replacement, key_to_node, changes)
+    stack.extend(graph[key])
 
 
 # to propagate field exclusions to all neighbors
 def PropagateExclusions(visited: set, graph: defaultdict, key: str,
                         key_to_node: defaultdict):
-  if key not in visited:
-    n = key_to_node[key]
-    n.is_excluded = "1"
-    key_to_node[key] = n
-    visited.add(key)
-    for neighbour in graph[key]:
-      PropagateExclusions(visited, graph, neighbour.replacement, key_to_node)
-
-
-def main():
-  graph = defaultdict()
-  key_to_node = defaultdict()  # since we cannot use nodes as keys
-  # to map, use this to map node replacemnt to node.
-  inside_marker_lines = False
-  changes = set()
-  excluded_fields = set()
-  for line in sys.stdin:
-    line = line.rstrip("\n\r")
-    if line == '==== BEGIN EDITS ====':
-      inside_marker_lines = True
-      continue
-    if line == '==== END EDITS ====':
-      inside_marker_lines = False
-      continue
-    if inside_marker_lines:
-      changes.add(line)
+  stack = [key]
+  while stack:
+    key = stack.pop()
+    if key in visited:
       continue
+    key_to_node[key].is_excluded = "1"
+    visited.add(key)
+    stack.extend(graph[key])
+
+
+class PartialGraph:
+  """The graph built from the output of some of the tool invocations."""
+
+  def __init__(self):
+    # Maps a node replacement to its neighbors' replacements.
+    self.graph = defaultdict()
+    # since we cannot use nodes as keys to map, use this to map node replacemnt
+    # to node.
+    self.key_to_node = defaultdict()
+    self.changes = set()
+    self.excluded_fields = set()
+
+  def ReadToolOutput(self, stream):
+    inside_marker_lines = False
+    for line in stream:
+      line = line.rstrip("\n\r")
+      if line == '==== BEGIN EDITS ====':
+        inside_marker_lines = True
+        continue
+      if line == '==== END EDITS ====':
+        inside_marker_lines = False
+        continue
+      if inside_marker_lines:
+        self.changes.add(line)
+        continue
+      self.AddLine(line)
+
+  def AddLine(self, line):
+    graph = self.graph
+    key_to_node = self.key_to_node
 
     ar = line.split(";")
     # These are fieldDecls
@@ -133,12 +170,13 @@ def main():
       # add it to the set of excluded fields
       # this will be later propagated to all neighboring fields.
       if lhs.is_excluded == "1":
-        excluded_fields.add(lhs.replacement)
+        self.excluded_fields.add(lhs.replacement)
         lhs.is_excluded = "0"
+      lhs.is_field_declared = True
       key_to_node[lhs.replacement] = lhs
       if lhs.replacement not in graph:
         graph.setdefault(lhs.replacement, set())
-      continue
+      return
 
     lhs = GetNode(ar[0])
     rhs = GetNode(ar[1])
@@ -147,38 +185,148 @@ def main():
     # end up creating the same replacement. What is being done here is
     # that if any field has a typedefNameDecl type, make all matches
     # current and previous marked as is_field
-    if lhs.replacement in key_to_node.keys():
-      lhs.is_field = "1" if lhs.is_field == "1" or key_to_node[
-          lhs.replacement].is_field == "1" else "0"
-
-    if rhs.replacement in key_to_node.keys():
-      rhs.is_field = "1" if rhs.is_field == "1" or key_to_node[
-          rhs.replacement].is_field == "1" else "0"
+    for node in (lhs, rhs):
+      previous = key_to_node.get(node.replacement)
+      if previous is not None:
+        node.is_field = "1" if node.is_field == "1" or \
+            previous.is_field == "1" else "0"
+        node.is_field_declared = previous.is_field_declared
 
     key_to_node[lhs.replacement] = lhs
     key_to_node[rhs.replacement] = rhs
 
     if lhs.replacement not in graph:
       graph.setdefault(lhs.replacement, set())
-    graph[lhs.replacement].add(rhs)
+    graph[lhs.replacement].add(rhs.replacement)
 
     if rhs.replacement not in graph:
       graph.setdefault(rhs.replacement, set())
-    graph[rhs.replacement].add(lhs)
+    graph[rhs.replacement].add(lhs.replacement)
+
+  def Merge(self, other):
+    """Adds |other|, built from output that comes after this graph's."""
+    for key, node in other.key_to_node.items():
+      previous = self.key_to_node.get(key)
+      if previous is not None and not node.is_field_declared:
+        # Same as the edge case of AddLine().
+        node.is_field = "1" if node.is_field == "1" or \
+            previous.is_field == "1" else "0"
+        node.is_field_declared = previous.is_field_declared
+      self.key_to_node[key] = node
+    for key, neighbors in other.graph.items():
+      self.graph.setdefault(key, set()).update(neighbors)
+    self.changes.update(other.changes)
+    self.excluded_fields.update(other.excluded_fields)
+
+  def Write(self, path):
+    """Writes the graph to a partial graph file."""
+    # Nodes are referred to by their index, and include directives (shared by
+    # all nodes of a file) are stored once.
+    index = {key: i for i, key in enumerate(self.key_to_node)}
+    includes = {}
+    nodes = []
+    for key, node in self.key_to_node.items():
+      include_index = includes.setdefault(node.include_directive,
+                                          len(includes))
+      nodes.append([
+          key, node.is_field, node.is_excluded, node.has_auto_type,
+          include_index, node.is_field_declared
+      ])
+    # The graph is undirected, so each edge is stored once.
+    edges = []
+    for key, neighbors in self.graph.items():
+      i = index[key]
+      edges.extend([i, index[neighbor]] for neighbor in neighbors
+                   if index[neighbor] >= i)
+    edges.sort()
+    with gzip.open(path, 'wt', encoding='utf-8') as f:
+      json.dump(
+          {
+              'version': _PARTIAL_GRAPH_VERSION,
+              'includes': list(includes),
+              'nodes': nodes,
+              'edges': edges,
+              'excluded_fields':
+              sorted(index[key] for key in self.excluded_fields),
+              'changes': sorted(self.changes),
+          },
+          f,
+          separators=(',', ':'))
+
+  @staticmethod
+  def Read(path):
+    """Reads a file written by Write()."""
+    with gzip.open(path, 'rt', encoding='utf-8') as f:
+      data = json.load(f)
+    if data.get('version') != _PARTIAL_GRAPH_VERSION:
+      raise ValueError('%s: unsupported partial graph version %s' %
+                       (path, data.get('version')))
+    result = PartialGraph()
+    keys = []
+    for (key, is_field, is_excluded, has_auto_type, include_index,
+         is_field_declared) in data['nodes']:
+      node = Node(is_field, is_excluded, has_auto_type, key,
+                  data['includes'][include_index])
+      node.is_field_declared = is_field_declared
+      result.key_to_node[key] = node
+      result.graph[key] = set()
+      keys.append(key)
+    for i, j in data['edges']:
+      result.graph[keys[i]].add(keys[j])
+      result.graph[keys[j]].add(keys[i])
+    result.excluded_fields = {keys[i] for i in data['excluded_fields']}
+    result.changes = set(data['changes'])
+    return result
+
+  def ExtractEdits(self):
+    """Returns the sorted edits to apply."""
+    graph = self.graph
+    key_to_node = self.key_to_node
+    changes = set(self.changes)
+
+    # Propagate changes to all excluded fields
+    visited = set()
+    for key in self.excluded_fields:
+      key_to_node[key].is_excluded = "1"
+      PropagateExclusions(visited, graph, key, key_to_node)
+
+    visited = set()
+    for key in graph.keys():
+      node = key_to_node[key]
+      if node.is_field == "1" and node.is_excluded == "0" and \
+          key not in visited:
+        DFS(visited, graph, key, key_to_node, changes)
+    return sorted(changes)
 
-  # Propagate changes to all excluded fields
-  visited = set()
-  for key in excluded_fields:
-    key_to_node[key].is_excluded = "1"
-    PropagateExclusions(visited, graph, key, key_to_node)
 
-  visited = set()
-  for key in graph.keys():
-    node = key_to_node[key]
-    if node.is_field == "1" and node.is_excluded == "0" and key not in visited:
-      DFS(visited, graph, key, key_to_node, changes)
-  changes = sorted(changes)
-  for text in changes:
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument(
+      'partial_graphs',
+      nargs='*',
+      metavar='PARTIAL_GRAPH',
+      help='Partial graph files to merge, in order. If none is given, the '
+      'tool output is read from stdin.')
+  parser.add_argument(
+      '--write-partial-graph',
+      metavar='PATH',
+      help='Write the graph to a partial graph file instead of printing the '
+      'edits.')
+  args = parser.parse_args()
+
+  graph = PartialGraph()
+  if args.partial_graphs:
+    for path in args.partial_graphs:
+      graph.Merge(PartialGraph.Read(path))
+  else:
+    graph.ReadToolOutput(sys.stdin)
+
+  if args.write_partial_graph:
+    graph.Write(args.write_partial_graph)
+    return 0
+
+  for text in graph.ExtractEdits():
     print(text)
   return 0
 
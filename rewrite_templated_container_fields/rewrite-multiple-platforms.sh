@@ -166,15 +166,21 @@ main_rewrite() {
         TARGET_OS_OPTION="--target_os=win"
     fi
 
-    # Main rewrite.
+    # Main rewrite. Only the deduplicated graph of each platform is kept, and
+    # the graphs are merged when extracting the edits.
     echo "*** Running the main rewrite phase for $PLATFORM ***"
     time tools/clang/scripts/run_tool.py \
         $TARGET_OS_OPTION \
         --tool rewrite_templated_container_fields \
         --generate-compdb \
         -p $OUT_DIR \
-        $COMPILE_DIRS > ~/scratch/rewriter-$PLATFORM.main.out
-    cat ~/scratch/rewriter-$PLATFORM.main.out >> ~/scratch/rewriter.main.out
+        $COMPILE_DIRS | \
+        tools/clang/rewrite_templated_container_fields/extract_edits.py \
+            --write-partial-graph ~/scratch/rewriter-$PLATFORM.graph
+    if [ "${PIPESTATUS[0]}" -ne 0 ]; then
+        echo "run_tool.py failed for $PLATFORM"
+        exit 1
+    fi
 }
 
 for PLATFORM in ${PLATFORMS//,/ }
@@ -189,8 +195,12 @@ done
 
 # Apply edits generated by the main rewrite.
 echo "*** Applying edits ***"
-cat ~/scratch/rewriter.main.out | \
-    tools/clang/rewrite_templated_container_fields/extract_edits.py | \
+GRAPHS=""
+for PLATFORM in ${PLATFORMS//,/ }
+do
+    GRAPHS="$GRAPHS $HOME/scratch/rewriter-$PLATFORM.graph"
+done
+tools/clang/rewrite_templated_container_fields/extract_edits.py $GRAPHS | \
     tools/clang/scripts/apply_edits.py -p out/rewrite-win $EDIT_DIRS
 
 # Format sources, as many lines are likely over 80 chars now.
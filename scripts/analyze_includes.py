@@ -16,8 +16,14 @@ $ analyze_includes.py --target=chrome --revision=$(git rev-parse --short HEAD) \
 (If you have reclient access, add use_reclient=true to the gn args, but not on
 Windows due to crbug.com/1223741#c9)
 
-The script takes roughly half an hour on a fast machine for the chrome build
-target, which is considered fast enough for batch job purposes for now.
+The graph analysis is done by the include_analysis tool, which processes the
+root files in parallel. Build it with
+
+$ tools/clang/scripts/build.py --extra-tools include_analysis
+
+If the tool is not found (see --analyzer), the script falls back to doing the
+analysis in Python, which takes roughly half an hour on a fast machine for the
+chrome build target.
 
 If --json-out is not provided, the script exits after printing some statistics
 to stdout. This is significantly faster than generating the full JSON data. For
@@ -32,11 +38,19 @@ import json
 import os
 import pathlib
 import re
+import subprocess
 import sys
 import unittest
 from collections import defaultdict
 from datetime import datetime
 
+THIS_DIR = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_ANALYZER = os.path.join(THIS_DIR, '..', '..', '..', 'third_party',
+                                'llvm-build', 'Release+Asserts', 'bin',
+                                'include_analysis')
+if sys.platform == 'win32':
+  DEFAULT_ANALYZER += '.exe'
+
 
 def parse_build(build_log, root_filter=None):
   """Parse the build_log (generated as in the Usage note above) to capture the
@@ -306,7 +320,8 @@ def compute_doms(root, includes):
 
 
 class TestComputeDoms(unittest.TestCase):
-  def test_basic(self):
+  @staticmethod
+  def basic_graph():
     includes = {}
     includes[1] = [2]
     includes[2] = [1]
@@ -314,16 +329,10 @@ class TestComputeDoms(unittest.TestCase):
     includes[4] = [1]
     includes[5] = [4, 3]
     root = 5
+    return includes, root
 
-    doms = compute_doms(root, includes)
-
-    self.assertEqual(doms[1], set([5, 1]))
-    self.assertEqual(doms[2], set([5, 2]))
-    self.assertEqual(doms[3], set([5, 3]))
-    self.assertEqual(doms[4], set([5, 4]))
-    self.assertEqual(doms[5], set([5]))
-
-  def test_larger(self):
+  @staticmethod
+  def larger_graph():
     # Fig. 1 in the Lengauer-Tarjan paper.
     includes = {}
     includes['a'] = ['d']
@@ -340,6 +349,21 @@ class TestComputeDoms(unittest.TestCase):
     includes['l'] = ['h']
     includes['r'] = ['a', 'b', 'c']
     root = 'r'
+    return includes, root
+
+  def test_basic(self):
+    includes, root = self.basic_graph()
+
+    doms = compute_doms(root, includes)
+
+    self.assertEqual(doms[1], set([5, 1]))
+    self.assertEqual(doms[2], set([5, 2]))
+    self.assertEqual(doms[3], set([5, 3]))
+    self.assertEqual(doms[4], set([5, 4]))
+    self.assertEqual(doms[5], set([5]))
+
+  def test_larger(self):
+    includes, root = self.larger_graph()
 
     doms = compute_doms(root, includes)
 
@@ -359,34 +383,43 @@ class TestComputeDoms(unittest.TestCase):
     self.assertEqual(doms['r'], set(['r']))
 
 
-def trans_size(root, includes, sizes):
-  """Compute the transitive size of a file, i.e. the size of the file itself and
-  all its transitive includes."""
-  return sum([sizes[n] for n in post_order_nodes(root, includes)])
+class TestRunAnalyzer(unittest.TestCase):
+  def setUp(self):
+    if not os.path.isfile(DEFAULT_ANALYZER):
+      self.skipTest('%s not found' % DEFAULT_ANALYZER)
 
+  def check_graph(self, includes, roots):
+    names = sorted(includes, key=str)
+    sizes = {n: 10 * (i + 1) for i, n in enumerate(names)}
+    for sizes_only in [False, True]:
+      expected = analyze_in_python(roots, includes, sizes, sizes_only)
+      actual = run_analyzer(DEFAULT_ANALYZER, names, roots, includes, sizes,
+                            sizes_only)
+      self.assertEqual(actual, expected)
 
-def log(*args, **kwargs):
-  """Log output to stderr."""
-  print(*args, file=sys.stderr, **kwargs)
+  def test_basic(self):
+    includes, root = TestComputeDoms.basic_graph()
+    self.check_graph(includes, [root])
+    self.check_graph(includes, [1, 3, 5])
 
+  def test_larger(self):
+    includes, root = TestComputeDoms.larger_graph()
+    self.check_graph(includes, [root])
+    self.check_graph(includes, ['b', 'c', 'r'])
 
-def analyze(target, revision, build_log_file, json_file, root_filter):
-  log('Parsing build log...')
-  (roots, includes) = parse_build(build_log_file, root_filter)
 
-  log('Getting file sizes...')
-  sizes = {name: os.path.getsize(name) for name in includes}
+def trans_size(root, includes, sizes):
+  """Compute the transitive size of a file, i.e. the size of the file itself and
+  all its transitive includes."""
+  return sum([sizes[n] for n in post_order_nodes(root, includes)])
 
+
+def analyze_in_python(roots, includes, sizes, sizes_only):
+  """Same as run_analyzer, without the include_analysis tool."""
   log('Computing transitive sizes...')
   trans_sizes = {n: trans_size(n, includes, sizes) for n in includes}
-
-  build_size = sum([trans_sizes[n] for n in roots])
-
-  print('build_size', build_size)
-
-  if json_file is None:
-    log('--json-out not set; exiting.')
-    return 0
+  if sizes_only:
+    return trans_sizes, {}, {}
 
   log('Counting prevalence...')
   prevalence = {name: 0 for name in includes}
@@ -394,13 +427,6 @@ def analyze(target, revision, build_log_file, json_file, root_filter):
     for n in post_order_nodes(r, includes):
       prevalence[n] += 1
 
-  # Map from file to files that include it.
-  log('Building reverse include map...')
-  included_by = {k: set() for k in includes}
-  for k in includes:
-    for i in includes[k]:
-      included_by[i].add(k)
-
   log('Computing added sizes...')
 
   # Split each src -> dst edge in includes into src -> (src,dst) -> dst, so that
@@ -423,6 +449,56 @@ def analyze(target, revision, build_log_file, json_file, root_filter):
       for dom in doms[node]:
         added_sizes[dom] += sizes[node]
 
+  return trans_sizes, prevalence, added_sizes
+
+
+def run_analyzer(analyzer, names, roots, includes, sizes, sizes_only):
+  """Compute the transitive sizes, and unless sizes_only is set, the prevalence
+  and added sizes with the include_analysis tool. The files are numbered by
+  their index in names. Returns a (trans_sizes, prevalence, added_sizes)
+  triple of dicts like analyze_in_python(), the latter two empty if
+  sizes_only is set."""
+  name2nr = {n: i for i, n in enumerate(names)}
+  sorted_includes = [sorted(includes[n]) for n in names]
+  graph = ['%d %d' % (len(names), len(roots))]
+  for n, dsts in zip(names, sorted_includes):
+    graph.append(' '.join(
+        map(str, [sizes[n], len(dsts)] + [name2nr[d] for d in dsts])))
+  graph.append(' '.join(str(name2nr[r]) for r in roots))
+  cmd = [analyzer]
+  if sizes_only:
+    cmd.append('--sizes-only')
+  output = subprocess.run(cmd,
+                          input='\n'.join(graph) + '\n',
+                          stdout=subprocess.PIPE,
+                          universal_newlines=True,
+                          check=True).stdout
+  result = json.loads(output)
+
+  trans_sizes = dict(zip(names, result['tsizes']))
+  if sizes_only:
+    return trans_sizes, {}, {}
+  prevalence = dict(zip(names, result['prevalence']))
+  added_sizes = dict(zip(names, result['asizes']))
+  for s, dsts, esizes in zip(names, sorted_includes, result['esizes']):
+    for d, size in zip(dsts, esizes):
+      added_sizes[(s, d)] = size
+  return trans_sizes, prevalence, added_sizes
+
+
+def log(*args, **kwargs):
+  """Log output to stderr."""
+  print(*args, file=sys.stderr, **kwargs)
+
+
+def analyze(target, revision, build_log_file, json_file, root_filter,
+            analyzer=None):
+  log('Parsing build log...')
+  (roots, includes) = parse_build(build_log_file, root_filter)
+
+  log('Getting file sizes...')
+  sizes = {name: os.path.getsize(name) for name in includes}
+
   # Assign a number to each filename for tighter JSON representation.
   names = []
   name2nr = {}
@@ -433,6 +509,30 @@ def analyze(target, revision, build_log_file, json_file, root_filter):
   def nr(name):
     return name2nr[name]
 
+  if analyzer:
+    log('Running %s...' % analyzer)
+    (trans_sizes, prevalence,
+     added_sizes) = run_analyzer(analyzer, names, sorted(roots), includes,
+                                 sizes, json_file is None)
+  else:
+    (trans_sizes, prevalence,
+     added_sizes) = analyze_in_python(roots, includes, sizes, json_file is None)
+
+  build_size = sum([trans_sizes[n] for n in roots])
+
+  print('build_size', build_size)
+
+  if json_file is None:
+    log('--json-out not set; exiting.')
+    return 0
+
+  # Map from file to files that include it.
+  log('Building reverse include map...')
+  included_by = {k: set() for k in includes}
+  for k in includes:
+    for i in includes[k]:
+      included_by[i].add(k)
+
   log('Writing output...')
 
   # Provide a JS object for convenient inclusion in the HTML file.
@@ -478,6 +578,14 @@ def main():
       help='Write full analysis data to a JSON file (- for stdout).')
   parser.add_argument('--root-filter',
                       help='Regex to filter which root files are analyzed.')
+  parser.add_argument('--analyzer',
+                      default=DEFAULT_ANALYZER,
+                      help='Path to the include_analysis tool (default: %s).' %
+                      DEFAULT_ANALYZER)
+  parser.add_argument('--no-analyzer',
+                      action='store_true',
+                      help='Do the analysis in Python instead of with the '
+                      'include_analysis tool.')
   args = parser.parse_args()
 
   if args.json_out and not (args.target and args.revision):
@@ -490,8 +598,18 @@ def main():
     print('error: --root-filter is not a valid regex')
     return 1
 
+  analyzer = None
+  if not args.no_analyzer:
+    if os.path.isfile(args.analyzer):
+      analyzer = args.analyzer
+    elif args.analyzer != DEFAULT_ANALYZER:
+      print('error: --analyzer %s does not exist' % args.analyzer)
+      return 1
+    else:
+      log('%s not found; analyzing in Python.' % DEFAULT_ANALYZER)
+
   analyze(args.target, args.revision, args.build_log, args.json_out,
-          root_filter)
+          root_filter, analyzer)
 
 
 if __name__ == '__main__':
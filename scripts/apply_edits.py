@@ -14,11 +14,16 @@ For example - to apply edits only to WTF sources:
 
 In addition to filters specified on the command line, the tool also skips edits
 that apply to files that are not covered by git.
+
+Edits are read either as text directives, one per line, or as the binary stream
+written by extract_edits.py when the tool emitted binary edits (see
+pylib/clang/binary_edits.py).
 """
 
 import argparse
 import collections
 import functools
+import itertools
 import multiprocessing
 import os
 import os.path
@@ -30,6 +35,7 @@ script_dir = os.path.dirname(os.path.realpath(__file__))
 tool_dir = os.path.abspath(os.path.join(script_dir, '../pylib'))
 sys.path.insert(0, tool_dir)
 
+from clang import binary_edits
 from clang import compile_db
 
 Edit = collections.namedtuple('Edit',
@@ -86,8 +92,20 @@ def _ParseEditsFromStdin(build_directory):
     return resolved_path
 
   edits = collections.defaultdict(list)
-  for line in sys.stdin:
-    line = line.rstrip("\n\r")
+  stdin = sys.stdin.buffer
+  prefix = stdin.read(len(binary_edits.MAGIC))
+  if prefix == binary_edits.MAGIC:
+    for edit_type, path, offset, length, replacement in (
+        binary_edits.DecodePayload(stdin.read())):
+      path = _ResolvePath(path)
+      if not path: continue
+      edits[path].append(Edit(edit_type, offset, length, replacement))
+    return edits
+
+  for line in itertools.chain([prefix + stdin.readline()], stdin):
+    line = line.decode('utf-8').rstrip("\n\r")
+    if not line:
+      continue
     try:
       edit_type, path, offset, length, replacement = line.split(':::', 4)
       replacement = replacement.replace('\0', '\n')
@@ -260,7 +278,9 @@ def _InsertIncludeHeader(filepath, header_line_to_add, contents, is_system):
       contents[insertion_point:]
 
 
-def _ApplyReplacement(filepath, contents, edit, last_edit):
+def _CheckReplacement(filepath, edit, last_edit):
+  """Raises ValueError if |edit| conflicts with |last_edit|, the replacement
+  applied just before it (which has a greater offset)."""
   assert (edit.edit_type == 'r')
   assert ((last_edit is None) or (last_edit.edit_type == 'r'))
 
@@ -282,6 +302,10 @@ def _ApplyReplacement(filepath, contents, edit, last_edit):
            last_edit.offset, last_edit.length,
            last_edit.replacement.decode("utf-8")))
 
+
+def _ApplyReplacement(filepath, contents, edit, last_edit):
+  _CheckReplacement(filepath, edit, last_edit)
+
   start = edit.offset
   end = edit.offset + edit.length
   original_contents = contents
@@ -316,6 +340,105 @@ def _ApplySingleEdit(filepath, contents, edit, last_edit):
     return contents
 
 
+class _ReverseSplicer(object):
+  """Applies replacements to file contents in order of decreasing offset, in
+  time linear in the size of the contents (rather than copying the whole
+  contents for every edit).
+
+  The current contents are an untouched prefix of the original contents,
+  followed by a list of chunks holding everything after it.
+  """
+
+  def __init__(self, contents):
+    self.__original = contents
+    self.__prefix_end = len(contents)
+    # Chunks after the prefix, last chunk first.
+    self.__tail = []
+
+  def Get(self):
+    """Returns the current contents."""
+    return (self.__original[:self.__prefix_end] +
+            b''.join(reversed(self.__tail)))
+
+  def Reset(self, contents):
+    """Replaces the current contents with |contents|."""
+    self.__original = contents
+    self.__prefix_end = len(contents)
+    self.__tail = []
+
+  def Prefix(self):
+    """Returns the original contents and the length of the untouched prefix."""
+    return self.__original, self.__prefix_end
+
+  def PeekTail(self, size):
+    """Returns up to |size| bytes of the contents after the prefix."""
+    chunks = []
+    for chunk in reversed(self.__tail):
+      if size <= 0:
+        break
+      chunks.append(chunk[:size])
+      size -= len(chunk)
+    return b''.join(chunks)
+
+  def DropFromTail(self, size):
+    """Deletes |size| bytes right after the prefix."""
+    while size > 0 and self.__tail:
+      chunk = self.__tail.pop()
+      if len(chunk) > size:
+        self.__tail.append(chunk[size:])
+      size -= len(chunk)
+
+  def Splice(self, start, end, replacement):
+    """Replaces contents[start:end] with |replacement|. |end| must be within
+    the untouched prefix."""
+    assert (0 <= start <= end <= self.__prefix_end)
+    self.__tail.append(self.__original[end:self.__prefix_end])
+    self.__tail.append(replacement)
+    self.__prefix_end = start
+
+
+def _ApplyReplacementToSplicer(filepath, splicer, edit, last_edit):
+  """Same as _ApplyReplacement, but applies |edit| to a _ReverseSplicer."""
+  start = edit.offset
+  end = edit.offset + edit.length
+  original, prefix_end = splicer.Prefix()
+  if start < 0 or end > prefix_end:
+    # Edits are applied in order of decreasing offset, so this only happens
+    # when a deletion was extended past |start|, or for offsets past the end
+    # of the file. Fall back to copying the contents.
+    splicer.Reset(_ApplyReplacement(filepath, splicer.Get(), edit, last_edit))
+    return
+
+  _CheckReplacement(filepath, edit, last_edit)
+  splicer.Splice(start, end, edit.replacement)
+  if edit.replacement:
+    return
+
+  # Run _FindDeletionExtension over a window around the deletion, large enough
+  # to cover the whitespace it skips plus the context it prints.
+  left = start
+  while left > 0 and original[left - 1] in _WHITESPACE_BYTES:
+    left -= 1
+  window_start = max(0, left - 1 - 5)
+  before = original[window_start:start]
+
+  peek_size = 64
+  while True:
+    after = splicer.PeekTail(peek_size)
+    whitespace = len(after) - len(after.lstrip(bytes(_WHITESPACE_BYTES)))
+    if whitespace + 1 + 5 <= len(after) or len(after) < peek_size:
+      break
+    peek_size *= 2
+
+  deleted = original[start:end]
+  left_trim, right_trim = _FindDeletionExtension(before + deleted + after,
+                                                 before + after, len(before),
+                                                 edit.length)
+  splicer.DropFromTail(right_trim)
+  if left_trim:
+    splicer.Splice(start - left_trim, start, b'')
+
+
 def _ApplyEditsToSingleFileContents(filepath, contents, edits):
   # Sort the edits and iterate through them in reverse order. Sorting allows
   # duplicate edits to be quickly skipped, while reversing means that
@@ -329,18 +452,23 @@ def _ApplyEditsToSingleFileContents(filepath, contents, edits):
   edit_count = 0
   error_count = 0
   last_edit = None
+  splicer = _ReverseSplicer(contents)
   for edit in edits:
     if edit == last_edit:
       continue
     try:
-      contents = _ApplySingleEdit(filepath, contents, edit, last_edit)
+      if edit.edit_type == 'r':
+        _ApplyReplacementToSplicer(filepath, splicer, edit, last_edit)
+      else:
+        splicer.Reset(
+            _ApplySingleEdit(filepath, splicer.Get(), edit, last_edit))
       last_edit = edit
       edit_count += 1
     except ValueError as err:
       sys.stderr.write(str(err) + '\n')
       error_count += 1
 
-  return (contents, edit_count, error_count)
+  return (splicer.Get(), edit_count, error_count)
 
 
 def _ApplyEditsToSingleFile(filepath, edits):
@@ -354,23 +482,39 @@ def _ApplyEditsToSingleFile(filepath, edits):
   return (edit_count, error_count)
 
 
+def _ApplyEditsToSingleFileItem(item):
+  """Same as _ApplyEditsToSingleFile, taking a (filepath, edits) tuple so it can
+  be used with multiprocessing.Pool.imap_unordered."""
+  return _ApplyEditsToSingleFile(*item)
+
+
 def _ApplyEdits(edits):
   """Apply the generated edits.
 
+  Files are edited in parallel, one file per task.
+
   Args:
     edits: A dict mapping filenames to Edit instances that apply to that file.
   """
   edit_count = 0
   error_count = 0
   done_files = 0
-  for k, v in edits.items():
-    tmp_edit_count, tmp_error_count = _ApplyEditsToSingleFile(k, v)
+  if len(edits) > 1:
+    pool = multiprocessing.Pool()
+    results = pool.imap_unordered(_ApplyEditsToSingleFileItem, edits.items())
+  else:
+    pool = None
+    results = map(_ApplyEditsToSingleFileItem, edits.items())
+  for tmp_edit_count, tmp_error_count in results:
     edit_count += tmp_edit_count
     error_count += tmp_error_count
     done_files += 1
     percentage = (float(done_files) / len(edits)) * 100
     sys.stdout.write('Applied %d edits (%d errors) to %d files [%.2f%%]\r' %
                      (edit_count, error_count, done_files, percentage))
+  if pool:
+    pool.close()
+    pool.join()
 
   sys.stdout.write('\n')
   return -error_count
@@ -398,6 +542,23 @@ def _ExtendDeletionIfElementIsInList(original_contents, contents, offset,
     offset: The offset in the bytearray where the deleted range used to be.
     length: The length in the bytearray where the deleted range used to be.
   """
+  left_trim_count, right_trim_count = _FindDeletionExtension(
+      original_contents, contents, offset, length)
+  return contents[:offset - left_trim_count] + \
+      contents[offset + right_trim_count:]
+
+
+def _FindDeletionExtension(original_contents, contents, offset, length):
+  """Computes how _ExtendDeletionIfElementIsInList extends a deletion.
+
+  Takes the same arguments as _ExtendDeletionIfElementIsInList. Only the
+  whitespace around |offset|, the characters right past it and a few bytes of
+  context need to be present in |contents| and |original_contents|.
+
+  Returns:
+    A (left, right) tuple with the number of extra bytes to delete before and
+    after |offset| in |contents|. At most one of them is non-zero.
+  """
   char_before = char_after = None
   left_trim_count = 0
   for byte in reversed(contents[:offset]):
@@ -430,11 +591,11 @@ def _ExtendDeletionIfElementIsInList(original_contents, contents, offset,
   if char_before:
     if char_after:
       notify(0, right_trim_count)
-      return contents[:offset] + contents[offset + right_trim_count:]
+      return (0, right_trim_count)
     elif char_before in (',', ':'):
       notify(left_trim_count, 0)
-      return contents[:offset - left_trim_count] + contents[offset:]
-  return contents
+      return (left_trim_count, 0)
+  return (0, 0)
 
 
 def main():
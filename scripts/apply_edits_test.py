@@ -761,5 +761,58 @@ class ApplyReplacementTest(unittest.TestCase):
       _ApplyEdit(old_text, edit, last_edit=last)
 
 
+def _ApplyEdits(old_contents_string, edits):
+  new_contents, _, error_count = apply_edits._ApplyEditsToSingleFileContents(
+      'some_file.cc', old_contents_string.encode('utf-8'), edits)
+  return new_contents.decode('utf-8'), error_count
+
+
+class ApplyEditsToSingleFileContentsTest(unittest.TestCase):
+  def testMultipleReplacements(self):
+    old_text = "123 456 789"
+    edits = [
+        _CreateReplacement(old_text, "123", "a"),
+        _CreateReplacement(old_text, "789", "c"),
+        _CreateReplacement(old_text, "456", "b"),
+    ]
+    self.assertEqual(("a b c", 0), _ApplyEdits(old_text, edits))
+
+  def testDuplicateReplacements(self):
+    old_text = "123 456 789"
+    edits = [_CreateReplacement(old_text, "456", "foo")] * 3
+    self.assertEqual(("123 foo 789", 0), _ApplyEdits(old_text, edits))
+
+  def testAllListElementsRemoval(self):
+    old_text = "f(123, 456,\n  789);"
+    edits = [
+        _CreateReplacement(old_text, "123", ""),
+        _CreateReplacement(old_text, "456", ""),
+        _CreateReplacement(old_text, "789", ""),
+    ]
+    self.assertEqual(("f();", 0), _ApplyEdits(old_text, edits))
+
+  def testConflictingReplacement(self):
+    old_text = "123 456 789"
+    edits = [
+        _CreateReplacement(old_text, "456", "foo"),
+        _CreateReplacement(old_text, "456", "bar"),
+        _CreateReplacement(old_text, "123", "a"),
+    ]
+    self.assertEqual(("a foo 789", 1), _ApplyEdits(old_text, edits))
+
+  def testReplacementAndInclude(self):
+    old_text = "#include \"foo/impl.h\"\n\nint* x;\n"
+    edits = [
+        _CreateReplacement(old_text, "int*", "raw_ptr<int>"),
+        apply_edits.Edit('include-user-header', -1, -1, b"new/header.h"),
+    ]
+    new_text, _, error_count = apply_edits._ApplyEditsToSingleFileContents(
+        'foo/impl.cc', old_text.encode('utf-8'), edits)
+    self.assertEqual(
+        b"#include \"foo/impl.h\"\n\n#include \"new/header.h\"\n\n"
+        b"raw_ptr<int> x;\n", new_text)
+    self.assertEqual(0, error_count)
+
+
 if __name__ == '__main__':
   unittest.main()
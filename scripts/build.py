@@ -24,6 +24,7 @@ import glob
 import io
 import json
 import multiprocessing
+import multiprocessing.pool
 import os
 import shlex
 import platform
@@ -601,6 +602,88 @@ def compiler_rt_cmake_flags(*, sanitizers, profile):
   return args
 
 
+# The Chromium plugins compiled into clang, and the arguments Chromium's build
+# runs them with (see //build/config/clang/BUILD.gn), so that training with
+# --training-corpus also covers the plugins' code.
+TRAINING_PLUGIN_TOOLS = ['plugins', 'blink_gc_plugin', 'raw_ptr_plugin']
+TRAINING_PLUGIN_ARGS = {
+    'find-bad-constructs': [
+        'check-ipc',
+        'check-layout-object-methods',
+        'check-stack-allocated',
+        'raw-ref-template-as-trivial-member',
+        'raw-span-template-as-trivial-member',
+        'span-ctor-from-string-literal',
+    ],
+    'raw-ptr-plugin': [
+        'check-bad-raw-ptr-cast',
+        'check-raw-ptr-fields',
+        'check-raw-ptr-to-stack-allocated',
+        'check-raw-ref-fields',
+        'check-span-fields',
+        'disable-check-raw-ptr-to-stack-allocated-error',
+    ],
+    'blink-gc-plugin': [],
+    # The unsafe-buffers argument is its paths file, see TrainOnCorpus().
+    'unsafe-buffers': [],
+}
+TRAINING_CORPUS_CFLAGS = [
+    '-target', 'x86_64-unknown-linux-gnu', '-O2', '-g', '-std=c++20',
+    '-fno-exceptions', '-fno-rtti'
+]
+
+
+def TrainOnCorpus(clang, corpus_dir, work_dir, extra_flags=None):
+  """Compiles each preprocessed file (*.ii) in corpus_dir with clang and the
+  Chromium plugins, like a Chromium build would, to collect a profile."""
+  sources = sorted(
+      glob.glob(os.path.join(corpus_dir, '**', '*.ii'), recursive=True))
+  if not sources:
+    print('No *.ii files found in ' + corpus_dir)
+    sys.exit(1)
+  EnsureDirExists(work_dir)
+
+  # An empty paths file has unsafe-buffers check every file.
+  unsafe_buffers_paths = os.path.join(work_dir, 'unsafe_buffers_paths.txt')
+  with open(unsafe_buffers_paths, 'w') as f:
+    f.write('# Check all files.\n')
+  cmd = [clang] + TRAINING_CORPUS_CFLAGS + (extra_flags or [])
+  for plugin, plugin_args in TRAINING_PLUGIN_ARGS.items():
+    if plugin == 'unsafe-buffers':
+      plugin_args = [unsafe_buffers_paths]
+    cmd += ['-Xclang', '-add-plugin', '-Xclang', plugin]
+    for arg in plugin_args:
+      cmd += ['-Xclang', '-plugin-arg-' + plugin, '-Xclang', arg]
+  # The plugins and -Wunsafe-buffer-usage only run their checks for
+  # diagnostics that are enabled, so warnings are logged rather than disabled
+  # with -w.
+  cmd += ['-Wunsafe-buffer-usage', '-Wno-error', '-c', '-o', os.devnull]
+
+  # The corpus is not expected to be free of diagnostics, or to compile with
+  # every build of clang, so failures are counted rather than fatal.
+  print('Training on %d files from %s' % (len(sources), corpus_dir))
+  log_path = os.path.join(work_dir, 'training.log')
+  failures = []
+  with open(log_path, 'w') as log:
+
+    def Compile(source):
+      result = subprocess.run(cmd + [source],
+                              stdout=subprocess.PIPE,
+                              stderr=subprocess.STDOUT)
+      return source, result.returncode, result.stdout
+
+    with multiprocessing.pool.ThreadPool() as pool:
+      for source, returncode, output in pool.imap(Compile, sources):
+        log.write('%s: exit code %d\n' % (source, returncode))
+        log.write(output.decode('utf-8', errors='replace'))
+        if returncode != 0:
+          failures.append(source)
+  print('Trained on %d files, %d failed; see %s' %
+        (len(sources), len(failures), log_path))
+  if len(failures) == len(sources):
+    sys.exit(1)
+
+
 def gn_arg(v):
   if v == 'True':
     return True
@@ -628,6 +711,11 @@ def main():
                       action='store_true',
                       help='build with ThinLTO')
   parser.add_argument('--bolt', action='store_true', help='build with BOLT')
+  parser.add_argument('--training-corpus',
+                      help='train --pgo and --bolt by compiling the *.ii '
+                      'files in this directory with the Chromium plugins, '
+                      'instead of downloading pgo_training-1.ii (PGO) or '
+                      'building part of Clang (BOLT)')
   parser.add_argument('--llvm-force-head-revision', action='store_true',
                       help='build the latest revision')
   parser.add_argument('--run-tests', action='store_true',
@@ -694,6 +782,17 @@ def main():
   if (args.pgo or args.thinlto) and not args.bootstrap:
     print('--pgo/--thinlto requires --bootstrap')
     return 1
+  if args.training_corpus:
+    if not (args.pgo or args.bolt):
+      print('--training-corpus requires --pgo or --bolt')
+      return 1
+    if args.no_tools:
+      print('--training-corpus requires the plugins, not --no-tools')
+      return 1
+    if not os.path.isdir(args.training_corpus):
+      print('--training-corpus: no directory ' + args.training_corpus)
+      return 1
+    args.training_corpus = os.path.abspath(args.training_corpus)
   if args.with_android and not os.path.exists(ANDROID_NDK_DIR):
     print('Android NDK not found at ' + ANDROID_NDK_DIR)
     print('The Android NDK is needed to build a Clang whose -fsanitize=address')
@@ -1027,6 +1126,14 @@ def main():
         # Build with instrumentation.
         '-DLLVM_BUILD_INSTRUMENTED=IR',
     ]
+    if args.training_corpus:
+      # Build the plugins into the instrumented compiler, to profile them too.
+      instrument_args.extend([
+          '-DLLVM_EXTERNAL_PROJECTS=chrometools',
+          '-DLLVM_EXTERNAL_CHROMETOOLS_SOURCE_DIR=' +
+          os.path.join(CHROMIUM_DIR, 'tools', 'clang'),
+          '-DCHROMIUM_TOOLS=%s' % ';'.join(TRAINING_PLUGIN_TOOLS)
+      ])
     # Build with the bootstrap compiler.
     if cc is not None:  instrument_args.append('-DCMAKE_C_COMPILER=' + cc)
     if cxx is not None: instrument_args.append('-DCMAKE_CXX_COMPILER=' + cxx)
@@ -1059,15 +1166,25 @@ def main():
     # from more platforms, and by doing some linking so that lld can benefit
     # from PGO as well. Perhaps the training could be done asynchronously by
     # dedicated buildbots that upload profiles to the cloud.
-    training_source = 'pgo_training-1.ii'
-    with open(training_source, 'wb') as f:
-      DownloadUrl(CDS_URL + '/' + training_source, f)
-    train_cmd = [os.path.join(LLVM_INSTRUMENTED_DIR, 'bin', 'clang++'),
-                '-target', 'x86_64-unknown-unknown', '-O2', '-g', '-std=c++14',
-                 '-fno-exceptions', '-fno-rtti', '-w', '-c', training_source]
-    if sys.platform == 'darwin':
-      train_cmd.extend(['-isysroot', isysroot])
-    RunCommand(train_cmd, setenv=True)
+    #
+    # With --training-corpus, the training compiles a local corpus of
+    # preprocessed files instead, with the plugins enabled.
+    if args.training_corpus:
+      TrainOnCorpus(os.path.join(LLVM_INSTRUMENTED_DIR, 'bin', 'clang++'),
+                    args.training_corpus,
+                    os.path.join(LLVM_INSTRUMENTED_DIR, 'corpus-training'),
+                    ['-isysroot', isysroot] if sys.platform == 'darwin' else [])
+    else:
+      training_source = 'pgo_training-1.ii'
+      with open(training_source, 'wb') as f:
+        DownloadUrl(CDS_URL + '/' + training_source, f)
+      train_cmd = [os.path.join(LLVM_INSTRUMENTED_DIR, 'bin', 'clang++'),
+                  '-target', 'x86_64-unknown-unknown', '-O2', '-g',
+                   '-std=c++14', '-fno-exceptions', '-fno-rtti', '-w', '-c',
+                   training_source]
+      if sys.platform == 'darwin':
+        train_cmd.extend(['-isysroot', isysroot])
+      RunCommand(train_cmd, setenv=True)
 
     # Merge profiles.
     profdata = os.path.join(LLVM_BOOTSTRAP_INSTALL_DIR, 'bin', 'llvm-profdata')
@@ -1436,31 +1553,38 @@ def main():
         os.path.join(LLVM_BUILD_DIR, 'bin', 'clang++-bolt.inst')
     ])
 
-    # Train by building a part of Clang.
-    os.mkdir('bolt-training')
-    os.chdir('bolt-training')
-    bolt_train_cmake_args = base_cmake_args + [
-        '-DLLVM_TARGETS_TO_BUILD=X86',
-        '-DLLVM_ENABLE_PROJECTS=clang',
-        '-DCMAKE_C_FLAGS=' + ' '.join(cflags),
-        '-DCMAKE_CXX_FLAGS=' + ' '.join(cxxflags),
-        '-DCMAKE_EXE_LINKER_FLAGS=' + ' '.join(ldflags),
-        '-DCMAKE_SHARED_LINKER_FLAGS=' + ' '.join(ldflags),
-        '-DCMAKE_MODULE_LINKER_FLAGS=' + ' '.join(ldflags),
-        '-DCMAKE_C_COMPILER=' +
-        os.path.join(LLVM_BUILD_DIR, 'bin/clang-bolt.inst'),
-        '-DCMAKE_CXX_COMPILER=' +
-        os.path.join(LLVM_BUILD_DIR, 'bin/clang++-bolt.inst'),
-        '-DCMAKE_ASM_COMPILER=' +
-        os.path.join(LLVM_BUILD_DIR, 'bin/clang-bolt.inst'),
-        '-DCMAKE_ASM_COMPILER_ID=Clang',
-    ]
-    RunCommand(['cmake'] + bolt_train_cmake_args +
-               [os.path.join(LLVM_DIR, 'llvm')])
-    RunCommand([
-        'ninja', 'tools/clang/lib/Sema/CMakeFiles/obj.clangSema.dir/Sema.cpp.o'
-    ])
-    os.chdir(LLVM_BUILD_DIR)
+    if args.training_corpus:
+      # Train by compiling the corpus with the plugins.
+      TrainOnCorpus(os.path.join(LLVM_BUILD_DIR, 'bin', 'clang++-bolt.inst'),
+                    args.training_corpus,
+                    os.path.join(LLVM_BUILD_DIR, 'bolt-training'))
+    else:
+      # Train by building a part of Clang.
+      os.mkdir('bolt-training')
+      os.chdir('bolt-training')
+      bolt_train_cmake_args = base_cmake_args + [
+          '-DLLVM_TARGETS_TO_BUILD=X86',
+          '-DLLVM_ENABLE_PROJECTS=clang',
+          '-DCMAKE_C_FLAGS=' + ' '.join(cflags),
+          '-DCMAKE_CXX_FLAGS=' + ' '.join(cxxflags),
+          '-DCMAKE_EXE_LINKER_FLAGS=' + ' '.join(ldflags),
+          '-DCMAKE_SHARED_LINKER_FLAGS=' + ' '.join(ldflags),
+          '-DCMAKE_MODULE_LINKER_FLAGS=' + ' '.join(ldflags),
+          '-DCMAKE_C_COMPILER=' +
+          os.path.join(LLVM_BUILD_DIR, 'bin/clang-bolt.inst'),
+          '-DCMAKE_CXX_COMPILER=' +
+          os.path.join(LLVM_BUILD_DIR, 'bin/clang++-bolt.inst'),
+          '-DCMAKE_ASM_COMPILER=' +
+          os.path.join(LLVM_BUILD_DIR, 'bin/clang-bolt.inst'),
+          '-DCMAKE_ASM_COMPILER_ID=Clang',
+      ]
+      RunCommand(['cmake'] + bolt_train_cmake_args +
+                 [os.path.join(LLVM_DIR, 'llvm')])
+      RunCommand([
+          'ninja',
+          'tools/clang/lib/Sema/CMakeFiles/obj.clangSema.dir/Sema.cpp.o'
+      ])
+      os.chdir(LLVM_BUILD_DIR)
 
     # Optimize.
     RunCommand([
@@ -38,30 +38,74 @@ On unix this script can be replaced with running sed as follows:
     $ cat run_tool.debug.out \
         | sed '/^==== BEGIN EDITS ====$/,/^==== END EDITS ====$/{//!b};d'
         | sort | uniq
+
+If the input contains binary edit sections (see pylib/clang/binary_edits.py),
+all edits, including text ones, are merged and deduplicated into a single
+binary stream, which apply_edits.py reads like the text format.
 """
 
 from __future__ import print_function
 
+import os
 import sys
 
+script_dir = os.path.dirname(os.path.realpath(__file__))
+tool_dir = os.path.abspath(os.path.join(script_dir, '../pylib'))
+sys.path.insert(0, tool_dir)
+
+from clang import binary_edits
+
+
+def _ParseTextEdit(line):
+  """Returns the edit tuple for a text directive, or None if it's malformed."""
+  try:
+    edit_type, path, offset, length, replacement = line.decode('utf-8').split(
+        ':::', 4)
+    return (edit_type, path, int(offset), int(length),
+            replacement.replace('\0', '\n').encode('utf-8'))
+  except ValueError:
+    return None
+
 
 def main():
   # TODO(dcheng): extract_edits.py should normalize paths. Doing this in
   # apply_edits.py is too late, as a common use case is to apply edits from many
   # different platforms.
-  unique_lines = set()
+  # Both are used as ordered sets.
+  unique_lines = {}
+  unique_binary_edits = {}
   inside_marker_lines = False
-  for line in sys.stdin:
-    line = line.rstrip("\n\r")
-    if line == '==== BEGIN EDITS ====':
+  stdin = sys.stdin.buffer
+  for line in stdin:
+    line = line.rstrip(b"\n\r")
+    if line == b'==== BEGIN EDITS ====':
       inside_marker_lines = True
       continue
-    if line == '==== END EDITS ====':
+    if line == b'==== END EDITS ====':
       inside_marker_lines = False
       continue
-    if inside_marker_lines and line not in unique_lines:
-      unique_lines.add(line)
-      print(line)
+    if binary_edits.BEGIN_RE.match(line):
+      payload = binary_edits.ReadSection(stdin, line)
+      unique_binary_edits.update(
+          dict.fromkeys(binary_edits.DecodePayload(payload)))
+      continue
+    if inside_marker_lines:
+      unique_lines[line] = None
+
+  if not unique_binary_edits:
+    for line in unique_lines:
+      sys.stdout.buffer.write(line + b'\n')
+    return 0
+
+  for line in unique_lines:
+    edit = _ParseTextEdit(line)
+    if edit:
+      unique_binary_edits[edit] = None
+    else:
+      sys.stderr.write('Unable to parse edit: %s\n' %
+                       line.decode('utf-8', 'replace'))
+  sys.stdout.buffer.write(binary_edits.MAGIC)
+  sys.stdout.buffer.write(binary_edits.EncodePayload(unique_binary_edits))
   return 0
 
 
@@ -16,6 +16,39 @@ If you want to run the clang tool across only chrome/browser and
 content/browser:
 run_tool.py <tool> <path/to/compiledb> chrome/browser content/browser
 
+If the tool supports it (e.g. rewrite_raw_ptr_fields, spanify), --batch keeps a
+single tool process per worker and feeds it compile commands over stdin, which
+avoids paying the tool's startup cost for every file. Similarly, --cache-dir
+replays the recorded output for files whose inputs did not change since a
+previous run.
+
+The rewriters built on clang tooling (e.g. rewrite_raw_ptr_fields, spanify,
+base_bind_rewriters) can also skip reparsing common headers for every file:
+--tool-arg=--prefix-header=<header> precompiles <header> once per distinct set
+of compile flags and includes it in each file, and
+--tool-arg=--prefix-header-pch-dir=<dir> shares those PCHs between workers.
+This pays off most with --batch, and assumes that including <header> first does
+not change the meaning of any file.
+
+When only some headers need rewriting, --include-index <file> also runs the
+tool over the files that include, directly or not, a file under the path
+filters, so that e.g. a base/containers/ rewrite does not need --all. <file> is
+a reverse-include index, built from the include graph of the last build
+(`ninja -t deps`) if it is missing or older than that graph. With
+--include-index-source=filepaths it is built from the .filepaths files written
+by a previous run of the translation_unit tool instead, and with
+--include-index-source=scan-deps by running translation_unit --scan-deps-index,
+which does not need a build; either way, it is only rebuilt once deleted.
+
+--record-costs <file> records how long the tool took on each file. Passing that
+file to --costs in later runs starts the most expensive files first and balances
+--shard by cost rather than by count. Files without a recorded runtime can be
+estimated from the output of compiler_inputs_size.py with --input-sizes <file>.
+
+For runs with very large output, --spool-dir <dir> streams the output of each
+worker to a file instead of holding it in memory, and checkpoints which files
+are done so that an interrupted run can be resumed with the same directory.
+
 Please see docs/clang_tool_refactoring.md for more information, which documents
 the entire automated refactoring flow in Chromium.
 
@@ -52,6 +85,7 @@ from __future__ import print_function
 import argparse
 from collections import namedtuple
 import functools
+import hashlib
 import json
 import multiprocessing
 import os
@@ -60,12 +94,16 @@ import re
 import subprocess
 import shlex
 import sys
+import tempfile
+import time
 
 script_dir = os.path.dirname(os.path.realpath(__file__))
 tool_dir = os.path.abspath(os.path.join(script_dir, '../pylib'))
 sys.path.insert(0, tool_dir)
 
 from clang import compile_db
+from clang import include_index
+from clang import result_cache
 
 
 CompDBEntry = namedtuple('CompDBEntry', ['directory', 'filename', 'command'])
@@ -158,6 +196,50 @@ def _GetEntriesFromCompileDB(build_directory, source_filenames):
   ]
 
 
+def _GetIncludeIndex(path, source, build_directory, tool_path):
+  """Loads the reverse-include index at |path|, or builds and saves it if it is
+  missing, was built from another source, or was built from an older include
+  graph of the build.
+
+  Args:
+    path: Path of the index file.
+    source: include_index.NINJA, include_index.FILEPATHS or
+      include_index.SCAN_DEPS.
+    build_directory: Directory that contains the compile database.
+    tool_path: Directory that contains the translation_unit tool, for
+      include_index.SCAN_DEPS.
+  """
+  if os.path.exists(path):
+    index = include_index.IncludeIndex.Load(path)
+    ninja_deps = os.path.join(build_directory, '.ninja_deps')
+    stale = (index.source == include_index.NINJA
+             and os.path.exists(ninja_deps)
+             and os.path.getmtime(ninja_deps) > os.path.getmtime(path))
+    if index.source == source and not stale:
+      return index
+
+  if source == include_index.NINJA:
+    includes = compile_db.ReadNinjaDeps(build_directory)
+  elif source == include_index.SCAN_DEPS:
+    with tempfile.TemporaryDirectory() as temp_dir:
+      scan_deps_index = os.path.join(temp_dir, 'index')
+      subprocess.check_call([
+          os.path.join(tool_path, 'translation_unit'), '-p', build_directory,
+          '--scan-deps-index=%s' % scan_deps_index
+      ])
+      includes = include_index.ReadScanDepsIndex(scan_deps_index)
+  else:
+    includes = include_index.ReadFilepaths(build_directory, [
+        os.path.join(entry['directory'], entry['file'])
+        for entry in compile_db.Read(build_directory)
+    ])
+  index = include_index.IncludeIndex.Build(source, build_directory, includes)
+  index.Save(path)
+  sys.stderr.write('Indexed the includes of %d files in %s\n' %
+                   (len(index), path))
+  return index
+
+
 def _UpdateCompileCommandsIfNeeded(compile_commands, files_list,
                                    target_os=None):
   """ Filters compile database to only include required files, and makes it
@@ -185,35 +267,126 @@ def _UpdateCompileCommandsIfNeeded(compile_commands, files_list,
                                            target_os)
 
 
-def _ExecuteTool(toolname, tool_args, build_directory, compdb_entry):
-  """Executes the clang tool.
+def _CostKey(compdb_entry):
+  """Returns the key of |compdb_entry| in the costs. Like the compile DB, this
+  tells apart the same file built in several directories."""
+  return (compdb_entry.directory, compdb_entry.filename)
 
-  This is defined outside the class so it can be pickled for the multiprocessing
-  module.
+
+def _ReadCosts(costs_file):
+  """Reads the per-file tool runtimes recorded by a previous run.
 
   Args:
-    toolname: Name of the clang tool to execute.
-    tool_args: Arguments to be passed to the clang tool. Can be None.
-    build_directory: Directory that contains the compile database.
-    compdb_entry: The file and args to run the clang tool over.
+    costs_file: JSON file mapping compile DB directories to dicts mapping
+      compile DB filenames to runtimes in seconds. May not exist yet.
 
   Returns:
-    A dictionary that must contain the key "status" and a boolean value
-    associated with it.
+    A dict mapping the _CostKey of each recorded entry to its runtime.
+  """
+  try:
+    with open(costs_file) as f:
+      recorded = json.load(f)
+  except FileNotFoundError:
+    return {}
+  return {(directory, filename): seconds
+          for directory, files in recorded.items()
+          for filename, seconds in files.items()}
 
-    If status is True, then the generated output is stored with the key
-    "stdout_text" in the dictionary.
 
-    Otherwise, the filename and the output from stderr are associated with the
-    keys "filename" and "stderr_text" respectively.
+def _WriteCosts(costs_file, costs):
+  """Writes |costs|, a dict like the ones returned by _ReadCosts."""
+  recorded = {}
+  for (directory, filename), seconds in costs.items():
+    recorded.setdefault(directory, {})[filename] = seconds
+  fd, temp_file = tempfile.mkstemp(dir=os.path.dirname(
+      os.path.abspath(costs_file)))
+  with os.fdopen(fd, 'w') as f:
+    json.dump(recorded, f, indent=2, sort_keys=True)
+  os.replace(temp_file, costs_file)
+
+
+def _ReadInputSizes(input_sizes_file):
+  """Reads the output of compiler_inputs_size.py.
+
+  Returns:
+    A dict mapping the real path of each source file to the total size of the
+    files it includes.
   """
+  input_sizes = {}
+  with open(input_sizes_file) as f:
+    for line in f:
+      match = re.match(r'(\S+) ([\d,]+)$', line.strip())
+      if match:
+        input_sizes[os.path.realpath(match.group(1))] = int(
+            match.group(2).replace(',', ''))
+  return input_sizes
 
-  args = [toolname, compdb_entry.filename]
-  if (tool_args):
-    args.extend(tool_args)
 
-  args.append('--')
-  args.extend([
+def _EstimateCosts(compdb_entries, costs, input_sizes):
+  """Estimates the relative cost of running the tool over each entry.
+
+  Recorded runtimes are used when available. Otherwise the runtime is estimated
+  from the compiler input size, scaled by the average runtime per byte of the
+  entries that have both.
+
+  Args:
+    compdb_entries: The files and args to run the tool over.
+    costs: Runtimes recorded by previous runs, see _ReadCosts.
+    input_sizes: Compiler input sizes, see _ReadInputSizes.
+
+  Returns:
+    A dict mapping each entry to its estimated cost.
+  """
+  sizes = {}
+  for entry in compdb_entries:
+    path = os.path.realpath(os.path.join(entry.directory, entry.filename))
+    if path in input_sizes:
+      sizes[entry] = input_sizes[path]
+
+  timed = [e for e in compdb_entries if _CostKey(e) in costs and e in sizes]
+  timed_bytes = sum(sizes[e] for e in timed)
+  if timed_bytes:
+    seconds_per_byte = sum(costs[_CostKey(e)] for e in timed) / timed_bytes
+  else:
+    seconds_per_byte = 1.0
+
+  estimates = {}
+  for entry in compdb_entries:
+    if _CostKey(entry) in costs:
+      estimates[entry] = costs[_CostKey(entry)]
+    elif entry in sizes:
+      estimates[entry] = sizes[entry] * seconds_per_byte
+  # Entries we know nothing about are assumed to be average.
+  default_cost = (sum(estimates.values()) / len(estimates)) if estimates else 1
+  return {e: estimates.get(e, default_cost) for e in compdb_entries}
+
+
+def _ShardByCost(compdb_entries, costs, shard_number, shard_count):
+  """Splits entries into shards of roughly equal total cost and returns the
+  entries of one shard.
+
+  Entries are assigned greedily, most expensive first, to the shard with the
+  lowest total so far. The assignment only depends on the entries and their
+  costs, so every shard must be given the same cost data.
+  """
+  totals = [0] * shard_count
+  shard_entries = []
+  for entry in sorted(compdb_entries, key=lambda e: (-costs[e], e)):
+    shard = totals.index(min(totals))
+    totals[shard] += costs[entry]
+    if shard == shard_number:
+      shard_entries.append(entry)
+  return shard_entries
+
+
+def _GetCompileArgs(compdb_entry):
+  """Returns the compile command of |compdb_entry|, prepared to be passed to a
+  clang tool after '--'.
+
+  Args:
+    compdb_entry: The file and args to run the clang tool over.
+  """
+  args = [
       a for a in shlex.split(compdb_entry.command,
                              posix=(sys.platform != 'win32'))
       # 'command' contains the full command line, including the input
@@ -228,7 +401,7 @@ def _ExecuteTool(toolname, tool_args, build_directory, compdb_entry):
         # -MMD has the same purpose on non-Windows. It may have a corresponding
         # '-MF <filename>', which we strip below.
         and a != '-MMD'
-  ])
+  ]
 
   for i, arg in enumerate(args):
     if arg == '-MF':
@@ -239,34 +412,410 @@ def _ExecuteTool(toolname, tool_args, build_directory, compdb_entry):
   # them back.
   if sys.platform == 'win32':
     args = [a.replace('\\"', '"') for a in args]
-  command = subprocess.Popen(
-      args, stdout=subprocess.PIPE, stderr=subprocess.PIPE, cwd=build_directory)
-  stdout_text, stderr_text = command.communicate()
-  stdout_text = stdout_text.decode('utf-8')
-  stderr_text = stderr_text.decode('utf-8')
-  stderr_text = re.sub(
+  return args
+
+
+def _WriteToolOutput(stdout_text):
+  """Writes tool output to stdout.
+
+  Tool output is decoded with 'surrogateescape', so that binary sections such
+  as binary edits (see pylib/clang/binary_edits.py) go through unchanged.
+  """
+  sys.stdout.flush()
+  sys.stdout.buffer.write(stdout_text.encode('utf-8', 'surrogateescape'))
+
+
+def _FilterToolStderr(stderr_text):
+  """Removes known noise from the stderr output of a clang tool."""
+  return re.sub(
       r"^warning: .*'linker' input unused \[-Wunused-command-line-argument\]\n",
       "", stderr_text, flags=re.MULTILINE)
 
+
+def _ExecuteTool(toolname,
+                 tool_args,
+                 build_directory,
+                 compdb_entry,
+                 inputs_file=None,
+                 stdout_file=None):
+  """Executes the clang tool.
+
+  This is defined outside the class so it can be pickled for the multiprocessing
+  module.
+
+  Args:
+    toolname: Name of the clang tool to execute.
+    tool_args: Arguments to be passed to the clang tool. Can be None.
+    build_directory: Directory that contains the compile database.
+    compdb_entry: The file and args to run the clang tool over.
+    inputs_file: If not None, the tool is asked to write the list of files read
+      by the translation unit to this path.
+    stdout_file: If not None, a binary file the output of the tool is appended
+      to, instead of being returned.
+
+  Returns:
+    A dictionary that must contain the key "status" and a boolean value
+    associated with it.
+
+    If status is True, then the generated output is stored with the key
+    "stdout_text" in the dictionary, unless |stdout_file| was given. It is
+    decoded with 'surrogateescape', see _WriteToolOutput.
+
+    Otherwise, the filename and the output from stderr are associated with the
+    keys "filename" and "stderr_text" respectively.
+  """
+
+  args = [toolname, compdb_entry.filename]
+  if (tool_args):
+    args.extend(tool_args)
+  if inputs_file:
+    args.append('--inputs-file=%s' % inputs_file)
+
+  args.append('--')
+  args.extend(_GetCompileArgs(compdb_entry))
+
+  command = subprocess.Popen(args,
+                             stdout=stdout_file or subprocess.PIPE,
+                             stderr=subprocess.PIPE,
+                             cwd=build_directory)
+  stdout_text, stderr_text = command.communicate()
+  stderr_text = _FilterToolStderr(stderr_text.decode('utf-8'))
+
   if command.returncode != 0:
     return {
         'status': False,
         'filename': compdb_entry.filename,
         'stderr_text': stderr_text,
     }
+  result = {
+      'status': True,
+      'filename': compdb_entry.filename,
+      'stderr_text': stderr_text,
+  }
+  if stdout_file is None:
+    result['stdout_text'] = stdout_text.decode('utf-8', 'surrogateescape')
+  return result
+
+
+# Must match kBatchEntryDoneMarker in raw_ptr_plugin/BatchMode.h.
+_BATCH_ENTRY_DONE_RE = re.compile(br'^==== END OF BATCH ENTRY (-?\d+) ====$')
+
+
+class _BatchToolWorker(object):
+  """A long-lived clang tool process that handles many compile commands.
+
+  The tool must support the --batch flag (see raw_ptr_plugin/BatchMode.h). Its
+  stdout is read up to the end-of-entry marker for each compile command, and
+  its stderr goes to a temporary file which is read back after each entry, so
+  neither pipe can fill up and block the tool.
+  """
+
+  def __init__(self, toolname, tool_args, build_directory):
+    self.__args = [toolname, '--batch']
+    if tool_args:
+      self.__args.extend(tool_args)
+    self.__args.append('--')
+    self.__build_directory = build_directory
+    self.__process = None
+    self.__stderr_file = None
+
+  def __Start(self):
+    self.__stderr_file = tempfile.TemporaryFile()
+    self.__process = subprocess.Popen(self.__args,
+                                      stdin=subprocess.PIPE,
+                                      stdout=subprocess.PIPE,
+                                      stderr=self.__stderr_file,
+                                      cwd=self.__build_directory)
+
+  def __ReadStderr(self):
+    self.__stderr_file.seek(0)
+    stderr_text = self.__stderr_file.read().decode('utf-8')
+    self.__stderr_file.seek(0)
+    self.__stderr_file.truncate()
+    return _FilterToolStderr(stderr_text)
+
+  def Execute(self, compdb_entry, inputs_file=None, stdout_file=None):
+    """Runs the tool over |compdb_entry|. Takes the same |inputs_file| and
+    |stdout_file| and returns the same dictionary as _ExecuteTool."""
+    if self.__process is None:
+      self.__Start()
+
+    request = {
+        'file': compdb_entry.filename,
+        'arguments': _GetCompileArgs(compdb_entry),
+    }
+    if inputs_file:
+      request['inputs_file'] = inputs_file
+    request = json.dumps(request)
+    stdout_lines = []
+    returncode = None
+    try:
+      self.__process.stdin.write((request + '\n').encode('utf-8'))
+      self.__process.stdin.flush()
+      for line in iter(self.__process.stdout.readline, b''):
+        match = _BATCH_ENTRY_DONE_RE.match(line.rstrip(b'\n'))
+        if match:
+          returncode = int(match.group(1))
+          break
+        if stdout_file is None:
+          stdout_lines.append(line)
+        else:
+          stdout_file.write(line)
+    except BrokenPipeError:
+      pass
+
+    if returncode is None:
+      # The tool died while processing this entry. Report what it printed and
+      # start a fresh process for the next one.
+      self.__process.kill()
+      self.__process.wait()
+      self.__process = None
+      stderr_text = self.__ReadStderr()
+      self.__stderr_file.close()
+      return {
+          'status': False,
+          'filename': compdb_entry.filename,
+          'stderr_text': stderr_text,
+      }
+
+    stderr_text = self.__ReadStderr()
+    if returncode != 0:
+      return {
+          'status': False,
+          'filename': compdb_entry.filename,
+          'stderr_text': stderr_text,
+      }
+    result = {
+        'status': True,
+        'filename': compdb_entry.filename,
+        'stderr_text': stderr_text,
+    }
+    if stdout_file is None:
+      result['stdout_text'] = b''.join(stdout_lines).decode(
+          'utf-8', 'surrogateescape')
+    return result
+
+
+class _OutputSpool(object):
+  """A file that one pool worker appends tool output to, so that the output of
+  an entry is never held in memory or sent back to the parent process.
+
+  Next to the output file, an index records the byte range of each entry that
+  completed successfully. It is only appended to once an entry's output is
+  fully written, so after a crash the index lists exactly the entries that do
+  not need to run again.
+  """
+
+  def __init__(self, spool_dir, tool):
+    """Initializer method.
+
+    Args:
+      spool_dir: Directory to create the output and index files in.
+      tool: The tool and its arguments, which are part of every _SpoolKey.
+    """
+    self.__tool = tool
+    fd, self.__path = tempfile.mkstemp(dir=spool_dir,
+                                       prefix='worker-',
+                                       suffix='.out')
+    os.close(fd)
+    self.file = open(self.__path, 'ab')
+    self.__index = open(self.__path[:-len('.out')] + '.index', 'a')
+
+  def __Size(self):
+    self.file.flush()
+    return os.fstat(self.file.fileno()).st_size
+
+  def Begin(self):
+    """Returns the offset the output of the next entry starts at."""
+    return self.__Size()
+
+  def Commit(self, compdb_entry, start):
+    """Records the output written since |start| as the output of
+    |compdb_entry|."""
+    self.__index.write(
+        json.dumps({
+            'key': _SpoolKey(self.__tool, compdb_entry),
+            'output': os.path.basename(self.__path),
+            'offset': start,
+            'length': self.__Size() - start,
+        }) + '\n')
+    self.__index.flush()
+
+  def Abort(self, start):
+    """Discards the output written since |start|."""
+    self.file.flush()
+    self.file.truncate(start)
+
+
+def _SpoolKey(tool, compdb_entry):
+  """Returns the key of the output of |tool|, a [toolname, tool_args] list, for
+  |compdb_entry|. Output spooled by a run with another tool or other arguments
+  is not resumed from."""
+  return hashlib.sha256(
+      json.dumps([tool, list(compdb_entry)]).encode('utf-8')).hexdigest()
+
+
+def _ReadSpoolIndex(spool_dir):
+  """Returns the entries recorded by the _OutputSpools in |spool_dir|, as a
+  dict mapping _SpoolKey() to the (output file, offset, length) of their
+  output."""
+  records = {}
+  for name in sorted(os.listdir(spool_dir)):
+    if not name.endswith('.index'):
+      continue
+    with open(os.path.join(spool_dir, name)) as f:
+      for line in f:
+        try:
+          record = json.loads(line)
+        except ValueError:
+          # The last line is incomplete if the run crashed while writing it.
+          continue
+        records.setdefault(record['key'],
+                           (os.path.join(spool_dir, record['output']),
+                            record['offset'], record['length']))
+  return records
+
+
+def _CopySpooledOutput(records, output):
+  """Copies the output of the spooled |records| to the binary file |output|."""
+  for path, offset, length in sorted(records):
+    with open(path, 'rb') as f:
+      f.seek(offset)
+      while length > 0:
+        chunk = f.read(min(length, 1 << 20))
+        if not chunk:
+          break
+        output.write(chunk)
+        length -= len(chunk)
+
+
+# The _BatchToolWorker, _OutputSpool and result_cache.ResultCache owned by the
+# current multiprocessing pool worker, if any. The spool is created on first
+# use, from _spool_args.
+_batch_worker = None
+_spool = None
+_spool_args = None
+_cache = None
+
+
+def _InitWorker(batch_args, spool_args, cache):
+  """Sets up the state of a pool worker.
+
+  Args:
+    batch_args: Arguments to _BatchToolWorker, or None if not in batch mode.
+    spool_args: Arguments to this worker's _OutputSpool, or None.
+    cache: The result_cache.ResultCache to use, or None. It is kept for the
+      lifetime of the worker, so that its memo of file digests is shared by all
+      of the entries the worker runs.
+  """
+  global _batch_worker
+  global _spool_args
+  global _cache
+  if batch_args:
+    _batch_worker = _BatchToolWorker(*batch_args)
+  _spool_args = spool_args
+  _cache = cache
+
+
+def _ExecuteToolInBatchWorker(compdb_entry, inputs_file=None, stdout_file=None):
+  """Same as _ExecuteTool, but reuses the tool process of this pool worker."""
+  return _batch_worker.Execute(compdb_entry, inputs_file, stdout_file)
+
+
+def _ExecuteToolSpooled(execute, compdb_entry):
+  """Runs |execute| over |compdb_entry|, streaming the output to the spool of
+  this pool worker."""
+  global _spool
+  if _spool is None:
+    _spool = _OutputSpool(*_spool_args)
+  start = _spool.Begin()
+  result = execute(compdb_entry, stdout_file=_spool.file)
+  if result['status']:
+    _spool.Commit(compdb_entry, start)
   else:
-    return {
+    _spool.Abort(start)
+  return result
+
+
+def _ExecuteToolWithCache(build_directory,
+                          execute,
+                          compdb_entry,
+                          stdout_file=None):
+  """Replays the result cached by this pool worker's result_cache.ResultCache
+  for |compdb_entry|, or runs |execute| and records its result.
+
+  Args:
+    build_directory: Directory that contains the compile database.
+    execute: _ExecuteTool or _ExecuteToolInBatchWorker, with all but the
+      |compdb_entry|, |inputs_file| and |stdout_file| arguments bound.
+    compdb_entry: The file and args to run the clang tool over.
+    stdout_file: Same as for _ExecuteTool.
+
+  Returns:
+    The same dictionary as _ExecuteTool, with "cached" set to True if the result
+    was replayed.
+  """
+  directory = os.path.abspath(build_directory)
+  arguments = _GetCompileArgs(compdb_entry)
+  cached = _cache.Lookup(directory, compdb_entry.filename, arguments)
+  if cached is not None:
+    stdout_text, stderr_text = cached
+    result = {
         'status': True,
+        'cached': True,
         'filename': compdb_entry.filename,
-        'stdout_text': stdout_text,
         'stderr_text': stderr_text,
     }
+    if stdout_file is None:
+      result['stdout_text'] = stdout_text
+    else:
+      stdout_file.write(stdout_text.encode('utf-8', 'surrogateescape'))
+    return result
+
+  if stdout_file is not None:
+    stdout_file.flush()
+    start = os.fstat(stdout_file.fileno()).st_size
+  with tempfile.TemporaryDirectory() as temp_dir:
+    inputs_file = os.path.join(temp_dir, 'inputs.d')
+    result = execute(compdb_entry,
+                     inputs_file=inputs_file,
+                     stdout_file=stdout_file)
+    if result['status']:
+      if stdout_file is None:
+        stdout_text = result['stdout_text']
+      else:
+        # Read the output back from the spool.
+        stdout_file.flush()
+        with open(stdout_file.name, 'rb') as f:
+          f.seek(start)
+          stdout_text = f.read().decode('utf-8', 'surrogateescape')
+      _cache.Store(directory, compdb_entry.filename, arguments, inputs_file,
+                   stdout_text, result['stderr_text'])
+  return result
+
+
+def _ExecuteToolTimed(execute, compdb_entry, **kwargs):
+  """Runs |execute| over |compdb_entry| and adds its wall time to the result
+  with the key "elapsed", and its _CostKey with the key "cost_key"."""
+  start = time.monotonic()
+  result = execute(compdb_entry, **kwargs)
+  result['elapsed'] = time.monotonic() - start
+  result['cost_key'] = _CostKey(compdb_entry)
+  return result
 
 
 class _CompilerDispatcher(object):
   """Multiprocessing controller for running clang tools in parallel."""
 
-  def __init__(self, toolname, tool_args, build_directory, compdb_entries):
+  def __init__(self,
+               toolname,
+               tool_args,
+               build_directory,
+               compdb_entries,
+               batch=False,
+               cache_dir=None,
+               costs_file=None,
+               spool_dir=None):
     """Initializer method.
 
     Args:
@@ -274,12 +823,27 @@ class _CompilerDispatcher(object):
       tool_args: Arguments to be passed to the tool. Can be None.
       build_directory: Directory that contains the compile database.
       compdb_entries: The files and args to run the tool over.
+      batch: Whether to keep one tool process per worker, feeding it compile
+        commands over stdin, instead of starting the tool for every entry.
+      cache_dir: If not None, directory of a result_cache.ResultCache used to
+        replay the output of entries whose inputs did not change.
+      costs_file: If not None, the runtime of each entry is merged into this
+        file, for use by --costs in later runs.
+      spool_dir: If not None, tool output is streamed to files in this
+        directory and only copied to stdout at the end. Entries already
+        recorded there by an earlier, interrupted run are not run again.
     """
     self.__toolname = toolname
     self.__tool_args = tool_args
     self.__build_directory = build_directory
     self.__compdb_entries = compdb_entries
+    self.__batch = batch
+    self.__cache_dir = cache_dir
+    self.__costs_file = costs_file
+    self.__spool_dir = spool_dir
+    self.__elapsed = {}
     self.__success_count = 0
+    self.__cached_count = 0
     self.__failed_count = 0
 
   @property
@@ -288,14 +852,66 @@ class _CompilerDispatcher(object):
 
   def Run(self):
     """Does the grunt work."""
-    pool = multiprocessing.Pool()
-    result_iterator = pool.imap_unordered(
-        functools.partial(_ExecuteTool, self.__toolname, self.__tool_args,
-                          self.__build_directory),
-                          self.__compdb_entries)
+    spooled_records = {}
+    spool_args = None
+    spool_tool = [self.__toolname, self.__tool_args or []]
+    if self.__spool_dir:
+      spool_args = (self.__spool_dir, spool_tool)
+      os.makedirs(self.__spool_dir, exist_ok=True)
+      spooled_records = _ReadSpoolIndex(self.__spool_dir)
+      remaining_entries = [
+          e for e in self.__compdb_entries
+          if _SpoolKey(spool_tool, e) not in spooled_records
+      ]
+      if len(remaining_entries) != len(self.__compdb_entries):
+        sys.stderr.write('Resuming: %d of %d entries already done\n' %
+                         (len(self.__compdb_entries) - len(remaining_entries),
+                          len(self.__compdb_entries)))
+      all_entries = self.__compdb_entries
+      self.__compdb_entries = remaining_entries
+
+    batch_args = None
+    if self.__batch:
+      batch_args = (self.__toolname, self.__tool_args, self.__build_directory)
+      execute = _ExecuteToolInBatchWorker
+    else:
+      execute = functools.partial(_ExecuteTool, self.__toolname,
+                                  self.__tool_args, self.__build_directory)
+    cache = None
+    if self.__cache_dir:
+      cache = result_cache.ResultCache(self.__cache_dir, self.__toolname,
+                                       self.__tool_args,
+                                       self.__build_directory)
+      execute = functools.partial(_ExecuteToolWithCache,
+                                  self.__build_directory, execute)
+    pool = multiprocessing.Pool(initializer=_InitWorker,
+                                initargs=(batch_args, spool_args, cache))
+    if self.__costs_file:
+      execute = functools.partial(_ExecuteToolTimed, execute)
+    if self.__spool_dir:
+      execute = functools.partial(_ExecuteToolSpooled, execute)
+    result_iterator = pool.imap_unordered(execute, self.__compdb_entries)
     for result in result_iterator:
       self.__ProcessResult(result)
     sys.stderr.write('\n')
+    if self.__spool_dir:
+      # Close the spools, then pick up what this run added to them.
+      pool.close()
+      pool.join()
+      spooled_records = _ReadSpoolIndex(self.__spool_dir)
+      sys.stdout.flush()
+      _CopySpooledOutput([
+          spooled_records[_SpoolKey(spool_tool, e)]
+          for e in all_entries if _SpoolKey(spool_tool, e) in spooled_records
+      ], sys.stdout.buffer)
+      sys.stdout.buffer.flush()
+    if self.__cache_dir:
+      sys.stderr.write('Replayed %d results from the cache\n' %
+                       self.__cached_count)
+    if self.__costs_file:
+      costs = _ReadCosts(self.__costs_file)
+      costs.update(self.__elapsed)
+      _WriteCosts(self.__costs_file, costs)
 
   def __ProcessResult(self, result):
     """Handles result processing.
@@ -303,9 +919,14 @@ class _CompilerDispatcher(object):
     Args:
       result: The result dictionary returned by _ExecuteTool.
     """
+    if 'elapsed' in result and not result.get('cached'):
+      self.__elapsed[result['cost_key']] = result['elapsed']
     if result['status']:
       self.__success_count += 1
-      sys.stdout.write(result['stdout_text'])
+      if result.get('cached'):
+        self.__cached_count += 1
+      if 'stdout_text' in result:
+        _WriteToolOutput(result['stdout_text'])
       sys.stderr.write(result['stderr_text'])
     else:
       self.__failed_count += 1
@@ -339,7 +960,26 @@ def main():
       help='regenerate the compile database before running the tool')
   parser.add_argument(
       '--shard',
-      metavar='<n>-of-<count>')
+      metavar='<n>-of-<count>',
+      help='only process one shard of the entries; with --costs or '
+      '--input-sizes, shards are balanced by cost instead of by count, so all '
+      'shards must be given the same files')
+  parser.add_argument(
+      '--costs',
+      metavar='<file>',
+      help='JSON file of per-file tool runtimes written by --record-costs, '
+      'used to run the most expensive files first and to balance shards')
+  parser.add_argument(
+      '--record-costs',
+      metavar='<file>',
+      help='JSON file to merge the per-file runtimes measured by this run '
+      'into; can be the same file as --costs unless shards run one after '
+      'another')
+  parser.add_argument(
+      '--input-sizes',
+      metavar='<file>',
+      help='output of compiler_inputs_size.py, used to estimate the cost of '
+      'files without a recorded runtime')
   parser.add_argument(
       '-p',
       required=True,
@@ -359,6 +999,36 @@ def main():
   parser.add_argument(
       '--tool-path', nargs='?',
       help='optional path to the tool directory')
+  parser.add_argument(
+      '--batch',
+      action='store_true',
+      help='keep one tool process per worker and feed it compile commands '
+      'over stdin; the tool must support --batch')
+  parser.add_argument(
+      '--cache-dir',
+      help='directory of a cache of tool results, keyed on the tool, its '
+      'arguments, the files they name and the contents of every file a TU '
+      'reads; the tool must support --inputs-file')
+  parser.add_argument(
+      '--include-index',
+      metavar='<file>',
+      help='reverse-include index used to also process the files that '
+      'include a file under the path filters; built if needed')
+  parser.add_argument(
+      '--include-index-source',
+      choices=[
+          include_index.NINJA, include_index.FILEPATHS, include_index.SCAN_DEPS
+      ],
+      default=include_index.NINJA,
+      help='build the --include-index from the include graph of the last '
+      'build, from the .filepaths files written by the translation_unit tool, '
+      'or by running the translation_unit tool with --scan-deps-index, which '
+      'needs no build')
+  parser.add_argument(
+      '--spool-dir',
+      help='stream tool output to files in this directory instead of memory, '
+      'and copy it to stdout once all files are processed; rerunning with the '
+      'same directory after a crash skips the files already processed')
   args = parser.parse_args(argv)
 
   if args.tool_path:
@@ -382,6 +1052,14 @@ def main():
     source_filenames = [
         f for f in git_filenames if os.path.splitext(f)[1] in extensions
     ]
+    if args.include_index and args.path_filter:
+      index = _GetIncludeIndex(args.include_index, args.include_index_source,
+                               args.p, tool_path)
+      including_filenames = index.TranslationUnitsIncluding(git_filenames)
+      sys.stderr.write('%d of %d indexed files include the filtered paths\n' %
+                       (len(including_filenames), len(index)))
+      source_filenames = sorted(
+          set(source_filenames).union(including_filenames))
 
   if args.generate_compdb:
     compile_commands = compile_db.GenerateWithNinja(args.p)
@@ -393,23 +1071,43 @@ def main():
 
   compdb_entries = set(_GetEntriesFromCompileDB(args.p, source_filenames))
 
+  costs = None
+  if args.costs or args.input_sizes:
+    costs = _EstimateCosts(
+        compdb_entries,
+        _ReadCosts(args.costs) if args.costs else {},
+        _ReadInputSizes(args.input_sizes) if args.input_sizes else {})
+
   if args.shard:
     total_length = len(compdb_entries)
     match = re.match(r'(\d+)-of-(\d+)$', args.shard)
     # Input is 1-based, but modular arithmetic is 0-based.
     shard_number = int(match.group(1)) - 1
     shard_count = int(match.group(2))
-    compdb_entries = [
-        f for i, f in enumerate(sorted(compdb_entries))
-        if i % shard_count == shard_number
-    ]
+    if costs:
+      compdb_entries = _ShardByCost(compdb_entries, costs, shard_number,
+                                    shard_count)
+    else:
+      compdb_entries = [
+          f for i, f in enumerate(sorted(compdb_entries))
+          if i % shard_count == shard_number
+      ]
     print('Shard %d-of-%d will process %d entries out of %d' %
           (shard_number, shard_count, len(compdb_entries), total_length))
 
+  if costs:
+    # Start the most expensive entries first, so that they don't end up running
+    # alone at the end of the run.
+    compdb_entries = sorted(compdb_entries, key=lambda e: (-costs[e], e))
+
   dispatcher = _CompilerDispatcher(os.path.join(tool_path, args.tool),
                                    args.tool_arg,
                                    args.p,
-                                   compdb_entries)
+                                   compdb_entries,
+                                   batch=args.batch,
+                                   cache_dir=args.cache_dir,
+                                   costs_file=args.record_costs,
+                                   spool_dir=args.spool_dir)
   dispatcher.Run()
   return -dispatcher.failed_count
 
@@ -0,0 +1,540 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Native implementation of extract_edits.py.
+//
+// Reads the graph emitted by the spanify tool on stdin and writes the edits to
+// apply on stdout, plus the per-patch files in ~/scratch. The output is the
+// same as extract_edits.py's, byte for byte; see that script for a description
+// of the algorithm. With --binary-edits, the edits are written in the binary
+// format read by apply_edits.py instead (see raw_ptr_plugin/BinaryEdits.h).
+//
+// Unlike the script, it doesn't keep one object per node: node keys and
+// directives are interned once, node attributes live in flat arrays and the
+// adjacency lists are stored in CSR form (one array of offsets, one array of
+// targets). The graph traversals are iterative, so deep chains of assignments
+// don't overflow the stack.
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BinaryEdits.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace {
+
+constexpr uint32_t kNoNode = UINT32_MAX;
+
+// Adjacency lists in compressed sparse row form: the neighbors of node `n` are
+// targets[offsets[n]] to targets[offsets[n + 1]], in order of first insertion.
+struct Csr {
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> targets;
+
+  // Builds the lists from `edges`, dropping duplicates. The order of the
+  // neighbors of a node is the order of their first edge.
+  void Build(uint32_t num_nodes,
+             const std::vector<std::pair<uint32_t, uint32_t>>& edges) {
+    offsets.assign(num_nodes + 1, 0);
+    for (const auto& edge : edges) {
+      ++offsets[edge.first + 1];
+    }
+    for (uint32_t i = 0; i < num_nodes; ++i) {
+      offsets[i + 1] += offsets[i];
+    }
+    std::vector<uint32_t> unsorted(edges.size());
+    std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+    for (const auto& edge : edges) {
+      unsorted[next[edge.first]++] = edge.second;
+    }
+
+    // Deduplicate in place. `last_source[target]` is the last node that had
+    // `target` as a neighbor.
+    std::vector<uint32_t> last_source(num_nodes, kNoNode);
+    targets.clear();
+    targets.reserve(unsorted.size());
+    uint32_t begin = 0;
+    for (uint32_t node = 0; node < num_nodes; ++node) {
+      uint32_t end = offsets[node + 1];
+      offsets[node] = targets.size();
+      for (uint32_t i = begin; i < end; ++i) {
+        uint32_t target = unsorted[i];
+        if (last_source[target] != node) {
+          last_source[target] = node;
+          targets.push_back(target);
+        }
+      }
+      begin = end;
+    }
+    offsets[num_nodes] = targets.size();
+  }
+
+  uint32_t Begin(uint32_t node) const { return offsets[node]; }
+  uint32_t End(uint32_t node) const { return offsets[node + 1]; }
+  uint32_t Size(uint32_t node) const { return End(node) - Begin(node); }
+};
+
+class Graph {
+ public:
+  // Adds a line of the spanify output: either a buffer node or an edge.
+  // Returns false and sets `error` if the line is malformed.
+  bool AddLine(llvm::StringRef line, std::string& error) {
+    llvm::SmallVector<llvm::StringRef, 2> nodes;
+    line.split(nodes, '@');
+
+    // If there's only one node, it's a buffer node.
+    if (nodes.size() == 1) {
+      uint32_t node = AddNode(nodes[0], error);
+      if (node == kNoNode) {
+        return false;
+      }
+      is_buffer_[node] = true;
+      return true;
+    }
+
+    // Else, parse the edge between two nodes:
+    if (nodes.size() != 2) {
+      error = llvm::formatv("Length of nodes: {0}", nodes.size());
+      return false;
+    }
+    uint32_t lhs = AddNode(nodes[0], error);
+    if (lhs == kNoNode) {
+      return false;
+    }
+    uint32_t rhs = AddNode(nodes[1], error);
+    if (rhs == kNoNode) {
+      return false;
+    }
+    edges_.emplace_back(lhs, rhs);
+    return true;
+  }
+
+  // Computes the changes to apply, grouped by connected component.
+  bool Solve(std::string& error) {
+    uint32_t num_nodes = NumNodes();
+    neighbors_.Build(num_nodes, edges_);
+    std::vector<std::pair<uint32_t, uint32_t>>().swap(edges_);
+
+    // Determine whether size information is available for each buffer node:
+    size_info_step_.assign(num_nodes, kNotVisited);
+    for (uint32_t node = 0; node < num_nodes; ++node) {
+      if (is_buffer_[node]) {
+        SizeInfoAvailable(node);
+      }
+    }
+
+    AssignComponents();
+
+    // Collect the changes to apply. Starting from buffers nodes whose size
+    // info could be determined.
+    visited_.assign(num_nodes, false);
+    for (uint32_t node = 0; node < num_nodes; ++node) {
+      if (is_buffer_[node] && size_info_available_[node]) {
+        Visit(node);
+      }
+    }
+
+    // Deref expressions need to be adapted if their only neighbor was
+    // rewritten.
+    for (uint32_t node = 0; node < num_nodes; ++node) {
+      if (!is_deref_node_[node]) {
+        continue;
+      }
+      if (neighbors_.Size(node) == 0) {
+        error = "Deref node without neighbor: " + NodeDebugString(node);
+        return false;
+      }
+      uint32_t neighbor = neighbors_.targets[neighbors_.Begin(node)];
+      if (visited_[neighbor]) {
+        AddChange(component_[neighbor], replacement_[node]);
+      }
+    }
+
+    // At the edge in between rewritten and non-rewritten nodes, a call to
+    // `.data()` is needed to access the pointer from the span.
+    for (uint32_t node = 0; node < num_nodes; ++node) {
+      if (!is_data_change_[node]) {
+        continue;
+      }
+
+      // The lhs key is stored in the data change node's include directive. If
+      // lhs was rewritten, `.data()` isn't needed.
+      uint32_t lhs = node_of_string_[include_directive_[node]];
+      if (lhs == kNoNode) {
+        error = "Unknown lhs node of data change: " + NodeDebugString(node);
+        return false;
+      }
+      if (visited_[lhs]) {
+        continue;
+      }
+
+      // Either all or none of the rhs nodes were rewritten; see the comments
+      // in extract_edits.py about macros.
+      uint32_t num_neighbors = neighbors_.Size(node);
+      if (num_neighbors < 1) {
+        error = "Data change node without neighbor: " + NodeDebugString(node);
+        return false;
+      }
+      uint32_t num_visited = 0;
+      for (uint32_t i = neighbors_.Begin(node); i < neighbors_.End(node); ++i) {
+        uint32_t neighbor = neighbors_.targets[i];
+        if (visited_[neighbor]) {
+          ++num_visited;
+          AddChange(component_[neighbor], replacement_[node]);
+        }
+      }
+      if (num_visited != 0 && num_visited != num_neighbors) {
+        error = llvm::formatv("node: {0} num: {1} visited: {2}",
+                              NodeDebugString(node), num_neighbors,
+                              num_visited);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Writes the changes to `out`, or adds them to `binary_edits` if it isn't
+  // null, and writes the per-component patches to `scratch_dir`.
+  bool Emit(llvm::raw_ostream& out,
+            raw_ptr_plugin::BinaryEditsWriter* binary_edits,
+            llvm::StringRef scratch_dir,
+            std::string& error) {
+    llvm::SmallString<128> summary_path(scratch_dir);
+    llvm::sys::path::append(summary_path, "patches.txt");
+    std::error_code ec;
+    llvm::raw_fd_ostream summary(summary_path, ec, llvm::sys::fs::OF_Text);
+    if (ec) {
+      error = llvm::formatv("{0}: {1}", summary_path, ec.message());
+      return false;
+    }
+
+    // Same order as extract_edits.py: components in creation order, changes
+    // sorted as Python strings (which matches byte order for UTF-8).
+    uint32_t index = 0;
+    for (std::vector<uint32_t>& changes : changes_) {
+      if (changes.empty()) {
+        continue;
+      }
+      std::sort(changes.begin(), changes.end(), [this](uint32_t a, uint32_t b) {
+        return strings_[a] < strings_[b];
+      });
+      for (uint32_t text : changes) {
+        if (!binary_edits) {
+          out << strings_[text] << '\n';
+        } else if (!binary_edits->AddDirective(strings_[text])) {
+          // Same as apply_edits.py does with text directives.
+          llvm::errs() << "Unable to parse edit: " << strings_[text] << "\n";
+        }
+      }
+
+      summary << llvm::formatv("patch_{0}: {1}\n", index, changes.size());
+
+      llvm::SmallString<128> patch_path(scratch_dir);
+      llvm::sys::path::append(patch_path,
+                              llvm::formatv("patch_{0}.txt", index).str());
+      llvm::raw_fd_ostream patch(patch_path, ec, llvm::sys::fs::OF_Text);
+      if (ec) {
+        error = llvm::formatv("{0}: {1}", patch_path, ec.message());
+        return false;
+      }
+      for (size_t i = 0; i < changes.size(); ++i) {
+        if (i) {
+          patch << '\n';
+        }
+        patch << strings_[changes[i]];
+      }
+      ++index;
+    }
+    return true;
+  }
+
+ private:
+  enum SizeInfoStep : uint8_t { kNotVisited, kVisiting, kVisited };
+
+  uint32_t NumNodes() const { return replacement_.size(); }
+
+  uint32_t InternString(llvm::StringRef text) {
+    auto inserted = string_ids_.try_emplace(text, strings_.size());
+    if (inserted.second) {
+      strings_.push_back(inserted.first->getKey());
+      node_of_string_.push_back(kNoNode);
+    }
+    return inserted.first->getValue();
+  }
+
+  // Returns the node serialized in `text`, creating it on first use. Nodes are
+  // deduplicated by their replacement; later occurrences don't change the
+  // attributes of the node.
+  uint32_t AddNode(llvm::StringRef text, std::string& error) {
+    // Skip the curly braces denoting the start and end of a serialized node.
+    llvm::StringRef body =
+        text.size() >= 2 ? text.drop_front().drop_back() : llvm::StringRef();
+    llvm::SmallVector<llvm::StringRef, 6> fields;
+    body.split(fields, "\\,");
+    // - is_buffer
+    // - replacement
+    // - include_directive
+    // - size_info_available
+    // - is_deref_node
+    // - is_data_change
+    if (fields.size() != 6) {
+      error = text.str();
+      return kNoNode;
+    }
+
+    uint32_t replacement = InternString(fields[1]);
+    uint32_t& node = node_of_string_[replacement];
+    if (node != kNoNode) {
+      return node;
+    }
+    node = NumNodes();
+    replacement_.push_back(replacement);
+    include_directive_.push_back(InternString(fields[2]));
+    is_buffer_.push_back(fields[0] == "1");
+    size_info_available_.push_back(fields[3] == "1");
+    is_deref_node_.push_back(fields[4] == "1");
+    is_data_change_.push_back(fields[5] == "1");
+    return replacement_.size() - 1;
+  }
+
+  std::string NodeDebugString(uint32_t node) const {
+    return llvm::formatv(
+        "is_buffer:{0:d},replacement:{1},{2},size_info_available:{3:d}"
+        "is_deref_node:{4:d},is_data_change:{5:d}",
+        static_cast<bool>(is_buffer_[node]), strings_[replacement_[node]],
+        strings_[include_directive_[node]],
+        static_cast<bool>(size_info_available_[node]),
+        static_cast<bool>(is_deref_node_[node]),
+        static_cast<bool>(is_data_change_[node]));
+  }
+
+  // Iterative version of SizeInfoAvailable() in extract_edits.py. A node is
+  // given size info if it has neighbors and none of them is known to lack
+  // size info. Nodes on the current path (cycles) don't count as lacking it.
+  void SizeInfoAvailable(uint32_t root) {
+    struct Frame {
+      uint32_t node;
+      uint32_t next;
+      bool available;
+    };
+    std::vector<Frame> stack;
+
+    // Returns the result for `node` if it is known, or starts visiting it.
+    enum Result { kPending, kNo, kYes };
+    auto enter = [&](uint32_t node) {
+      if (size_info_available_[node]) {
+        return kYes;
+      }
+      switch (size_info_step_[node]) {
+        case kVisiting:
+          // Cycle: the size info can't be determined from this path.
+          return kYes;
+        case kVisited:
+          return kNo;
+        case kNotVisited:
+          break;
+      }
+      size_info_step_[node] = kVisiting;
+      stack.push_back({node, neighbors_.Begin(node), false});
+      return kPending;
+    };
+
+    if (enter(root) != kPending) {
+      return;
+    }
+    Result result = kPending;
+    while (!stack.empty()) {
+      Frame& frame = stack.back();
+      if (result == kPending && frame.next < neighbors_.End(frame.node)) {
+        result = enter(neighbors_.targets[frame.next++]);
+        continue;
+      }
+      if (result == kYes) {
+        frame.available = true;
+        result = kPending;
+        continue;
+      }
+      // Either a neighbor lacks size info, or all neighbors were checked.
+      bool available = result == kNo ? false : frame.available;
+      size_info_available_[frame.node] = available;
+      size_info_step_[frame.node] = kVisited;
+      stack.pop_back();
+      result = available ? kYes : kNo;
+    }
+  }
+
+  // Assigns the connected components of the undirected graph. They are
+  // numbered in order of their first node, like the Component objects of
+  // extract_edits.py.
+  void AssignComponents() {
+    uint32_t num_nodes = NumNodes();
+    std::vector<uint32_t> parent(num_nodes);
+    for (uint32_t node = 0; node < num_nodes; ++node) {
+      parent[node] = node;
+    }
+    auto find = [&parent](uint32_t node) {
+      while (parent[node] != node) {
+        parent[node] = parent[parent[node]];
+        node = parent[node];
+      }
+      return node;
+    };
+    for (uint32_t node = 0; node < num_nodes; ++node) {
+      for (uint32_t i = neighbors_.Begin(node); i < neighbors_.End(node); ++i) {
+        uint32_t a = find(node);
+        uint32_t b = find(neighbors_.targets[i]);
+        if (a != b) {
+          parent[std::max(a, b)] = std::min(a, b);
+        }
+      }
+    }
+
+    // Roots are the smallest node of their component, so they are numbered
+    // before any other node of their component is reached.
+    component_.assign(num_nodes, kNoNode);
+    uint32_t num_components = 0;
+    for (uint32_t node = 0; node < num_nodes; ++node) {
+      uint32_t root = find(node);
+      if (component_[root] == kNoNode) {
+        component_[root] = num_components++;
+      }
+      component_[node] = component_[root];
+    }
+    changes_.assign(num_components, {});
+  }
+
+  // Iterative version of DFS() in extract_edits.py.
+  void Visit(uint32_t root) {
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+    auto enter = [&](uint32_t node) {
+      if (visited_[node]) {
+        return;
+      }
+      visited_[node] = true;
+      if (!strings_[replacement_[node]].ends_with("<empty>")) {
+        AddChange(component_[node], replacement_[node]);
+        AddChange(component_[node], include_directive_[node]);
+      }
+      stack.emplace_back(node, neighbors_.Begin(node));
+    };
+
+    enter(root);
+    while (!stack.empty()) {
+      auto& [node, next] = stack.back();
+      if (next == neighbors_.End(node)) {
+        stack.pop_back();
+        continue;
+      }
+      enter(neighbors_.targets[next++]);
+    }
+  }
+
+  void AddChange(uint32_t component, uint32_t text) {
+    if (added_changes_.insert((uint64_t{component} << 32) | text).second) {
+      changes_[component].push_back(text);
+    }
+  }
+
+  // Interned strings (replacements and include directives).
+  llvm::StringMap<uint32_t> string_ids_;
+  std::vector<llvm::StringRef> strings_;
+  // The node whose replacement is a given string, or kNoNode.
+  std::vector<uint32_t> node_of_string_;
+
+  // Node attributes, indexed by node.
+  std::vector<uint32_t> replacement_;
+  std::vector<uint32_t> include_directive_;
+  std::vector<bool> is_buffer_;
+  std::vector<bool> size_info_available_;
+  std::vector<bool> is_deref_node_;
+  std::vector<bool> is_data_change_;
+  std::vector<uint8_t> size_info_step_;
+  std::vector<bool> visited_;
+  std::vector<uint32_t> component_;
+
+  // Directed edges, in input order. Cleared once `neighbors_` is built.
+  std::vector<std::pair<uint32_t, uint32_t>> edges_;
+  Csr neighbors_;
+
+  // Changes of each component, and the (component, text) pairs already added.
+  std::vector<std::vector<uint32_t>> changes_;
+  llvm::DenseSet<uint64_t> added_changes_;
+};
+
+// Reads `input` line by line, treating "\n", "\r\n" and "\r" as line ends
+// like Python's universal newlines mode does.
+template <typename Callback>
+bool ForEachLine(std::istream& input, Callback callback) {
+  std::string line;
+  while (std::getline(input, line)) {
+    llvm::StringRef rest(line);
+    while (true) {
+      auto [text, after] = rest.split('\r');
+      if (!callback(text)) {
+        return false;
+      }
+      // A trailing '\r' only ends `text`; it doesn't start another line.
+      if (after.empty()) {
+        break;
+      }
+      rest = after;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  llvm::cl::opt<bool> binary_edits(
+      "binary-edits", llvm::cl::init(false),
+      llvm::cl::desc("Write the edits in the compact binary format understood "
+                     "by apply_edits.py"));
+  llvm::cl::ParseCommandLineOptions(
+      argc, argv,
+      "Extracts edits from the output of the spanify tool, like "
+      "extract_edits.py.\n");
+  std::ios::sync_with_stdio(false);
+
+  Graph graph;
+  std::string error;
+  if (!ForEachLine(std::cin, [&](llvm::StringRef line) {
+        return graph.AddLine(line, error);
+      }) ||
+      !graph.Solve(error)) {
+    llvm::errs() << "error: " << error << "\n";
+    return 1;
+  }
+
+  llvm::SmallString<128> scratch_dir;
+  if (!llvm::sys::path::home_directory(scratch_dir)) {
+    llvm::errs() << "error: can't find the home directory\n";
+    return 1;
+  }
+  llvm::sys::path::append(scratch_dir, "scratch");
+  raw_ptr_plugin::BinaryEditsWriter binary_edits_writer;
+  if (!graph.Emit(llvm::outs(), binary_edits ? &binary_edits_writer : nullptr,
+                  scratch_dir, error)) {
+    llvm::errs() << "error: " << error << "\n";
+    return 1;
+  }
+  if (binary_edits) {
+    binary_edits_writer.EmitStream(llvm::outs());
+  }
+  return 0;
+}
@@ -11,6 +11,8 @@
 #include <string>
 #include <vector>
 
+#include "BatchMode.h"
+#include "PrefixHeaderPch.h"
 #include "RawPtrHelpers.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
@@ -21,6 +23,7 @@
 #include "clang/Tooling/Refactoring.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace clang::ast_matchers;
 
@@ -123,6 +126,7 @@ class OutputHelper {
     for (const auto& p : node_pairs_) {
       llvm::outs() << p;
     }
+    node_pairs_.clear();
   }
 
  private:
@@ -1489,12 +1493,37 @@ int main(int argc, const char* argv[]) {
       "spanifier: changes"
       " 1- |T* var| to |base::span<T> var|."
       " 2- |raw_ptr<T> var| to |base::raw_span<T> var|");
+  llvm::cl::opt<bool> batch(
+      "batch", llvm::cl::init(false),
+      llvm::cl::desc("Read compile commands from stdin and process them in "
+                     "this process (used by run_tool.py --batch)"));
+  llvm::cl::opt<std::string> inputs_file(
+      "inputs-file", llvm::cl::value_desc("filepath"),
+      llvm::cl::desc("file to write the list of files read by the translation "
+                     "unit to (used by run_tool.py --cache-dir)"));
+  raw_ptr_plugin::PrefixHeaderPch::Options prefix_header_options(category);
 
   llvm::Expected<clang::tooling::CommonOptionsParser> options =
-      clang::tooling::CommonOptionsParser::create(argc, argv, category);
+      clang::tooling::CommonOptionsParser::create(
+          argc, argv, category,
+          // Batch mode reads the source paths from stdin instead.
+          llvm::cl::ZeroOrMore);
   assert(static_cast<bool>(options));  // Should not return an error.
+  if (!batch && options->getSourcePathList().empty()) {
+    llvm::errs() << "No source files given; pass at least one source path, "
+                    "or use --batch.\n";
+    return 1;
+  }
   clang::tooling::ClangTool tool(options->getCompilations(),
                                  options->getSourcePathList());
+  std::unique_ptr<raw_ptr_plugin::PrefixHeaderPch> prefix_header_pch =
+      raw_ptr_plugin::PrefixHeaderPch::Create(prefix_header_options);
+  if (prefix_header_pch) {
+    tool.appendArgumentsAdjuster(prefix_header_pch->GetArgumentsAdjuster());
+  }
+  if (!inputs_file.empty()) {
+    raw_ptr_plugin::ReportToolInputs(tool, inputs_file);
+  }
 
   // Map a function signature, which is modeled as a string representing file
   // location, to it's graph nodes (RTNode and ParmVarDecl nodes).
@@ -1508,41 +1537,52 @@ int main(int argc, const char* argv[]) {
   Spanifier rewriter(match_finder, output_helper, fct_sig_nodes, fct_sig_pairs);
   rewriter.addMatchers();
 
-  // Prepare and run the tool.
-  std::unique_ptr<clang::tooling::FrontendActionFactory> factory =
-      clang::tooling::newFrontendActionFactory(&match_finder);
-  int result = tool.run(factory.get());
+  // Establishes connections between corresponding parameters of adjacent
+  // function signatures, then emits the edges gathered so far. Two functions
+  // are considered adjacent if one overrides the other or if one is a function
+  // declaration while the other is its corresponding definition.
+  auto emit_graph = [&] {
+    for (auto& [l, r] : fct_sig_pairs) {
+      // By construction, only the left side of the pair is guaranteed to have
+      // a matching set of nodes.
+      assert(fct_sig_nodes.find(l) != fct_sig_nodes.end());
+
+      // TODO(356666773): Handle the case where both side of the pair haven't
+      // been matched. This happens when a function is declared in
+      // third_party/, but implemented in first party.
+      if (fct_sig_nodes.find(r) == fct_sig_nodes.end()) {
+        continue;
+      }
 
-  // Establish connections between corresponding parameters of adjacent function
-  // signatures. Two functions are considered adjacent if one overrides the
-  // other or if one is a function declaration while the other is its
-  // corresponding definition.
-  for (auto& [l, r] : fct_sig_pairs) {
-    // By construction, only the left side of the pair is guaranteed to have a
-    // matching set of nodes.
-    assert(fct_sig_nodes.find(l) != fct_sig_nodes.end());
-
-    // TODO(356666773): Handle the case where both side of the pair haven't
-    // been matched. This happens when a function is declared in third_party/,
-    // but implemented in first party.
-    if (fct_sig_nodes.find(r) == fct_sig_nodes.end()) {
-      continue;
+      auto& s1 = fct_sig_nodes[l];
+      auto& s2 = fct_sig_nodes[r];
+      assert(s1.size() == s2.size());
+      auto i1 = s1.begin();
+      auto i2 = s2.begin();
+      while (i1 != s1.end()) {
+        output_helper.AddEdge(*i1, *i2);
+        output_helper.AddEdge(*i2, *i1);
+        i1++;
+        i2++;
+      }
     }
 
-    auto& s1 = fct_sig_nodes[l];
-    auto& s2 = fct_sig_nodes[r];
-    assert(s1.size() == s2.size());
-    auto i1 = s1.begin();
-    auto i2 = s2.begin();
-    while (i1 != s1.end()) {
-      output_helper.AddEdge(*i1, *i2);
-      output_helper.AddEdge(*i2, *i1);
-      i1++;
-      i2++;
-    }
-  }
+    // Emits the list of edges.
+    output_helper.Emit();
 
-  // Emits the list of edges.
-  output_helper.Emit();
+    // In batch mode, the next translation unit starts from an empty graph.
+    fct_sig_nodes.clear();
+    fct_sig_pairs.clear();
+  };
+
+  // Prepare and run the tool.
+  std::unique_ptr<clang::tooling::FrontendActionFactory> factory =
+      clang::tooling::newFrontendActionFactory(&match_finder);
+  if (batch) {
+    return raw_ptr_plugin::RunToolInBatchMode(factory.get(), emit_graph,
+                                              prefix_header_pch.get());
+  }
+  int result = tool.run(factory.get());
+  emit_graph();
   return result;
 }
@@ -41,6 +41,10 @@ extract_edits.py would then emit the following output:
     ...
 Where the edit is either a replacement or an include directive.
 
+spanify_extract_edits (ExtractEdits.cpp) is a native implementation of this
+script for large inputs. Its output must stay identical, so changes to the
+logic here need to be mirrored there.
+
 For more details about how the tool works, see the doc here:
 https://docs.google.com/document/d/1hUPe21CDdbT6_YFHl03KWlcZqhNIPBAfC-5N5DDY2OE/
 """
@@ -54,14 +58,15 @@ from os.path import expanduser
 # The connected components in the graph. This is useful to split the rewrite
 # into atomic changes.
 class Component:
-    all = set()
+    # In creation order, so that the output doesn't depend on object hashes.
+    all = list()
 
     def __init__(self) -> None:
         # Changes associated with the connected component.
         self.changes = set()
 
         # `Component.all` can be used to iterate over all components.
-        Component.all.add(self)
+        Component.all.append(self)
 
 
 class Node:
@@ -80,8 +85,10 @@ class Node:
         self.is_data_change = is_data_change
 
         # Neighbors of the node in the graph. The graph is directed,
-        # flowing from lhs to rhs.
-        self.neighbors_directed = set()
+        # flowing from lhs to rhs. This is a dict used as an ordered set: the
+        # traversal order affects SizeInfoAvailable(...) on cycles, and must
+        # not depend on string hashes for the output to be reproducible.
+        self.neighbors_directed = dict()
         self.neighbors_undirected = set()
 
         # Property to tracker whether the node is "connected" to a buffer node.
@@ -260,7 +267,7 @@ def main():
         rhs = Node.from_string(nodes[1])
 
         # Directed edge:
-        lhs.neighbors_directed.add(rhs)
+        lhs.neighbors_directed[rhs] = None
 
         # Undirected edge:
         lhs.neighbors_undirected.add(rhs)
@@ -380,13 +387,14 @@ def main():
     ]
 
     for index, component in enumerate(component_with_changes):
-        for text in component.changes:
+        changes = sorted(component.changes)
+        for text in changes:
             print(text)
 
-        summary_file.write(f'patch_{index}: {len(component.changes)}\n')
+        summary_file.write(f'patch_{index}: {len(changes)}\n')
 
         with open(expanduser(f'~/scratch/patch_{index}.txt'), 'w') as f:
-            f.write('\n'.join(component.changes))
+            f.write('\n'.join(changes))
 
     summary_file.close()
 
@@ -293,9 +293,17 @@ then
   echo "*** Clearing test patches ***"
   rm ~/scratch/patch*
 
+  # Prefer the native implementation of extract_edits.py when it was built
+  # along with the rewriter. Both produce the same edits.
+  EXTRACT_EDITS_TOOL=third_party/llvm-build/Release+Asserts/bin/spanify_extract_edits
+  if [ ! -x "$EXTRACT_EDITS_TOOL" ]
+  then
+    EXTRACT_EDITS_TOOL=tools/clang/spanify/extract_edits.py
+  fi
+
   echo "*** Applying edits ***"
   cat ~/scratch/rewriter.main.out | \
-      tools/clang/spanify/extract_edits.py | \
+      $EXTRACT_EDITS_TOOL | \
       tools/clang/scripts/apply_edits.py -p $OUT_DIR $EDIT_DIRS
 else
   echo "*** Skipping edits ***"
@@ -0,0 +1,148 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures the collector's throughput and pause times on the shapes of the
+// relocate_* tests, on deeper call stacks with a root in every frame, and on
+// a mutator which allocates until the heap fills up and collections are
+// triggered by the allocator.
+//
+// Like the tests, this must be built with the IdentifySafepoints and
+// RegisterGcFunctions passes; see run_benchmark.py. Functions with handles
+// are noinline, because safepoints are identified before inlining.
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "objects.h"
+#include "tests.h"
+
+extern Handle<HeapObject> AllocateHeapObject(long data);
+
+// A small heap, so that the allocation benchmark collects often.
+constexpr size_t kSemispaceSize = 256 * 1024;
+constexpr long kExpected = 1234;
+
+// Shape of relocate_single_fn: a root in the frame that calls GC().
+__attribute__((noinline)) void SingleFn() {
+  auto handle = AllocateHeapObject(kExpected);
+  GC();
+  assert((*handle).data == kExpected &&
+         "GC Objects differ across a collection");
+}
+
+// Shape of relocate_across_fns: a root passed down through several frames.
+__attribute__((noinline)) Handle<HeapObject> AcrossFnsBar(
+    Handle<HeapObject> x) {
+  GC();
+  assert((*x).data == kExpected && "GC Objects differ across a collection");
+  return x;
+}
+
+__attribute__((noinline)) Handle<HeapObject> AcrossFnsFoo(
+    Handle<HeapObject> x) {
+  return AcrossFnsBar(x);
+}
+
+__attribute__((noinline)) Handle<HeapObject> AcrossFnsBaz(
+    Handle<HeapObject> x) {
+  return AcrossFnsFoo(x);
+}
+
+__attribute__((noinline)) void AcrossFns() {
+  auto handle = AllocateHeapObject(kExpected);
+  AcrossFnsBaz(handle);
+  assert((*handle).data == kExpected &&
+         "GC Objects differ across a collection");
+}
+
+// A call stack |depth| frames deep, with a different root in every frame.
+__attribute__((noinline)) void Descend(long depth) {
+  auto handle = AllocateHeapObject(depth);
+  if (depth == 0)
+    GC();
+  else
+    Descend(depth - 1);
+  assert((*handle).data == depth && "GC Objects differ across a collection");
+}
+
+__attribute__((noinline)) void Stack16() {
+  Descend(16);
+}
+
+__attribute__((noinline)) void Stack256() {
+  Descend(256);
+}
+
+// A root to a chain of objects, which are only reachable through each other.
+__attribute__((noinline)) void Chain() {
+  constexpr size_t kLength = 1000;
+  auto handle = AllocateHeapObjectChain(kExpected, kLength);
+  uint64_t copied = GetGCStats().objects_copied;
+  GC();
+  assert(GetGCStats().objects_copied - copied == kLength &&
+         "Collector did not copy the whole chain");
+  assert((*handle).data == kExpected &&
+         "GC Objects differ across a collection");
+}
+
+// Allocates garbage while holding a few roots, so that the allocator collects
+// whenever the heap is full.
+__attribute__((noinline)) void Allocate() {
+  auto a = AllocateHeapObject(1);
+  auto b = AllocateHeapObject(2);
+  for (long i = 0; i < 100000; i++)
+    AllocateHeapObject(i);
+  assert((*a).data == 1 && (*b).data == 2 &&
+         "GC Objects differ across a collection");
+}
+
+// Runs |shape| |iterations| times and prints the collector's statistics.
+void Run(const char* name, void (*shape)(), int iterations) {
+  ResetGCStats();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++)
+    shape();
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  GCStats stats = GetGCStats();
+  if (stats.pause_ns.empty()) {
+    printf("%-12s no collections\n", name);
+    return;
+  }
+  std::sort(stats.pause_ns.begin(), stats.pause_ns.end());
+  // In microseconds.
+  auto percentile = [&](double p) {
+    size_t index = static_cast<size_t>(p * (stats.pause_ns.size() - 1));
+    return stats.pause_ns[index] / 1000.0;
+  };
+  printf("%-12s %8lu %12.0f %10.2f %10.2f %10.2f %12.1f\n", name,
+         static_cast<unsigned long>(stats.collections),
+         stats.collections / seconds, percentile(0.5), percentile(0.99),
+         percentile(1.0), stats.bytes_allocated / seconds / (1024 * 1024));
+}
+
+int main(int argc, char** argv) {
+  int scale = argc > 1 ? atoi(argv[1]) : 1;
+
+  InitGC(kSemispaceSize);
+  SetGCVerbose(false);
+
+  printf("%-12s %8s %12s %10s %10s %10s %12s\n", "shape", "GCs", "GCs/s",
+         "p50 us", "p99 us", "max us", "alloc MB/s");
+  Run("single_fn", SingleFn, 10000 * scale);
+  Run("across_fns", AcrossFns, 10000 * scale);
+  Run("stack_16", Stack16, 10000 * scale);
+  Run("stack_256", Stack256, 1000 * scale);
+  Run("chain_1000", Chain, 1000 * scale);
+  Run("allocate", Allocate, 10 * scale);
+
+  TeardownGC();
+  return 0;
+}
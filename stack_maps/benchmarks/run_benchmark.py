@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+# Copyright 2026 The Chromium Authors
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+"""Builds gc_benchmark.cpp like the stack map tests, and runs it."""
+
+import argparse
+import importlib.util
+import os
+import subprocess
+import sys
+
+script_dir = os.path.dirname(os.path.realpath(__file__))
+
+
+def load_test_module():
+  # tests/test.py is not in a package, and its name clashes with the standard
+  # library's test package, so it is loaded from its path.
+  spec = importlib.util.spec_from_file_location(
+      'stack_map_test', os.path.join(script_dir, '..', 'tests', 'test.py'))
+  module = importlib.util.module_from_spec(spec)
+  spec.loader.exec_module(module)
+  return module
+
+
+def main():
+  parser = argparse.ArgumentParser()
+  parser.add_argument('llvm_bin_path',
+                      help='The path to the llvm tools bin dir.')
+  parser.add_argument('libgc_path', help='The path to the runtime gc library.')
+  parser.add_argument('identify_safepoints_path',
+                      help='The path to the identify safepoints IR pass.')
+  parser.add_argument('reg_gc_fns_path',
+                      help='The path to the register GC functions IR pass.')
+  parser.add_argument('--scale',
+                      type=int,
+                      default=1,
+                      help='Multiplies the number of iterations of each '
+                      'benchmark.')
+  args = parser.parse_args()
+
+  test = load_test_module().StackMapTest(script_dir, args.llvm_bin_path,
+                                         os.path.abspath(args.libgc_path),
+                                         os.path.abspath(
+                                             args.identify_safepoints_path),
+                                         os.path.abspath(args.reg_gc_fns_path))
+  test._out_dir = os.path.join(script_dir, 'out')
+  os.makedirs(test._out_dir, exist_ok=True)
+
+  # The commands are relative to the benchmark's directory, like the tests'.
+  os.chdir(script_dir)
+  cmds = test.build_commands('gc_benchmark')
+  for cmd in cmds[:-1]:
+    subprocess.check_call(cmd)
+  return subprocess.call(cmds[-1] + [str(args.scale)])
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -4,37 +4,108 @@
 
 #include "gc_api.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+
+#include "tests.h"
+
+// The default size of each semispace, in bytes.
+constexpr size_t kDefaultSemispaceSize = 1 << 20;
+
+// In debug builds, fromspace is filled with this after a collection, so that a
+// root which was not relocated reads garbage rather than the stale object.
+constexpr uintptr_t kZapValue = 0xdeaddeaddeaddead;
+
 SafepointTable spt = GenSafepointTable();
 Heap* heap = nullptr;
+bool gc_verbose = true;
+
+Heap::Heap(size_t semispace_size)
+    : semispace_words_(semispace_size / sizeof(uintptr_t)),
+      a_frag_(new uintptr_t[semispace_words_]),
+      b_frag_(new uintptr_t[semispace_words_]),
+      fromspace_(a_frag_.get()),
+      tospace_(b_frag_.get()) {}
 
-HeapAddress Heap::AllocRaw(long value) {
-  assert(heap_ptr < kHeapSize && "Allocation failed: Heap full");
+HeapAddress Heap::AllocRaw(long value, size_t num_refs) {
+  if (!CanAlloc(1, num_refs))
+    return nullptr;
 
-  HeapAddress raw_ptr = &fromspace()[heap_ptr];
-  *raw_ptr = value;
-  heap_ptr++;
-  return raw_ptr;
+  uintptr_t* obj = &fromspace_[alloc_words_];
+  alloc_words_ += ObjectWords(num_refs);
+  obj[0] = num_refs << 1;
+  obj[1] = value;
+  std::fill(obj + 2, obj + ObjectWords(num_refs), 0);
+  stats_.bytes_allocated += ObjectWords(num_refs) * sizeof(uintptr_t);
+  return reinterpret_cast<HeapAddress>(obj + 1);
 }
 
-void Heap::MoveObjects() {
-  for (int i = 0; i < kHeapSize; i++) {
-    auto tmp = a_frag_[i];
-    a_frag_[i] = b_frag_[i];
-    b_frag_[i] = tmp;
-  }
-  alloc_on_a_ = !alloc_on_a_;
+bool Heap::CanAlloc(size_t num_objects, size_t num_refs) const {
+  return num_objects * ObjectWords(num_refs) <=
+         semispace_words_ - alloc_words_;
+}
+
+void Heap::SetRef(HeapAddress obj, size_t index, HeapAddress value) {
+  auto* data = reinterpret_cast<uintptr_t*>(obj);
+  assert(index < (data[-1] >> 1) && "Reference slot out of bounds");
+  data[1 + index] = reinterpret_cast<uintptr_t>(value);
+}
+
+uintptr_t* Heap::Evacuate(uintptr_t* data) {
+  if (!InFromspace(data))
+    return data;
+
+  uintptr_t* header = data - 1;
+  if (*header & kForwardedBit)
+    return reinterpret_cast<uintptr_t*>(*header & ~kForwardedBit);
+
+  // Tospace is as large as fromspace and each object is copied at most once,
+  // so this cannot overflow.
+  size_t size = ObjectWords(*header >> 1);
+  uintptr_t* copy = &tospace_[copy_words_];
+  copy_words_ += size;
+  std::copy(header, header + size, copy);
+  *header = reinterpret_cast<uintptr_t>(copy + 1) | kForwardedBit;
+
+  stats_.objects_copied++;
+  stats_.bytes_copied += size * sizeof(uintptr_t);
+  return copy + 1;
 }
 
 HeapAddress Heap::UpdatePointer(HeapAddress ptr) {
-  int offset =
-      reinterpret_cast<char*>(ptr) - reinterpret_cast<char*>(fromspace());
-  auto* new_ptr = reinterpret_cast<char*>(tospace()) + offset;
-  return reinterpret_cast<HeapAddress>(new_ptr);
+  return reinterpret_cast<HeapAddress>(
+      Evacuate(reinterpret_cast<uintptr_t*>(ptr)));
+}
+
+void Heap::MoveObjects() {
+  // Cheney's algorithm: tospace is the queue of objects whose reference slots
+  // have yet to be updated. Evacuating the objects they refer to appends those
+  // to the queue, until every reachable object has been copied.
+  size_t scan = 0;
+  while (scan < copy_words_) {
+    uintptr_t* obj = &tospace_[scan];
+    size_t num_refs = obj[0] >> 1;
+    for (size_t i = 0; i < num_refs; i++) {
+      obj[2 + i] = reinterpret_cast<uintptr_t>(
+          Evacuate(reinterpret_cast<uintptr_t*>(obj[2 + i])));
+    }
+    scan += ObjectWords(num_refs);
+  }
+
+#ifndef NDEBUG
+  std::fill(fromspace_, fromspace_ + alloc_words_, kZapValue);
+#endif
+
+  std::swap(fromspace_, tospace_);
+  alloc_words_ = copy_words_;
+  copy_words_ = 0;
 }
 
 void FrameRoots::Print() const {
   printf("\tRegister Roots: NYI\n");
-  if (!stack_roots_.size()) {
+  if (stack_roots_.empty()) {
     printf("\tStack Roots: []\n");
     return;
   }
@@ -46,15 +117,53 @@ void FrameRoots::Print() const {
   printf("\b\b]\n");
 }
 
+SafepointTable::SafepointTable(std::vector<Safepoint> safepoints,
+                               std::vector<DWARF> reg_root_pool,
+                               std::vector<RBPOffset> stack_root_pool)
+    : reg_root_pool_(std::move(reg_root_pool)),
+      stack_root_pool_(std::move(stack_root_pool)) {
+  std::stable_sort(safepoints.begin(), safepoints.end(),
+                   [](const Safepoint& a, const Safepoint& b) {
+                     return a.ra < b.ra;
+                   });
+  safepoints.erase(std::unique(safepoints.begin(), safepoints.end(),
+                               [](const Safepoint& a, const Safepoint& b) {
+                                 return a.ra == b.ra;
+                               }),
+                   safepoints.end());
+  addresses_.reserve(safepoints.size());
+  for (const Safepoint& safepoint : safepoints)
+    addresses_.push_back(safepoint.ra);
+  safepoints_ = std::move(safepoints);
+}
+
+FrameRoots SafepointTable::Find(ReturnAddress ra) const {
+  auto it = std::lower_bound(addresses_.begin(), addresses_.end(), ra);
+  if (it == addresses_.end() || *it != ra)
+    return FrameRoots();
+  return GetRoots(safepoints_[it - addresses_.begin()]);
+}
+
+FrameRoots SafepointTable::GetRoots(const Safepoint& safepoint) const {
+  return FrameRoots(
+      FrameRoots::Range<DWARF>(
+          reg_root_pool_.data() + safepoint.reg_roots_begin,
+          safepoint.num_reg_roots),
+      FrameRoots::Range<RBPOffset>(
+          stack_root_pool_.data() + safepoint.stack_roots_begin,
+          safepoint.num_stack_roots));
+}
+
 void SafepointTable::Print() const {
   printf("Safepoint Table\n");
-  for (auto const& pair : roots_) {
-    printf("Frame %p\n", reinterpret_cast<void*>(pair.first));
-    pair.second.Print();
+  for (const Safepoint& safepoint : safepoints_) {
+    printf("Frame %p\n", reinterpret_cast<void*>(safepoint.ra));
+    GetRoots(safepoint).Print();
   }
 }
 
 extern "C" void StackWalkAndMoveObjects(FramePtr fp) {
+  auto start = std::chrono::steady_clock::now();
   while (true) {
     // The caller's return address is always 1 machine word above the recorded
     // RBP value in the current frame
@@ -65,47 +174,93 @@ extern "C" void StackWalkAndMoveObjects(FramePtr fp) {
     if (reinterpret_cast<uintptr_t>(fp) == TopOfStack)
       break;
 
-    printf("==== Frame %p ====\n", reinterpret_cast<void*>(ra));
+    if (gc_verbose)
+      printf("==== Frame %p ====\n", reinterpret_cast<void*>(ra));
 
-    auto it = spt.roots()->find(ra);
-    if (it != spt.roots()->end()) {
-      auto fr_roots = it->second;
-      for (auto root : *fr_roots.stack_roots()) {
+    FrameRoots fr_roots = spt.Find(ra);
+    if (!fr_roots.empty()) {
+      for (auto root : fr_roots.stack_roots()) {
         auto offset = root / sizeof(uintptr_t);
         auto stack_address = reinterpret_cast<uintptr_t*>((fp - offset));
 
-        printf("\tRoot: [RBP - %d]\n", root);
-        printf("\tAddress: %p\n", reinterpret_cast<void*>(*stack_address));
+        if (gc_verbose) {
+          printf("\tRoot: [RBP - %d]\n", root);
+          printf("\tAddress: %p\n", reinterpret_cast<void*>(*stack_address));
 
-        // We know that all HeapObjects are wrappers around a single long
-        // integer, so for debugging purposes we can cast it as such and print
-        // the value to see if it looks correct.
-        printf("\tValue: %ld\n",
-               reinterpret_cast<HeapObject*>(*stack_address)->data);
+          // We know that all HeapObjects start with a long integer, so for
+          // debugging purposes we can cast it as such and print the value to
+          // see if it looks correct.
+          printf("\tValue: %ld\n",
+                 reinterpret_cast<HeapObject*>(*stack_address)->data);
+        }
 
         // We are in a collection, so we know that the underlying objects will
-        // be moved before we return to the mutator. We update the on-stack
-        // pointers here to point to the object's new location in the heap.
+        // be moved before we return to the mutator. We copy the object and
+        // update the on-stack pointers here to point to its new location in
+        // the heap.
         HeapAddress new_ptr =
             heap->UpdatePointer(reinterpret_cast<HeapAddress>(*stack_address));
         *stack_address = reinterpret_cast<uintptr_t>(new_ptr);
 
-        printf("\tAddress after Relocation: %p\n",
-               reinterpret_cast<void*>(*stack_address));
+        if (gc_verbose) {
+          printf("\tAddress after Relocation: %p\n",
+                 reinterpret_cast<void*>(*stack_address));
+        }
       }
     }
   }
   heap->MoveObjects();
+
+  GCStats* stats = heap->stats();
+  stats->collections++;
+  stats->pause_ns.push_back(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count());
+}
+
+// Makes room in fromspace for |num_objects| objects with |num_refs| reference
+// slots each, collecting if needed.
+static void EnsureCanAlloc(size_t num_objects, size_t num_refs) {
+  if (heap->CanAlloc(num_objects, num_refs))
+    return;
+  GC();
+  if (!heap->CanAlloc(num_objects, num_refs)) {
+    fprintf(stderr, "Allocation failed: Heap full\n");
+    abort();
+  }
 }
 
 Handle<HeapObject> AllocateHeapObject(long data) {
+  EnsureCanAlloc(1, 0);
   HeapAddress ptr = heap->AllocRaw(data);
   return Handle<HeapObject>::New(reinterpret_cast<HeapObject*>(ptr));
 }
 
+Handle<HeapObject> AllocateHeapObjectChain(long data, size_t length) {
+  assert(length > 0);
+  // Nothing here is in a stack map, so the whole chain is allocated without
+  // collecting in between.
+  EnsureCanAlloc(length, 1);
+  HeapAddress next = nullptr;
+  for (size_t i = 0; i < length; i++) {
+    HeapAddress ptr = heap->AllocRaw(data, 1);
+    heap->SetRef(ptr, 0, next);
+    next = ptr;
+  }
+  return Handle<HeapObject>::New(reinterpret_cast<HeapObject*>(next));
+}
+
+void InitGC(size_t semispace_size) {
+  InitTopOfStack();
+  heap = new Heap(semispace_size);
+}
+
+// InitTopOfStack() must be called directly from InitGC(), so this does not
+// forward to InitGC(size_t).
 void InitGC() {
   InitTopOfStack();
-  heap = new Heap();
+  heap = new Heap(kDefaultSemispaceSize);
 }
 
 void TeardownGC() {
@@ -115,3 +270,15 @@ void TeardownGC() {
 void PrintSafepointTable() {
   spt.Print();
 }
+
+void SetGCVerbose(bool verbose) {
+  gc_verbose = verbose;
+}
+
+const GCStats& GetGCStats() {
+  return *heap->stats();
+}
+
+void ResetGCStats() {
+  *heap->stats() = GCStats();
+}
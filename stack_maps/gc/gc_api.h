@@ -6,9 +6,11 @@
 #define TOOLS_CLANG_STACK_MAPS_GC_GC_API_H_
 
 #include <assert.h>
-#include <map>
+#include <stddef.h>
+#include <memory>
 #include <vector>
 
+#include "gc_stats.h"
 #include "objects.h"
 
 using ReturnAddress = uint64_t;
@@ -18,57 +20,78 @@ using DWARF = uint16_t;
 
 using HeapAddress = long*;
 
-// The place where HeapObjects live. For simplicity, the underlying data in a
-// HeapObject is always a single uintptr_t. The heap layout mocks a simple
-// semi-space collector where objects can be moved between two heap fragments.
+// The place where HeapObjects live. This is a semispace copying collector
+// using Cheney's algorithm: objects are bump allocated in fromspace, and a
+// collection copies the objects reachable from the roots found by the stack
+// walk into tospace, then swaps the two spaces. Unreachable objects are
+// reclaimed by not being copied.
 //
-// Note that this is a no-op collector: unreachable objects are not reclaimed
-// and allocation will keep filling the heap until its limited memory is
-// exhausted.
+// Each object is a header word followed by the HeapObject's data word and then
+// the object's reference slots, which are each null or point to another
+// object. Handles and references point to the data word, so the header is one
+// word before it. The header holds the number of reference slots, until the
+// object is copied, when it is overwritten with a forwarding pointer to the
+// copy. The low bit tells the two apart.
 class Heap {
  public:
-  // Allocates a HeapObject's underlying data field on the heap and returns a
-  // pointer to it. This allocation will use the heap fragment returned from a
-  // fromspace() call.
-  HeapAddress AllocRaw(long value);
-
-  // Moves all values from fromspace to tospace. fromspace becomes tospace and
-  // vice versa (i.e. future allocations take place on the opposite heap
-  // fragment). Note no objects are dropped in the process.
-  void MoveObjects();
+  // Creates a heap with two semispaces of |semispace_size| bytes each.
+  explicit Heap(size_t semispace_size);
+
+  Heap(const Heap&) = delete;
+  Heap& operator=(const Heap&) = delete;
+
+  // Allocates an object with |num_refs| null reference slots in fromspace,
+  // and returns a pointer to its data word, initialised to |value|. Returns
+  // nullptr if fromspace is full.
+  HeapAddress AllocRaw(long value, size_t num_refs = 0);
+
+  // Returns whether |num_objects| objects with |num_refs| reference slots each
+  // fit in the rest of fromspace.
+  bool CanAlloc(size_t num_objects, size_t num_refs) const;
 
-  // For an arbitrary pointer into the heap, this will return a new pointer with
-  // a corresponding offset into the opposite heap fragment. E.g. a pointer to
-  // an address at offset +4 into heap fragment A would return an address at
-  // offset +4 into heap fragment B.
+  // Sets the reference slot |index| of the object |obj| to |value|.
+  void SetRef(HeapAddress obj, size_t index, HeapAddress value);
+
+  // For a root pointing to an object in fromspace, copies the object into
+  // tospace, unless it was already copied, and returns the address of the
+  // copy. Other pointers, such as null, are returned unchanged.
   //
-  // This is used for relocating root pointer values across a collection during
-  // stack walking.
+  // This is used for relocating root pointer values during stack walking. The
+  // objects they refer to are only copied by the following MoveObjects().
   HeapAddress UpdatePointer(HeapAddress ptr);
 
+  // Completes a collection: copies every object reachable from the objects
+  // copied by UpdatePointer() into tospace, updating reference slots as it
+  // goes, then makes tospace the new fromspace (i.e. future allocations take
+  // place on the opposite heap fragment).
+  void MoveObjects();
+
+  GCStats* stats() { return &stats_; }
+
  private:
-  static constexpr int kHeapSize = 24;
-
-  HeapAddress fromspace() {
-    if (alloc_on_a_) {
-      return a_frag_;
-    } else {
-      return b_frag_;
-    }
-  }
+  static constexpr uintptr_t kForwardedBit = 1;
 
-  HeapAddress tospace() {
-    if (alloc_on_a_) {
-      return b_frag_;
-    } else {
-      return a_frag_;
-    }
+  // The size of an object in words, including its header.
+  static size_t ObjectWords(size_t num_refs) { return 2 + num_refs; }
+
+  bool InFromspace(const uintptr_t* ptr) const {
+    return ptr >= fromspace_ && ptr < fromspace_ + alloc_words_;
   }
 
-  int heap_ptr = 0;
-  long a_frag_[kHeapSize];
-  long b_frag_[kHeapSize];
-  bool alloc_on_a_ = true;
+  // Copies the object whose data word is at |data| into tospace if it is in
+  // fromspace, and returns its new address.
+  uintptr_t* Evacuate(uintptr_t* data);
+
+  const size_t semispace_words_;
+  std::unique_ptr<uintptr_t[]> a_frag_;
+  std::unique_ptr<uintptr_t[]> b_frag_;
+  uintptr_t* fromspace_;
+  uintptr_t* tospace_;
+  // The number of words allocated in fromspace, and copied into tospace
+  // during a collection.
+  size_t alloc_words_ = 0;
+  size_t copy_words_ = 0;
+  GCStats stats_;
 };
 
 // A FrameRoots object contains all the information needed to precisely identify
@@ -85,39 +108,85 @@ class Heap {
 // DWARF Register number mapping can be found here:
 // Pg.63
 // https://software.intel.com/sites/default/files/article/402129/mpx-linux64-abi.pdf
+//
+// A FrameRoots is a view of the lists in a SafepointTable's pools, so it is
+// cheap to copy.
 class FrameRoots {
  public:
-  FrameRoots(std::vector<DWARF> reg_roots, std::vector<RBPOffset> stack_roots)
+  template <typename T>
+  class Range {
+   public:
+    Range(const T* begin, size_t size) : begin_(begin), end_(begin + size) {}
+
+    const T* begin() const { return begin_; }
+    const T* end() const { return end_; }
+    size_t size() const { return end_ - begin_; }
+    bool empty() const { return begin_ == end_; }
+
+   private:
+    const T* begin_;
+    const T* end_;
+  };
+
+  FrameRoots() : reg_roots_(nullptr, 0), stack_roots_(nullptr, 0) {}
+  FrameRoots(Range<DWARF> reg_roots, Range<RBPOffset> stack_roots)
       : reg_roots_(reg_roots), stack_roots_(stack_roots) {}
 
-  const std::vector<DWARF>* reg_roots() { return &reg_roots_; }
-  const std::vector<RBPOffset>* stack_roots() { return &stack_roots_; }
+  Range<DWARF> reg_roots() const { return reg_roots_; }
+  Range<RBPOffset> stack_roots() const { return stack_roots_; }
 
-  bool empty() { return reg_roots_.empty() && stack_roots_.empty(); }
+  bool empty() const { return reg_roots_.empty() && stack_roots_.empty(); }
 
   void Print() const;
 
  private:
-  std::vector<DWARF> reg_roots_;
-  std::vector<RBPOffset> stack_roots_;
+  Range<DWARF> reg_roots_;
+  Range<RBPOffset> stack_roots_;
 };
 
 // A SafepointTable provides a runtime mapping of function return addresses to
 // on-stack and in-register gc root locations. Return addresses are used as a
-// function call site is the only place where safepoints can exist. This map is
-// a convenient format for the collector to use while walking a call stack
-// looking for the rootset.
+// function call site is the only place where safepoints can exist.
+//
+// The table is built once at startup and looked up for every frame of every
+// stack walk, so it is laid out for lookups: a sorted array of return
+// addresses, binary searched, and a parallel array of safepoints whose roots
+// are ranges of two pools shared by all safepoints. A lookup neither allocates
+// nor copies the roots.
 class SafepointTable {
  public:
-  SafepointTable(std::map<ReturnAddress, FrameRoots> roots)
-      : roots_(std::move(roots)) {}
-
-  const std::map<ReturnAddress, FrameRoots>* roots() { return &roots_; }
+  // The roots of the safepoint at |ra|, as ranges of the pools.
+  struct Safepoint {
+    ReturnAddress ra;
+    uint32_t reg_roots_begin;
+    uint32_t num_reg_roots;
+    uint32_t stack_roots_begin;
+    uint32_t num_stack_roots;
+  };
+
+  // |safepoints| may be in any order. If there are several for a return
+  // address, the first is used.
+  SafepointTable(std::vector<Safepoint> safepoints,
+                 std::vector<DWARF> reg_root_pool,
+                 std::vector<RBPOffset> stack_root_pool);
+
+  // Returns the roots of the safepoint at |ra|, or empty roots if there is no
+  // safepoint at |ra|.
+  FrameRoots Find(ReturnAddress ra) const;
+
+  size_t size() const { return addresses_.size(); }
 
   void Print() const;
 
  private:
-  const std::map<ReturnAddress, FrameRoots> roots_;
+  FrameRoots GetRoots(const Safepoint& safepoint) const;
+
+  // Sorted, and parallel to |safepoints_|. These are apart so that the binary
+  // search touches as few cache lines as possible.
+  std::vector<ReturnAddress> addresses_;
+  std::vector<Safepoint> safepoints_;
+  std::vector<DWARF> reg_root_pool_;
+  std::vector<RBPOffset> stack_root_pool_;
 };
 
 SafepointTable GenSafepointTable();
@@ -176,6 +245,9 @@ extern "C" void StackWalkAndMoveObjects(FramePtr fp);
 // experiment, a HeapObject's contents is simply a 64 bit integer. The data
 // itself is not important, what is, however, is that it can be accessed through
 // the rootset after the collector moves it.
-Handle<HeapObject> AllocateHeapObject(HeapAddress data);
+//
+// If fromspace is full, this collects and tries again. This is safe because
+// the caller's live handles are in the stack map of its call to this function.
+Handle<HeapObject> AllocateHeapObject(long data);
 
 #endif  // TOOLS_CLANG_STACK_MAPS_GC_GC_API_H_
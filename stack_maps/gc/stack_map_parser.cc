@@ -6,9 +6,14 @@
 
 namespace stackmap {
 
-FrameRoots StackmapV3Parser::ParseFrame() {
-  std::vector<DWARF> reg_roots;
-  std::vector<RBPOffset> stack_roots;
+SafepointTable::Safepoint StackmapV3Parser::ParseFrame(
+    ReturnAddress ra,
+    std::vector<DWARF>* reg_root_pool,
+    std::vector<RBPOffset>* stack_root_pool) {
+  SafepointTable::Safepoint safepoint;
+  safepoint.ra = ra;
+  safepoint.reg_roots_begin = reg_root_pool->size();
+  safepoint.stack_roots_begin = stack_root_pool->size();
 
   auto* loc =
       ptr_offset<const StkMapLocation*>(cur_frame_, sizeof(StkMapRecordHeader));
@@ -35,10 +40,10 @@ FrameRoots StackmapV3Parser::ParseFrame() {
   for (uint16_t i = 0; i < gc_locs; i += 2) {
     switch (loc->kind) {
       case kRegister:
-        reg_roots.push_back(loc->reg_num);
+        reg_root_pool->push_back(loc->reg_num);
         break;
       case kIndirect:
-        stack_roots.push_back(loc->offset);
+        stack_root_pool->push_back(loc->offset);
         break;
       default:
         // Ignore
@@ -58,7 +63,11 @@ FrameRoots StackmapV3Parser::ParseFrame() {
   // LLVM V3 stackmap format requires padding here if we need to align to an 8
   // byte boundary.
   cur_frame_ = align_8(ptr_offset<const StkMapRecordHeader*>(liveouts, incr));
-  return FrameRoots(reg_roots, stack_roots);
+
+  safepoint.num_reg_roots = reg_root_pool->size() - safepoint.reg_roots_begin;
+  safepoint.num_stack_roots =
+      stack_root_pool->size() - safepoint.stack_roots_begin;
+  return safepoint;
 }
 
 SafepointTable StackmapV3Parser::Parse() {
@@ -77,19 +86,24 @@ SafepointTable StackmapV3Parser::Parse() {
 
   // For each function in the stack map, we iterate over the stack map record
   // list looking for its respective callsite, adding its entry to the table.
+  // The roots of all callsites are appended to the same pools.
   auto* fn = ptr_offset<const StkSizeRecord*>(cursor_, sizeof(StkMapHeader));
-  std::map<ReturnAddress, FrameRoots> roots;
+  std::vector<SafepointTable::Safepoint> safepoints;
+  std::vector<DWARF> reg_root_pool;
+  std::vector<RBPOffset> stack_root_pool;
+  safepoints.reserve(header->num_records);
   for (uint32_t i = 0; i < header->num_functions; i++) {
     for (uint32_t j = 0; j < fn->record_count; j++) {
       ReturnAddress key = fn->address + cur_frame_->return_addr;
-      auto frame_roots = ParseFrame();
-      if (!frame_roots.empty())
-        roots.insert({key, frame_roots});
+      auto safepoint = ParseFrame(key, &reg_root_pool, &stack_root_pool);
+      if (safepoint.num_reg_roots || safepoint.num_stack_roots)
+        safepoints.push_back(safepoint);
     }
     fn++;
   }
 
-  return SafepointTable(roots);
+  return SafepointTable(std::move(safepoints), std::move(reg_root_pool),
+                        std::move(stack_root_pool));
 }
 }  // namespace stackmap
 
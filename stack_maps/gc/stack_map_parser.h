@@ -146,10 +146,11 @@ class StackmapV3Parser {
     return reinterpret_cast<T*>(((uintptr_t)c + 7) & ~7);
   }
 
-  // Creates a FrameRoot entry for a callsite's stack map record. This jumps
-  // over and ignores a bunch of values in the stack map record that are not of
-  // interest to precise stack scanning in V8 / Blink. Stack map records make up
-  // the bulk of the .llvm_stackmap section. For reference, the format is shown
+  // Creates a safepoint for a callsite's stack map record, whose return
+  // address is |ra|, appending its roots to the pools. This jumps over and
+  // ignores a bunch of values in the stack map record that are not of interest
+  // to precise stack scanning in V8 / Blink. Stack map records make up the
+  // bulk of the .llvm_stackmap section. For reference, the format is shown
   // below:
   //    StkMapRecord[NumRecords] {
   //      uint64 : PatchPoint ID
@@ -172,7 +173,9 @@ class StackmapV3Parser {
   //        uint8  : Reserved
   //        uint8  : Size in Bytes
   //      }
-  FrameRoots ParseFrame();
+  SafepointTable::Safepoint ParseFrame(ReturnAddress ra,
+                                       std::vector<DWARF>* reg_root_pool,
+                                       std::vector<RBPOffset>* stack_root_pool);
 };
 
 }  // namespace stackmap
@@ -0,0 +1,21 @@
+// Copyright 2026 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_CLANG_STACK_MAPS_GC_STATS_H_
+#define TOOLS_CLANG_STACK_MAPS_GC_STATS_H_
+
+#include <stdint.h>
+#include <vector>
+
+// Collector statistics, since InitGC() or the last ResetGCStats().
+struct GCStats {
+  uint64_t collections = 0;
+  uint64_t bytes_allocated = 0;
+  uint64_t objects_copied = 0;
+  uint64_t bytes_copied = 0;
+  // The duration of each collection, including the stack walk.
+  std::vector<uint64_t> pause_ns;
+};
+
+#endif  // TOOLS_CLANG_STACK_MAPS_GC_STATS_H_
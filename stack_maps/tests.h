@@ -5,10 +5,20 @@
 #ifndef TOOLS_CLANG_STACK_MAPS_TESTS_H_
 #define TOOLS_CLANG_STACK_MAPS_TESTS_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gc_stats.h"
+#include "objects.h"
+
 // Initialises the GC by setting up the heap and marking top of stack so the
 // gc knows where to stop during walking.
 extern void InitGC();
 
+// As above, with semispaces of |semispace_size| bytes rather than the default
+// size.
+extern void InitGC(size_t semispace_size);
+
 // Calls the collector, which will move the underlying heap objects and update
 // pointer values on the stack.
 extern "C" void GC();
@@ -16,4 +26,17 @@ extern "C" void GC();
 // Frees all heap memory
 extern void TeardownGC();
 
+// Allocates a chain of |length| HeapObjects holding |data|, each with a
+// reference to the next one, and returns the first. Only the first one is
+// reachable from the stack, so this exercises the collector's tracing of
+// references between objects.
+extern Handle<HeapObject> AllocateHeapObjectChain(long data, size_t length);
+
+// Whether the collector prints each frame and root it visits. On by default.
+extern void SetGCVerbose(bool verbose);
+
+// Collector statistics, since InitGC() or the last ResetGCStats().
+extern const GCStats& GetGCStats();
+extern void ResetGCStats();
+
 #endif  // TOOLS_CLANG_STACK_MAPS_TESTS_H_
@@ -7,32 +7,47 @@
 // source files which are necessary for compiling it are determined. For each
 // compilation unit, a file is created containing a list of all file paths of
 // included files.
+//
+// With --scan-deps-index, the includes of every compilation unit are instead
+// found with clang's dependency directives scanner, like clang-scan-deps does,
+// and written to a single binary index. See WriteScanDepsIndex() below.
 
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <stack>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/CompilerInvocation.h"
 #include "clang/Frontend/FrontendActions.h"
 #include "clang/Lex/HeaderSearchOptions.h"
 #include "clang/Lex/PPCallbacks.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Tooling/CommonOptionsParser.h"
 #include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/DependencyScanning/DependencyScanningService.h"
+#include "clang/Tooling/DependencyScanning/DependencyScanningTool.h"
 #include "clang/Tooling/Refactoring.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 
 using clang::HeaderSearchOptions;
 using clang::tooling::CommonOptionsParser;
@@ -279,19 +294,235 @@ void CompilationIndexerAction::EndSourceFileAction() {
     out << path << std::endl;
   }
 }
+
+// Returns |path| made absolute against |directory|, without "." and ".."
+// components.
+string AbsolutePath(llvm::StringRef path, llvm::StringRef directory) {
+  llvm::SmallString<256> absolute_path;
+  if (!llvm::sys::path::is_absolute(path))
+    absolute_path = directory;
+  llvm::sys::path::append(absolute_path, path);
+  llvm::sys::path::remove_dots(absolute_path, /*remove_dot_dot=*/true);
+  return string(absolute_path);
+}
+
+// Returns the prerequisites of the single rule in the Makefile dependency file
+// |text|, made absolute against |directory|.
+vector<string> ParseDependencyFile(llvm::StringRef text,
+                                   llvm::StringRef directory) {
+  // The rule's target is first. A plain ':' can be part of a Windows path, but
+  // the target is always followed by ": ".
+  size_t colon = text.find(": ");
+  if (colon == llvm::StringRef::npos)
+    return {};
+  text = text.drop_front(colon + 2);
+
+  vector<string> paths;
+  string path;
+  auto add_path = [&] {
+    if (path.empty())
+      return;
+    paths.push_back(AbsolutePath(path, directory));
+    path.clear();
+  };
+  for (size_t i = 0; i < text.size(); ++i) {
+    char c = text[i];
+    if (c == '\\' && i + 1 < text.size() &&
+        (text[i + 1] == ' ' || text[i + 1] == '#')) {
+      path += text[++i];
+    } else if (c == '\\' && i + 1 < text.size() &&
+               (text[i + 1] == '\n' || text[i + 1] == '\r')) {
+      // Line continuation.
+      add_path();
+    } else if (c == '$' && i + 1 < text.size() && text[i + 1] == '$') {
+      path += text[++i];
+    } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+      add_path();
+    } else {
+      path += c;
+    }
+  }
+  add_path();
+  return paths;
+}
+
+// Finds the files read by each of |commands| with clang's dependency
+// directives scanner. The scanner only lexes the preprocessor directives of
+// each file, and it minimizes each file and caches its stat() results once for
+// all of the commands. This is much faster than preprocessing every
+// compilation unit in full, but does not keep the spelling of the include
+// paths, so the output cannot be used to replay the compilation.
+//
+// The index is written to |index_path| in the following format, with all
+// integers 32-bit little-endian:
+//     "TUINDEX1"
+//     <number of paths> <number of compilation units>
+//     for each path, in sorted order: <length> <bytes>
+//     for each compilation unit: <path index of the source file>
+//         <number of ranges> <first path index> <path count> ...
+// The files read by a compilation unit are given as ranges of the path table.
+// Sorting the paths keeps the headers of a directory together, so a
+// compilation unit that includes most of them only needs a few ranges.
+int WriteScanDepsIndex(
+    const vector<clang::tooling::CompileCommand>& commands,
+    const string& resource_dir_arg,
+    const string& index_path,
+    unsigned jobs) {
+  using clang::tooling::dependencies::DependencyScanningService;
+  using clang::tooling::dependencies::DependencyScanningTool;
+  using clang::tooling::dependencies::ScanningMode;
+  using clang::tooling::dependencies::ScanningOutputFormat;
+
+  // Shared by all of the workers.
+  DependencyScanningService service(ScanningMode::DependencyDirectivesScan,
+                                    ScanningOutputFormat::Make);
+  vector<vector<string>> files(commands.size());
+  std::atomic<size_t> next_command{0};
+  std::atomic<unsigned> num_failed{0};
+  std::mutex errors_mutex;
+  auto worker = [&] {
+    DependencyScanningTool tool(service);
+    for (size_t i = next_command++; i < commands.size(); i = next_command++) {
+      const clang::tooling::CompileCommand& command = commands[i];
+      vector<string> command_line = command.CommandLine;
+      if (std::none_of(command_line.begin(), command_line.end(),
+                       [](const string& arg) {
+                         return llvm::StringRef(arg).starts_with(
+                             "-resource-dir");
+                       })) {
+        command_line.insert(command_line.begin() + 1, resource_dir_arg);
+      }
+      llvm::Expected<string> dependency_file =
+          tool.getDependencyFile(command_line, command.Directory);
+      if (!dependency_file) {
+        std::lock_guard<std::mutex> lock(errors_mutex);
+        llvm::errs() << "Failed to scan " << command.Filename << ": "
+                     << llvm::toString(dependency_file.takeError()) << "\n";
+        ++num_failed;
+        continue;
+      }
+      files[i] = ParseDependencyFile(*dependency_file, command.Directory);
+    }
+  };
+  vector<std::thread> threads;
+  for (unsigned i = 1; i < std::min<size_t>(jobs, commands.size()); ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  vector<string> sources;
+  std::map<string, uint32_t> path_indices;
+  for (size_t i = 0; i < commands.size(); ++i) {
+    sources.push_back(
+        AbsolutePath(commands[i].Filename, commands[i].Directory));
+    path_indices.emplace(sources.back(), 0);
+    for (const string& file : files[i]) {
+      path_indices.emplace(file, 0);
+    }
+  }
+  uint32_t next_index = 0;
+  for (auto& [path, index] : path_indices) {
+    index = next_index++;
+  }
+
+  std::error_code error;
+  llvm::raw_fd_ostream out(index_path, error);
+  if (error) {
+    llvm::errs() << "Cannot write " << index_path << ": " << error.message()
+                 << "\n";
+    return 1;
+  }
+  llvm::support::endian::Writer writer(out, llvm::endianness::little);
+  out << "TUINDEX1";
+  writer.write<uint32_t>(path_indices.size());
+  writer.write<uint32_t>(commands.size());
+  for (const auto& [path, index] : path_indices) {
+    writer.write<uint32_t>(path.size());
+    out << path;
+  }
+  for (size_t i = 0; i < commands.size(); ++i) {
+    writer.write<uint32_t>(path_indices.at(sources[i]));
+
+    vector<uint32_t> indices;
+    for (const string& file : files[i]) {
+      indices.push_back(path_indices.at(file));
+    }
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    vector<std::pair<uint32_t, uint32_t>> ranges;
+    for (uint32_t index : indices) {
+      if (!ranges.empty() &&
+          ranges.back().first + ranges.back().second == index) {
+        ++ranges.back().second;
+      } else {
+        ranges.emplace_back(index, 1);
+      }
+    }
+    writer.write<uint32_t>(ranges.size());
+    for (const auto& [first, count] : ranges) {
+      writer.write<uint32_t>(first);
+      writer.write<uint32_t>(count);
+    }
+  }
+
+  llvm::errs() << "Indexed " << commands.size() - num_failed << " of "
+               << commands.size() << " compilation units, "
+               << path_indices.size() << " files\n";
+  return num_failed ? 1 : 0;
+}
 }  // namespace
 
 static llvm::cl::extrahelp common_help(CommonOptionsParser::HelpMessage);
 
 int main(int argc, const char* argv[]) {
   llvm::cl::OptionCategory category("TranslationUnitGenerator Tool");
+  llvm::cl::opt<string> scan_deps_index(
+      "scan-deps-index", llvm::cl::value_desc("filepath"),
+      llvm::cl::desc("Find the files read by the given sources, or by every "
+                     "source in the compilation database if none is given, "
+                     "with the dependency directives scanner, and write them "
+                     "to this single binary index instead of a .filepaths "
+                     "file per source"),
+      llvm::cl::cat(category));
+  llvm::cl::opt<unsigned> jobs(
+      "jobs", llvm::cl::init(std::thread::hardware_concurrency()),
+      llvm::cl::desc("Number of threads for --scan-deps-index"),
+      llvm::cl::cat(category));
   auto ExpectedParser = CommonOptionsParser::create(
-      argc, argv, category, llvm::cl::OneOrMore, nullptr);
+      argc, argv, category, llvm::cl::ZeroOrMore, nullptr);
   if (!ExpectedParser) {
     llvm::errs() << ExpectedParser.takeError();
     return 1;
   }
   CommonOptionsParser& options = ExpectedParser.get();
+
+  if (!scan_deps_index.empty()) {
+    vector<clang::tooling::CompileCommand> commands;
+    if (options.getSourcePathList().empty()) {
+      commands = options.getCompilations().getAllCompileCommands();
+    }
+    for (const string& path : options.getSourcePathList()) {
+      vector<clang::tooling::CompileCommand> path_commands =
+          options.getCompilations().getCompileCommands(path);
+      commands.insert(commands.end(), path_commands.begin(),
+                      path_commands.end());
+    }
+    // Like ClangTool, use the builtin headers of the clang this tool was
+    // built with.
+    static int static_symbol;
+    string resource_dir_arg =
+        "-resource-dir=" +
+        clang::CompilerInvocation::GetResourcesPath(argv[0], &static_symbol);
+    return WriteScanDepsIndex(commands, resource_dir_arg, scan_deps_index,
+                              std::max(1u, jobs.getValue()));
+  }
+  if (options.getSourcePathList().empty()) {
+    llvm::errs() << "No source files given\n";
+    return 1;
+  }
   std::unique_ptr<clang::tooling::FrontendActionFactory> frontend_factory =
       clang::tooling::newFrontendActionFactory<CompilationIndexerAction>();
   clang::tooling::ClangTool tool(options.getCompilations(),
@@ -16,6 +16,12 @@ import os.path
 import subprocess
 import sys
 
+sys.path.insert(
+    0,
+    os.path.join(os.path.dirname(os.path.dirname(os.path.realpath(__file__))),
+                 'pylib'))
+from clang import include_index
+
 
 def _GenerateCompileCommands(template_path, test_files_dir):
   """Returns a JSON string containing a compilation database for the input."""
@@ -95,10 +101,41 @@ def main():
     passed += 1
     os.remove(actual)
 
+  # The dependency directives scanner must find the same files, although it
+  # may add system and builtin headers.
+  scan_deps_index = os.path.join(test_directory_for_tool, 'scan_deps_index')
+  print('[ RUN      ] %s' % os.path.relpath(scan_deps_index))
+  translation_unit = os.path.join(tools_clang_directory, '..', '..',
+                                  'third_party', 'llvm-build',
+                                  'Release+Asserts', 'bin', 'translation_unit')
+  subprocess.check_call([
+      translation_unit, '-p', test_directory_for_tool,
+      '--scan-deps-index=%s' % scan_deps_index
+  ] + source_files)
+  includes = include_index.ReadScanDepsIndex(scan_deps_index)
+  scan_deps_failed = False
+  for source in source_files:
+    with open(source + '.filepaths.expected', 'r') as f:
+      expected_basenames = set(ntpath.basename(line.strip()) for line in f)
+    actual_basenames = set(
+        ntpath.basename(path) for path in includes.get(source, ()))
+    missing = expected_basenames - actual_basenames
+    if missing:
+      sys.stdout.write('%s: missing %s\n' %
+                       (os.path.relpath(source), ', '.join(sorted(missing))))
+      scan_deps_failed = True
+  if scan_deps_failed:
+    failed += 1
+    print('[  FAILED  ] %s' % os.path.relpath(scan_deps_index))
+  else:
+    passed += 1
+    print('[       OK ] %s' % os.path.relpath(scan_deps_index))
+    os.remove(scan_deps_index)
+
   if failed == 0:
     os.remove(compile_database)
 
-  print('[==========] %s ran.' % _NumberOfTestsToString(len(source_files)))
+  print('[==========] %s ran.' % _NumberOfTestsToString(passed + failed))
   if passed > 0:
     print('[  PASSED  ] %s.' % _NumberOfTestsToString(passed))
   if failed > 0:
@@ -20,6 +20,8 @@
 #include <unordered_map>
 #include <vector>
 
+#include "PrefixHeaderPch.h"
+
 using namespace clang;
 using namespace clang::tooling;
 using namespace clang::ast_matchers;
@@ -29,6 +31,8 @@ using namespace clang::ast_matchers;
 static llvm::cl::OptionCategory my_tool_category(
     "Handle migration tool options");
 static llvm::cl::extrahelp common_help(CommonOptionsParser::HelpMessage);
+static raw_ptr_plugin::PrefixHeaderPch::Options prefix_header_options(
+    my_tool_category);
 
 constexpr int kVerboseNone = 0;
 constexpr int kVerboseReportInterestingHandleUse = 1;
@@ -892,6 +896,11 @@ int main(int argc, const char* argv[]) {
   CommonOptionsParser& options_parser = expected_parser.get();
   ClangTool Tool(options_parser.getCompilations(),
                  options_parser.getSourcePathList());
+  std::unique_ptr<raw_ptr_plugin::PrefixHeaderPch> prefix_header_pch =
+      raw_ptr_plugin::PrefixHeaderPch::Create(prefix_header_options);
+  if (prefix_header_pch) {
+    Tool.appendArgumentsAdjuster(prefix_header_pch->GetArgumentsAdjuster());
+  }
 
   MatchFinder finder;
   std::optional<WhereWeAreVisitor> where_we_are_visitor;